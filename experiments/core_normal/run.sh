@@ -0,0 +1,57 @@
+#!/bin/sh
+# Measure the normal core in MIPS: run BENCH.COM and EMPTY.COM headless in
+# fast forward mode and divide the instruction count by the time difference.
+#
+#   ./run.sh [path/to/dosbox-x ...]
+#
+# Each binary is run RUNS times (default 3), the fastest run counts.
+
+ITER=20000000
+INSNS=21
+RUNS=${RUNS:-3}
+DIR=$(cd "$(dirname "$0")" && pwd)
+
+[ $# -eq 0 ] && set -- ../../src/dosbox-x
+[ -f "$DIR/BENCH.COM" ] || make -C "$DIR" >/dev/null || exit 1
+
+CONF=$(mktemp)
+cat > "$CONF" <<CONFEOF
+[sdl]
+output=none
+[dosbox]
+captures=/tmp
+[cpu]
+core=normal
+cputype=pentium
+cycles=fixed 1000000
+[mixer]
+nosound=true
+[sblaster]
+sbtype=none
+[gus]
+gus=false
+CONFEOF
+
+# best wall clock time in seconds of running one program
+best() {
+	b=""
+	i=0
+	while [ $i -lt $RUNS ]; do
+		t0=$(date +%s.%N)
+		SDL_AUDIODRIVER=dummy "$1" -conf "$CONF" -fastforward \
+			-c "mount c \"$DIR\"" -c "c:" -c "$2" -c exit >/dev/null 2>&1
+		t1=$(date +%s.%N)
+		b=$(echo "$t0 $t1 $b" | awk '{ t = $2 - $1; if ($3 == "" || t < $3) print t; else print $3 }')
+		i=$((i+1))
+	done
+	echo "$b"
+}
+
+for bin in "$@"; do
+	e=$(best "$bin" EMPTY.COM)
+	t=$(best "$bin" BENCH.COM)
+	echo "$t $e $bin" | awk -v n=$ITER -v k=$INSNS \
+		'{ printf "%-40s %7.1f MIPS (%.2f s for %d M instructions)\n", $3, n * k / ($1 - $2) / 1e6, $1 - $2, n * k / 1e6 }'
+done
+
+rm -f "$CONF"
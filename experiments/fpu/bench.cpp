@@ -0,0 +1,326 @@
+// Software 80-bit FPU (src/fpu/fpu_soft80.h) test and benchmark.
+//
+// On x86 hosts every operation is first checked bit for bit against the
+// host x87 for random operands of all classes (full 64-bit significands,
+// double and single precision values, integers, denormals, huge and tiny
+// exponents, zeros, infinities and NaNs), in every precision and rounding
+// control setting. Then the speed of a vertex transform (FLD m32, FMUL,
+// FADD, FSTP m32) is measured with host double, host long double, soft80
+// and soft80 without the double fast path.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+#include "fpu_soft80.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+# define HAVE_X87 1
+# include <fpu_control.h>
+#endif
+
+static uint64_t lfsr = 0x0123456789ABCDEFull;
+
+static uint64_t rnd(void) {
+	lfsr ^= lfsr << 13;
+	lfsr ^= lfsr >> 7;
+	lfsr ^= lfsr << 17;
+	return lfsr;
+}
+
+static FPU_Soft80 random_value(void) {
+	const unsigned int sign = (unsigned int)(rnd() & 1);
+	const unsigned int kind = (unsigned int)(rnd() % 12);
+	uint64_t m = rnd() | SOFT80_INT_BIT;
+	unsigned int exp = SOFT80_BIAS - 40 + (unsigned int)(rnd() % 80);
+
+	switch (kind) {
+		case 0: case 1:	break;								// full precision
+		case 2:		m &= ~(uint64_t)0x7FF; break;					// double
+		case 3:		m &= ~(uint64_t)0xFFFFFFFFFF; break;				// single
+		case 4:		m &= ~(((uint64_t)1 << (rnd() % 64)) - 1); break;		// short significand
+		case 5:		return Soft80_FromI64((int64_t)(rnd() % 2001) - 1000);		// integer
+		case 6:		exp = 0; m >>= 1 + rnd() % 63; break;				// denormal
+		case 7:		exp = 1 + (unsigned int)(rnd() % 80); break;			// tiny
+		case 8:		exp = SOFT80_EXP_MAX - 1 - (unsigned int)(rnd() % 80); break;	// huge
+		case 9:		exp = (rnd() & 1) ? SOFT80_BIAS + 1000 + (unsigned int)(rnd() % 15000) :
+					SOFT80_BIAS - 1000 - (unsigned int)(rnd() % 15000); break;
+		case 10:	return (rnd() & 1) ? Soft80_Zero(sign) : Soft80_Inf(sign);
+		default:	// NaN, quiet or signaling
+				if (rnd() % 4) return Soft80_Make(sign,0,0);
+				m = SOFT80_INT_BIT | (rnd() >> 2) | ((rnd() & 1) ? SOFT80_QUIET_BIT : 0);
+				if ((m << 1) == 0) m |= 1;
+				exp = SOFT80_EXP_MAX;
+				break;
+	}
+	return Soft80_Make(sign,exp,m);
+}
+
+/* second operand, often close to the first to exercise cancellation and exact results */
+static FPU_Soft80 random_near(const FPU_Soft80 &a) {
+	FPU_Soft80 b = random_value();
+	const unsigned int e = a.se & SOFT80_EXP_MAX;
+	if ((rnd() & 1) && e > 64 && e < SOFT80_EXP_MAX - 64 && (b.se & SOFT80_EXP_MAX) != 0 && (b.se & SOFT80_EXP_MAX) != SOFT80_EXP_MAX)
+		b.se = (uint16_t)((b.se & 0x8000) | (e - 2 + (unsigned int)(rnd() % 5)));
+	if (rnd() % 8 == 0) b.m = a.m ^ (rnd() & 0xFF);
+	return b;
+}
+
+#if HAVE_X87
+typedef long double ld;
+
+static ld to_ld(const FPU_Soft80 &a) {
+	ld r = 0;
+	memcpy(&r,&a.m,8);
+	memcpy((char*)&r + 8,&a.se,2);
+	return r;
+}
+
+static FPU_Soft80 from_ld(ld v) {
+	FPU_Soft80 r;
+	memcpy(&r.m,&v,8);
+	memcpy(&r.se,(char*)&v + 8,2);
+	return r;
+}
+
+static void set_cw(unsigned int pc,unsigned int rc) {
+	const unsigned short pcf = (pc == 24) ? 0 : (pc == 53) ? 2 : 3;
+	fpu_control_t cw = (fpu_control_t)(0x37F & ~0xF00) | (fpu_control_t)(pcf << 8) | (fpu_control_t)(rc << 10);
+	_FPU_SETCW(cw);
+}
+
+__attribute__((noinline)) static ld x87_add(ld a,ld b) { return a + b; }
+__attribute__((noinline)) static ld x87_sub(ld a,ld b) { return a - b; }
+__attribute__((noinline)) static ld x87_mul(ld a,ld b) { return a * b; }
+__attribute__((noinline)) static ld x87_div(ld a,ld b) { return a / b; }
+__attribute__((noinline)) static ld x87_sqrt(ld a) { ld r; __asm__ ("fsqrt" : "=t"(r) : "0"(a)); return r; }
+__attribute__((noinline)) static ld x87_rndint(ld a) { ld r; __asm__ ("frndint" : "=t"(r) : "0"(a)); return r; }
+__attribute__((noinline)) static ld x87_scale(ld a,ld b) { ld r; __asm__ ("fscale" : "=t"(r) : "0"(a), "u"(b)); return r; }
+__attribute__((noinline)) static ld x87_prem(ld a,ld b,bool one,unsigned short &sw) {
+	ld r;
+	if (one) __asm__ ("fprem1\n\tfnstsw %1" : "=t"(r), "=a"(sw) : "0"(a), "u"(b));
+	else __asm__ ("fprem\n\tfnstsw %1" : "=t"(r), "=a"(sw) : "0"(a), "u"(b));
+	return r;
+}
+__attribute__((noinline)) static uint32_t x87_f32(ld a) { float f = (float)a; uint32_t r; memcpy(&r,&f,4); return r; }
+__attribute__((noinline)) static uint64_t x87_f64(ld a) { double d = (double)a; uint64_t r; memcpy(&r,&d,8); return r; }
+__attribute__((noinline)) static int64_t x87_i64(ld a) { int64_t r; __asm__ ("fistpll %0" : "=m"(r) : "t"(a) : "st"); return r; }
+__attribute__((noinline)) static int32_t x87_i32(ld a) { int32_t r; __asm__ ("fistpl %0" : "=m"(r) : "t"(a) : "st"); return r; }
+__attribute__((noinline)) static int16_t x87_i16(ld a) { int16_t r; __asm__ ("fistps %0" : "=m"(r) : "t"(a) : "st"); return r; }
+__attribute__((noinline)) static int x87_cmp(ld a,ld b) {
+	unsigned short sw;
+	__asm__ ("fucom %%st(1)\n\tfnstsw %0" : "=a"(sw) : "t"(a), "u"(b));
+	switch (sw & 0x4500) {
+		case 0x0000: return 1;
+		case 0x0100: return -1;
+		case 0x4000: return 0;
+		default: return 2;
+	}
+}
+
+static const char *op_names[] = { "add", "sub", "mul", "div", "sqrt", "frndint", "fscale", "fprem", "fprem1", "fst m32", "fst m64", "fist m64", "fist m32", "fist m16", "fucom", "fld m32", "fld m64" };
+#define OPS (sizeof(op_names) / sizeof(op_names[0]))
+
+static bool same(const FPU_Soft80 &a,const FPU_Soft80 &b) {
+	return a.m == b.m && a.se == b.se;
+}
+
+static unsigned long check(unsigned long iterations) {
+	unsigned long fails[OPS] = { 0 };
+	unsigned long total = 0;
+	static const unsigned int pcs[3] = { 24, 53, 64 };
+
+	for (unsigned long it = 0;it < iterations;it++) {
+		const FPU_Soft80 a = random_value();
+		const FPU_Soft80 b = random_near(a);
+		const unsigned int pc = pcs[it % 3];
+		const unsigned int rc = (unsigned int)((it / 3) % 4);
+		const ld la = to_ld(a), lb = to_ld(b);
+
+		set_cw(pc,rc);
+		for (unsigned int op = 0;op < OPS;op++) {
+			bool ok = true;
+			FPU_Soft80 s = Soft80_Zero(0), h = Soft80_Zero(0);
+			unsigned short sw = 0;
+			switch (op) {
+				case 0: s = Soft80_Add(a,b,false,pc,rc); h = from_ld(x87_add(la,lb)); ok = same(s,h); break;
+				case 1: s = Soft80_Add(a,b,true,pc,rc); h = from_ld(x87_sub(la,lb)); ok = same(s,h); break;
+				case 2: s = Soft80_Mul(a,b,pc,rc); h = from_ld(x87_mul(la,lb)); ok = same(s,h); break;
+				case 3: s = Soft80_Div(a,b,pc,rc); h = from_ld(x87_div(la,lb)); ok = same(s,h); break;
+				case 4: s = Soft80_Sqrt(a,pc,rc); h = from_ld(x87_sqrt(la)); ok = same(s,h); break;
+				case 5: s = Soft80_RoundInt(a,rc); h = from_ld(x87_rndint(la)); ok = same(s,h); break;
+				case 6: {
+					/* keep the scale in a sensible range, huge ones take the x87 ages */
+					const FPU_Soft80 sc = Soft80_FromI64((int64_t)(rnd() % 200) - 100);
+					s = Soft80_Scale(a,sc,rc); h = from_ld(x87_scale(la,to_ld(sc))); ok = same(s,h);
+					break;
+				}
+				case 7: case 8: {
+					unsigned int q;
+					bool complete;
+					s = Soft80_Remainder(a,b,op == 8,q,complete);
+					h = from_ld(x87_prem(la,lb,op == 8,sw));
+					ok = same(s,h) && complete == !(sw & 0x400);
+					/* NaN results leave C0, C1 and C3 as they were */
+					if (ok && !Soft80_IsNaN(s))
+						ok = q == (unsigned int)(((sw >> 8) & 1) << 2 | ((sw >> 14) & 1) << 1 | ((sw >> 9) & 1));
+					break;
+				}
+				case 9: ok = Soft80_ToF32(a,rc) == x87_f32(la); break;
+				case 10: ok = Soft80_ToF64(a,rc) == x87_f64(la); break;
+				case 11: ok = Soft80_ToInt(a,64,rc) == x87_i64(la); break;
+				case 12: ok = Soft80_ToInt(a,32,rc) == x87_i32(la); break;
+				case 13: ok = Soft80_ToInt(a,16,rc) == x87_i16(la); break;
+				case 14: ok = Soft80_Compare(a,b) == x87_cmp(la,lb); break;
+				case 15: {
+					const uint32_t f = (uint32_t)rnd();
+					float v;
+					memcpy(&v,&f,4);
+					ok = same(Soft80_FromF32(f),from_ld((ld)v));
+					break;
+				}
+				default: {
+					const uint64_t d = rnd();
+					double v;
+					memcpy(&v,&d,8);
+					ok = same(Soft80_FromF64(d),from_ld((ld)v));
+					break;
+				}
+			}
+			if (!ok) {
+				if (fails[op]++ < 3) {
+					printf("  %s pc=%u rc=%u a=%04x:%016llx b=%04x:%016llx soft=%04x:%016llx x87=%04x:%016llx\n",
+						op_names[op],pc,rc,a.se,(unsigned long long)a.m,b.se,(unsigned long long)b.m,
+						s.se,(unsigned long long)s.m,h.se,(unsigned long long)h.m);
+				}
+				total++;
+			}
+		}
+	}
+	set_cw(64,0);
+
+	for (unsigned int op = 0;op < OPS;op++)
+		printf("%-10s %s (%lu of %lu differ)\n",op_names[op],fails[op] ? "DIFFERENT" : "identical",fails[op],iterations);
+	return total;
+}
+#endif
+
+/* Vertex transform with single precision data, what a DOS 3D engine does with the FPU:
+ * per vertex 3 x (FLD m32, 3 x FMUL m32, 3 x FADD) and FSTP m32. */
+static const unsigned int vertices = 4096;
+static const unsigned int rounds = 200;
+
+struct Scene {
+	std::vector<float> in, out;
+	float m[12];
+};
+
+static void make_scene(Scene &s) {
+	s.in.resize(vertices * 3);
+	s.out.resize(vertices * 3);
+	for (unsigned int i = 0;i < vertices * 3;i++) s.in[i] = (float)((int)(rnd() % 20001) - 10000) / 37.0f;
+	for (unsigned int i = 0;i < 12;i++) s.m[i] = (float)((int)(rnd() % 2001) - 1000) / 999.0f;
+}
+
+static double run_double(Scene &s) {
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (unsigned int r = 0;r < rounds;r++) {
+		for (unsigned int v = 0;v < vertices;v++) {
+			const double x = s.in[v*3], y = s.in[v*3+1], z = s.in[v*3+2];
+			for (unsigned int k = 0;k < 3;k++)
+				s.out[v*3+k] = (float)(((x * s.m[k*4] + y * s.m[k*4+1]) + z * s.m[k*4+2]) + s.m[k*4+3]);
+		}
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+#if HAVE_X87
+static double run_longdouble(Scene &s,unsigned int pc) {
+	set_cw(pc,0);
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (unsigned int r = 0;r < rounds;r++) {
+		for (unsigned int v = 0;v < vertices;v++) {
+			const ld x = s.in[v*3], y = s.in[v*3+1], z = s.in[v*3+2];
+			for (unsigned int k = 0;k < 3;k++)
+				s.out[v*3+k] = (float)(((x * s.m[k*4] + y * s.m[k*4+1]) + z * s.m[k*4+2]) + s.m[k*4+3]);
+		}
+	}
+	const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	set_cw(64,0);
+	return t;
+}
+#endif
+
+static inline FPU_Soft80 ld32(const float &f) {
+	uint32_t bits;
+	memcpy(&bits,&f,4);
+	return Soft80_FromF32(bits);
+}
+
+static double run_soft80(Scene &s,unsigned int pc,bool fast,std::vector<uint32_t> &out) {
+	out.resize(vertices * 3);
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (unsigned int r = 0;r < rounds;r++) {
+		for (unsigned int v = 0;v < vertices;v++) {
+			const FPU_Soft80 x = ld32(s.in[v*3]), y = ld32(s.in[v*3+1]), z = ld32(s.in[v*3+2]);
+			for (unsigned int k = 0;k < 3;k++) {
+				FPU_Soft80 a;
+				if (fast) {
+					a = Soft80_Mul(x,ld32(s.m[k*4]),pc,0);
+					a = Soft80_Add(a,Soft80_Mul(y,ld32(s.m[k*4+1]),pc,0),false,pc,0);
+					a = Soft80_Add(a,Soft80_Mul(z,ld32(s.m[k*4+2]),pc,0),false,pc,0);
+					a = Soft80_Add(a,ld32(s.m[k*4+3]),false,pc,0);
+				}
+				else {
+					a = Soft80_MulSlow(x,ld32(s.m[k*4]),pc,0);
+					a = Soft80_AddSlow(a,Soft80_MulSlow(y,ld32(s.m[k*4+1]),pc,0),false,pc,0);
+					a = Soft80_AddSlow(a,Soft80_MulSlow(z,ld32(s.m[k*4+2]),pc,0),false,pc,0);
+					a = Soft80_AddSlow(a,ld32(s.m[k*4+3]),false,pc,0);
+				}
+				out[v*3+k] = Soft80_ToF32(a,0);
+			}
+		}
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc,char **argv) {
+	const unsigned long iterations = (argc > 1) ? strtoul(argv[1],NULL,0) : 200000;
+	int fail = 0;
+
+#if HAVE_X87
+	printf("soft80 against the host x87, %lu random operand pairs per operation:\n",iterations);
+	if (check(iterations) != 0) fail = 1;
+	printf("\n");
+#else
+	(void)iterations;
+	printf("no x87 on this host, skipping the comparison\n\n");
+#endif
+
+	Scene s;
+	make_scene(s);
+	const double ops = (double)vertices * rounds * 3 * 8;	/* 8 FPU operations per output */
+
+	printf("vertex transform, million FPU operations per second:\n");
+	const double td = run_double(s);
+	printf("%-30s %8.1f\n","host double",ops / td / 1e6);
+	static const unsigned int pcs[3] = { 64, 53, 24 };
+	for (unsigned int i = 0;i < 3;i++) {
+		std::vector<uint32_t> fast_out, slow_out;
+		char name[64];
+#if HAVE_X87
+		sprintf(name,"host x87 long double, pc=%u",pcs[i]);
+		printf("%-30s %8.1f\n",name,ops / run_longdouble(s,pcs[i]) / 1e6);
+#endif
+		const double tf = run_soft80(s,pcs[i],true,fast_out);
+		const double ts = run_soft80(s,pcs[i],false,slow_out);
+		sprintf(name,"soft80, pc=%u",pcs[i]);
+		printf("%-30s %8.1f\n",name,ops / tf / 1e6);
+		sprintf(name,"soft80 without fast path, pc=%u",pcs[i]);
+		printf("%-30s %8.1f  %s\n",name,ops / ts / 1e6,(fast_out == slow_out) ? "same output" : "DIFFERENT output");
+		if (fast_out != slow_out) fail = 1;
+	}
+	return fail;
+}
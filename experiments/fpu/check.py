@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Run CHECK.COM (check.S) under two or more dosbox-x binaries and compare
+# what their FPU cores wrote, field by field. The first binary is the
+# reference, normally one built with the x86 assembly FPU core, which runs
+# every instruction on the host x87.
+#
+#   ./check.py path/to/reference/dosbox-x path/to/other/dosbox-x ...
+#
+# The exception flags (status word bits 0-7) are not compared, only the asm
+# core emulates them. Invalid operations leave stale condition codes that
+# depend on the host, the remaining status word differences are listed
+# separately and are expected there.
+
+import os, subprocess, sys, tempfile
+
+DIR = os.path.dirname(os.path.abspath(__file__))
+NVALS = 20
+REC = 166
+FIELDS = [(0, 10, 'add'), (10, 10, 'sub'), (20, 10, 'mul'), (30, 10, 'div'), (40, 10, 'subr'),
+          (50, 10, 'divr'), (60, 10, 'fprem'), (70, 10, 'fprem1'), (80, 2, 'fprem sw'),
+          (82, 2, 'fprem1 sw'), (84, 2, 'fcom sw'), (88, 10, 'fsqrt'), (98, 10, 'frndint'),
+          (108, 2, 'fxam sw'), (110, 4, 'fst m32'), (114, 8, 'fst m64'), (122, 8, 'fist m64'),
+          (130, 4, 'fist m32'), (134, 2, 'fist m16'), (136, 10, 'fbstp'),
+          (146, 10, 'fxtract sig'), (156, 10, 'fxtract exp')]
+CONF = """[sdl]
+output=none
+[cpu]
+core=normal
+cputype=pentium
+cycles=max
+[mixer]
+nosound=true
+"""
+
+def run(binary, work):
+    out = os.path.join(work, 'OUT.BIN')
+    if os.path.exists(out):
+        os.remove(out)
+    conf = os.path.join(work, 'check.conf')
+    with open(conf, 'w') as f:
+        f.write(CONF)
+    subprocess.run([binary, '-conf', conf, '-c', 'mount c "%s"' % work, '-c', 'c:', '-c', 'CHECK.COM', '-c', 'exit'],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, env=dict(os.environ, SDL_AUDIODRIVER='dummy'))
+    with open(out, 'rb') as f:
+        return f.read()
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: check.py reference-dosbox-x other-dosbox-x ...')
+    if subprocess.run(['make', '-s', '-C', DIR, 'CHECK.COM']).returncode != 0:
+        sys.exit(1)
+    failed = False
+    with tempfile.TemporaryDirectory() as work:
+        with open(os.path.join(DIR, 'CHECK.COM'), 'rb') as src, open(os.path.join(work, 'CHECK.COM'), 'wb') as dst:
+            dst.write(src.read())
+        ref = run(sys.argv[1], work)
+        for binary in sys.argv[2:]:
+            data = run(binary, work)
+            if len(data) != len(ref):
+                print('%s: wrote %d bytes, the reference %d' % (binary, len(data), len(ref)))
+                failed = True
+                continue
+            values, status = {}, {}
+            for r in range(len(ref) // REC):
+                for off, size, name in FIELDS:
+                    x = ref[r * REC + off:r * REC + off + size]
+                    y = data[r * REC + off:r * REC + off + size]
+                    if name.endswith(' sw'):
+                        x, y = x[1:], y[1:]
+                    if x != y:
+                        d = status if name.endswith(' sw') else values
+                        d.setdefault(name, []).append((r // (NVALS * NVALS), r // NVALS % NVALS, r % NVALS,
+                                                      x[::-1].hex(), y[::-1].hex()))
+            print('%s: %d value fields differ, %d condition code fields differ' %
+                  (binary, sum(len(v) for v in values.values()), sum(len(v) for v in status.values())))
+            for d in (values, status):
+                for name, diffs in d.items():
+                    print('  %-12s %d' % (name, len(diffs)))
+                    for cw, a, b, x, y in diffs[:3]:
+                        print('    pc=%d rc=%d a=%d b=%d reference=%s got=%s' % ((cw >> 2) & 3, cw & 3, a, b, x, y))
+            failed = failed or bool(values)
+    sys.exit(1 if failed else 0)
+
+main()
@@ -0,0 +1,61 @@
+#!/bin/sh
+# Measure the FPU core of one or more dosbox-x binaries: run FPU64.COM,
+# FPU53.COM and FPU24.COM (the same vertex transform at each precision
+# control setting) and EMPTY.COM headless in fast forward mode, and print
+# million emulated FPU instructions per second.
+#
+#   ./run.sh [path/to/dosbox-x ...]
+#
+# Each program is run RUNS times (default 3), the fastest run counts.
+
+ITER=2000000
+INSNS=10
+RUNS=${RUNS:-3}
+DIR=$(cd "$(dirname "$0")" && pwd)
+
+[ $# -eq 0 ] && set -- ../../src/dosbox-x
+[ -f "$DIR/FPU64.COM" ] || make -C "$DIR" FPU64.COM FPU53.COM FPU24.COM EMPTY.COM >/dev/null || exit 1
+
+CONF=$(mktemp)
+cat > "$CONF" <<CONFEOF
+[sdl]
+output=none
+[dosbox]
+captures=/tmp
+[cpu]
+core=normal
+cputype=pentium
+cycles=fixed 1000000
+[mixer]
+nosound=true
+[sblaster]
+sbtype=none
+[gus]
+gus=false
+CONFEOF
+
+# best wall clock time in seconds of running one program
+best() {
+	b=""
+	i=0
+	while [ $i -lt $RUNS ]; do
+		t0=$(date +%s.%N)
+		SDL_AUDIODRIVER=dummy "$1" -conf "$CONF" -fastforward \
+			-c "mount c \"$DIR\"" -c "c:" -c "$2" -c exit >/dev/null 2>&1
+		t1=$(date +%s.%N)
+		b=$(echo "$t0 $t1 $b" | awk '{ t = $2 - $1; if ($3 == "" || t < $3) print t; else print $3 }')
+		i=$((i+1))
+	done
+	echo "$b"
+}
+
+for bin in "$@"; do
+	e=$(best "$bin" EMPTY.COM)
+	for pc in 64 53 24; do
+		t=$(best "$bin" FPU$pc.COM)
+		echo "$t $e $bin $pc" | awk -v n=$ITER -v k=$INSNS \
+			'{ printf "%-40s pc=%-2d %7.1f M FPU instructions/s (%.2f s)\n", $3, $4, n * k / ($1 - $2) / 1e6, $1 - $2 }'
+	done
+done
+
+rm -f "$CONF"
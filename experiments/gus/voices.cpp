@@ -0,0 +1,171 @@
+/* Equivalence test for the GUS voice renderer in src/hardware/gus.cpp.
+ *
+ * The Makefile extracts the voice code of gus.cpp twice, once as is and once
+ * with QuietFrames() bypassed, so that every frame goes through RenderFrame()
+ * (GetSample8/16(), WaveUpdate() and RampUpdate(), the per-frame renderer).
+ * Random voice setups are rendered by both and the mixed output, the voice
+ * registers and the IRQ flags compared, with GUS_MixBlock() running its SSE2
+ * and its plain C loop. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uintptr_t Bitu;
+typedef intptr_t Bits;
+
+#define INLINE inline
+#define LOG(a,b) if (0) printf
+#define LOG_MSG(...) do {} while (0)
+
+typedef int IO_Callout_t;
+#define IO_Callout_t_none 0
+class MixerChannel;
+
+static inline uint16_t host_readw(const uint8_t *p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool sse2_available = false;
+
+#include "../../src/hardware/gus_simd.h"
+
+/* ICS mixer GF1 output mapping, for read_GF1_mapping_control() */
+static uint8_t ics_map[2] = { 1, 2 };
+
+namespace Frame {
+#include "gus_frame.inc"
+static void CheckVoiceIrq(void) { }
+static inline uint8_t read_GF1_mapping_control(const unsigned int ch) { return ics_map[ch]; }
+}
+
+namespace Run {
+#include "gus_run.inc"
+static void CheckVoiceIrq(void) { }
+static inline uint8_t read_GF1_mapping_control(const unsigned int ch) { return ics_map[ch]; }
+}
+
+static uint32_t rng = 12345;
+static uint32_t Random(void) {
+	rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+	return rng;
+}
+
+#define MAXLEN 4096u
+
+/* the guest side of a voice setup, as GUS_WriteVoiceRegister() would apply it */
+struct Setup {
+	uint32_t start, end, addr;
+	uint16_t freq;
+	uint8_t wavectrl, ramprate, rampctrl, pan;
+	uint32_t rampstart, rampend, rampvol;
+};
+
+static Setup RandomSetup(void) {
+	Setup s;
+	s.start = ((Random() & 0x1fff) << 16) | (Random() & 0xffe0);
+	if (Random() % 4u) /* short loops, so that the end address is reached */
+		s.end = (s.start + (Random() % ((Random() % 2u) ? (64u << 9) : (8192u << 9)))) & 0x1fffffe0;
+	else
+		s.end = ((Random() & 0x1fff) << 16) | (Random() & 0xffe0);
+	switch (Random() % 4u) {
+		case 0:  s.addr = Random() & 0x1fffffff; break;
+		case 1:  s.addr = s.start + (Random() % 4096u) - 2048u; break;
+		case 2:  s.addr = s.end + (Random() % 4096u) - 2048u; break;
+		default: s.addr = s.start + ((s.end > s.start) ? (Random() % (s.end - s.start + 1u)) : 0u); break;
+	}
+	s.addr &= 0x1fffffff;
+	s.freq = (uint16_t)((Random() % 3u) ? (Random() % 0x1000u) : Random());
+	s.wavectrl = (uint8_t)(Random() & 0x7f);
+	if (Random() % 2u) s.wavectrl &= ~0x03; /* running */
+	s.rampctrl = (uint8_t)(Random() & 0x7f);
+	if (Random() % 2u) s.rampctrl &= ~0x03; /* ramping */
+	s.ramprate = (uint8_t)Random();
+	s.rampstart = (Random() & 0xff) << 14;
+	s.rampend = (Random() % 3u) ? (s.rampstart + ((Random() % 16u) << 14)) & (0xff << 14) : (Random() & 0xff) << 14;
+	s.rampvol = ((Random() & 0xffff) >> 4) << 10;
+	s.pan = (uint8_t)(Random() & 0xf);
+	return s;
+}
+
+template <class V> static void Apply(V &v, const Setup &s) {
+	v.WaveStart = s.start;
+	v.WaveEnd = s.end;
+	v.WaveAddr = s.addr;
+	v.WriteWaveFreq(s.freq);
+	v.WriteWaveCtrl(s.wavectrl);
+	v.RampStart = s.rampstart;
+	v.RampEnd = s.rampend;
+	v.RampVol = s.rampvol;
+	v.WriteRampRate(s.ramprate);
+	v.WriteRampCtrl(s.rampctrl);
+	v.WritePanPot(s.pan);
+}
+
+static bool SameVoice(const Frame::GUSChannels &a, const Run::GUSChannels &b) {
+	return a.WaveAddr == b.WaveAddr && a.WaveCtrl == b.WaveCtrl && a.RampVol == b.RampVol &&
+		a.RampCtrl == b.RampCtrl && a.VolLeft == b.VolLeft && a.VolRight == b.VolRight &&
+		Frame::myGUS.WaveIRQ == Run::myGUS.WaveIRQ && Frame::myGUS.RampIRQ == Run::myGUS.RampIRQ;
+}
+
+int main(int argc, char **argv) {
+	const unsigned int iterations = (argc > 1) ? (unsigned int)atoi(argv[1]) : 50000u;
+	static int32_t a[MAXLEN*2u], b[MAXLEN*2u];
+	unsigned long errors = 0, frames = 0;
+
+	for (unsigned int i=0;i < sizeof(Frame::GUSRam);i++)
+		Frame::GUSRam[i] = Run::GUSRam[i] = (uint8_t)Random();
+
+	for (unsigned int it=0;it < iterations;it++) {
+		/* both loops of GUS_MixBlock(), the tables of both pantable options, and
+		 * a GUS classic or a GUS MAX with fixed rate output and the ICS mixer */
+		sse2_available = (it & 1u) != 0;
+		Frame::gus_fixed_table = Run::gus_fixed_table = (it & 2u) != 0;
+		if ((it & 6u) == 0u) {
+			Frame::MakeTables();
+			Run::MakeTables();
+		}
+		const bool max = Random() % 2u;
+		Frame::myGUS.fixed_sample_rate_output = Run::myGUS.fixed_sample_rate_output = max;
+		/* 14 to 32 active voices */
+		Frame::myGUS.basefreq = Run::myGUS.basefreq = (uint32_t)(0.5 + 1000000.0 / (1.619695497 * (double)(14u + Random() % 19u)));
+		Frame::myGUS.rate = Run::myGUS.rate = 44100u + (Random() % 8u) * 1000u;
+		Frame::gus_ics_mixer = Run::gus_ics_mixer = max;
+		ics_map[0] = (uint8_t)(Random() & 3u);
+		ics_map[1] = (uint8_t)(Random() & 3u);
+		Frame::GUS_reset_reg = Run::GUS_reset_reg = (Random() % 16u) ? 0x03 : 0x01;
+		Frame::myGUS.WaveIRQ = Run::myGUS.WaveIRQ = 0;
+		Frame::myGUS.RampIRQ = Run::myGUS.RampIRQ = 0;
+
+		const uint8_t num = (uint8_t)(Random() % 32u);
+		Frame::GUSChannels fv(num);
+		Run::GUSChannels rv(num);
+		const Setup s = RandomSetup();
+		Apply(fv, s);
+		Apply(rv, s);
+
+		/* a few mixer callbacks in a row, the voice carries on between them */
+		const unsigned int calls = 1u + Random() % 4u;
+		for (unsigned int c=0;c < calls;c++) {
+			const uint32_t len = 1u + Random() % ((Random() % 2u) ? 64u : MAXLEN);
+			memset(a, 0, sizeof(a));
+			memset(b, 0, sizeof(b));
+			fv.generateSamples(a, len);
+			rv.generateSamples(b, len);
+			frames += len;
+
+			if (memcmp(a, b, sizeof(a)) != 0 || !SameVoice(fv, rv)) {
+				if (errors < 10u)
+					printf("mismatch, iteration %u call %u: wavectrl %02x rampctrl %02x freq %04x start %08x end %08x addr %08x\n",
+						it, c, s.wavectrl, s.rampctrl, s.freq, (unsigned int)s.start, (unsigned int)s.end, (unsigned int)s.addr);
+				errors++;
+				break;
+			}
+		}
+	}
+
+	printf("%u voice setups, %lu frames, %lu mismatches\n", iterations, frames, errors);
+	return errors != 0;
+}
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Measure paging context switches: run SWITCH.COM and EMPTY.COM headless in
+# fast forward mode with each core and divide the number of CR3 switches by
+# the time difference.
+#
+#   ./run.sh [path/to/dosbox-x ...]
+#
+# Each binary is run RUNS times (default 3), the fastest run counts. CORES
+# selects the cores (default "normal dynamic").
+
+ITER=100000
+SPACES=8
+RUNS=${RUNS:-3}
+CORES=${CORES:-"normal dynamic"}
+DIR=$(cd "$(dirname "$0")" && pwd)
+
+[ $# -eq 0 ] && set -- ../../src/dosbox-x
+[ -f "$DIR/SWITCH.COM" ] || make -C "$DIR" >/dev/null || exit 1
+
+CONF=$(mktemp)
+OUT=$(mktemp -d)
+
+# best wall clock time in seconds of running one program, checks its result
+best() {
+	b=""
+	i=0
+	while [ $i -lt $RUNS ]; do
+		t0=$(date +%s.%N)
+		SDL_AUDIODRIVER=dummy "$1" -conf "$CONF" -fastforward \
+			-c "mount c \"$DIR\"" -c "mount d \"$OUT\"" -c "c:" \
+			-c "$2 > D:\\RESULT.TXT" -c exit >/dev/null 2>&1
+		t1=$(date +%s.%N)
+		grep -q "PAGING OK" "$OUT/RESULT.TXT" 2>/dev/null || echo "$1 $2: wrong result" >&2
+		rm -f "$OUT/RESULT.TXT"
+		b=$(echo "$t0 $t1 $b" | awk '{ t = $2 - $1; if ($3 == "" || t < $3) print t; else print $3 }')
+		i=$((i+1))
+	done
+	echo "$b"
+}
+
+for core in $CORES; do
+	cat > "$CONF" <<CONFEOF
+[sdl]
+output=none
+[dosbox]
+captures=/tmp
+[cpu]
+core=$core
+cputype=pentium
+cycles=fixed 1000000
+[mixer]
+nosound=true
+[sblaster]
+sbtype=none
+[gus]
+gus=false
+CONFEOF
+	for bin in "$@"; do
+		e=$(best "$bin" EMPTY.COM)
+		t=$(best "$bin" SWITCH.COM)
+		echo "$t $e $bin" | awk -v n=$ITER -v s=$SPACES -v c=$core \
+			'{ printf "%-8s %-40s %8.0f switches/s (%.2f s for %d switches)\n", c, $3, n * s / ($1 - $2), $1 - $2, n * s }'
+	done
+done
+
+rm -rf "$CONF" "$OUT"
@@ -0,0 +1,127 @@
+// reSID sampling benchmark.
+//
+// Plays a synthetic tune (register writes every video frame, voices with
+// all waveforms, filter routing and mode changes) through each sampling
+// method, clocked one cycle at a time and with block clocking, and reports
+// the speed of both and whether the output is identical.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+#include "sid.h"
+
+static const double sid_freq = 894886;	// Innovation SSI-2001, as in innova.cpp
+static const double sample_freq = 22050;
+static const int frame_cycles = 17898;	// 50 Hz
+static const int seconds = 30;
+
+static unsigned int lfsr;
+
+static unsigned int rnd(void) {
+	lfsr ^= lfsr << 13;
+	lfsr ^= lfsr >> 17;
+	lfsr ^= lfsr << 5;
+	return lfsr;
+}
+
+static void tune_frame(SID2 &sid, int frame) {
+	for (int v = 0;v < 3;v++) {
+		const int base = v * 7;
+		const unsigned int r = rnd();
+
+		sid.write(base + 0, r & 0xff);				// freq lo
+		sid.write(base + 1, ((r >> 8) & 0x3f) + 4);		// freq hi
+		sid.write(base + 2, (r >> 16) & 0xff);			// pulse width lo
+		sid.write(base + 3, (r >> 24) & 0x0f);			// pulse width hi
+		if ((frame + v * 5) % 12 == 0) {
+			sid.write(base + 5, (r >> 4) & 0xff);		// attack/decay
+			sid.write(base + 6, (r >> 12) & 0xff);		// sustain/release
+			// waveform (one or two bits of 0x10..0x80), sync/ring now and then, gate on
+			const unsigned char wave = (unsigned char)((0x10 << (r & 3)) | ((r & 0x40) ? (0x10 << ((r >> 2) & 3)) : 0));
+			sid.write(base + 4, wave | ((r >> 7) & 0x06) | 0x01);
+		}
+		else if ((frame + v * 5) % 12 == 8) {
+			sid.write(base + 4, 0x40);			// gate off
+		}
+	}
+
+	if (frame % 25 == 0) {
+		const unsigned int r = rnd();
+		sid.write(0x15, r & 0x07);				// cutoff lo
+		sid.write(0x16, (r >> 3) & 0xff);			// cutoff hi
+		sid.write(0x17, (r >> 11) & 0xff);			// resonance, routing
+		sid.write(0x18, ((r >> 19) & 0xf0) | 0x0f);		// mode, volume
+	}
+}
+
+struct Result {
+	double seconds;
+	std::vector<short> out;
+};
+
+static Result run(sampling_method method, bool block) {
+	SID2 sid;
+	Result res;
+
+	sid.set_chip_model(MOS6581);
+	sid.enable_filter(true);
+	sid.enable_external_filter(true);
+	sid.set_sampling_parameters(sid_freq, method, sample_freq, -1, 0.97);
+	sid.enable_block_clocking(block);
+
+	lfsr = 0x12345678;
+	res.out.reserve((size_t)(sample_freq * seconds) + 16);
+
+	short buf[4096];
+	const int frames = (int)(sid_freq * seconds) / frame_cycles;
+	const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+	for (int f = 0;f < frames;f++) {
+		tune_frame(sid, f);
+
+		cycle_count delta_t = frame_cycles;
+		while (delta_t) {
+			const int n = sid.clock(delta_t, buf, 4096);
+			res.out.insert(res.out.end(), buf, buf + n);
+		}
+	}
+
+	res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return res;
+}
+
+int main(int argc, char **argv) {
+	static const struct {
+		sampling_method method;
+		const char *name;
+	} methods[] = {
+		{ SAMPLE_FAST,			"fast" },
+		{ SAMPLE_INTERPOLATE,		"interpolate" },
+		{ SAMPLE_RESAMPLE_FAST,		"resample_fast" },
+		{ SAMPLE_RESAMPLE_INTERPOLATE,	"resample_interpolate" }
+	};
+	int fail = 0;
+
+	(void)argc;
+	(void)argv;
+
+	printf("%d s of SID time at %.0f Hz, output %.0f Hz\n", seconds, sid_freq, sample_freq);
+	printf("%-22s %12s %12s %8s  %s\n", "method", "per cycle", "block", "speedup", "output");
+
+	for (size_t i = 0;i < sizeof(methods) / sizeof(methods[0]);i++) {
+		const Result a = run(methods[i].method, false);
+		const Result b = run(methods[i].method, true);
+		const bool same = a.out == b.out;
+
+		printf("%-22s %10.1fx %10.1fx %7.2fx  %s (%u samples)\n", methods[i].name,
+			seconds / a.seconds, seconds / b.seconds, a.seconds / b.seconds,
+			same ? "identical" : "DIFFERENT", (unsigned int)a.out.size());
+		if (!same) fail = 1;
+	}
+
+	printf("(speeds are multiples of realtime)\n");
+	return fail;
+}
@@ -0,0 +1,145 @@
+/* Equivalence test for the SIMD planar to chunky conversion in
+ * src/hardware/vga_draw_simd.h.
+ *
+ * VGA_Planar_Xlat() is compared against the Expand16Table code of
+ * EGA_Planar_Common_Line (vga_draw.cpp), for 8-bit and 32-bit output, at
+ * every SIMD level the host supports. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool sse2_available = false;
+bool avx2_available = false;
+
+#include "../../src/hardware/vga_draw_simd.h"
+
+#if !defined(VGA_USE_SIMD_PLANAR)
+int main() {
+	printf("no SIMD planar conversion on this host\n");
+	return 0;
+}
+#else
+
+static uint32_t Expand16Table[4][16];
+
+/* as in VGA_SetupOther() on a little endian host */
+static void SetupExpand16(void) {
+	for (unsigned int j=0;j < 4u;j++) {
+		for (unsigned int i=0;i < 16u;i++) {
+			Expand16Table[j][i] =
+				((i & 1u) ? 1u << (24u + j) : 0u) |
+				((i & 2u) ? 1u << (16u + j) : 0u) |
+				((i & 4u) ? 1u << (8u  + j) : 0u) |
+				((i & 8u) ? 1u <<        j  : 0u);
+		}
+	}
+}
+
+/* EGA_Planar_Common_Block(), one latch */
+template <typename T> static void Reference(T *dst, const uint32_t *latch, unsigned int count, const T *pal) {
+	for (unsigned int l=0;l < count;l++) {
+		const uint32_t t1 = (latch[l] >> 4) & 0x0f0f0f0f, t2 = latch[l] & 0x0f0f0f0f;
+		const uint32_t a = Expand16Table[0][(t1>>0)&0xFF] | Expand16Table[1][(t1>>8)&0xFF] |
+			Expand16Table[2][(t1>>16)&0xFF] | Expand16Table[3][(t1>>24)&0xFF];
+		const uint32_t b = Expand16Table[0][(t2>>0)&0xFF] | Expand16Table[1][(t2>>8)&0xFF] |
+			Expand16Table[2][(t2>>16)&0xFF] | Expand16Table[3][(t2>>24)&0xFF];
+		for (unsigned int k=0;k < 4u;k++) {
+			dst[l*8u+k]    = pal[(a >> (k*8u)) & 0xFFu];
+			dst[l*8u+4u+k] = pal[(b >> (k*8u)) & 0xFFu];
+		}
+	}
+}
+
+static uint32_t rng = 12345;
+static uint32_t Random(void) {
+	rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+	return rng;
+}
+
+static unsigned long errors = 0;
+
+template <typename T> static void Check(const uint32_t *latch, unsigned int count, const T *pal, const char *level) {
+	T a[VGA_PLANAR_SIMD_LATCHES*8u+8u], b[VGA_PLANAR_SIMD_LATCHES*8u+8u];
+
+	memset(a, 0xCC, sizeof(a));
+	memset(b, 0xCC, sizeof(b));
+	Reference(a, latch, count, pal);
+	VGA_Planar_Xlat(b, latch, count, pal);
+	if (memcmp(a, b, sizeof(a)) != 0) {
+		if (errors < 10u)
+			printf("%s: %u-bit mismatch, %u latches, first latch %08x\n",
+				level, (unsigned int)(sizeof(T)*8u), count, (unsigned int)latch[0]);
+		errors++;
+	}
+}
+
+int main(int argc, char **argv) {
+	const bool all = argc > 1 && !strcmp(argv[1], "all");
+	const char *levels[2] = { "SSE2", "AVX2" };
+	uint32_t latch[VGA_PLANAR_SIMD_LATCHES];
+	uint8_t pal8[16];
+	uint32_t pal32[16];
+
+	SetupExpand16();
+#if defined(VGA_PLANAR_SIMD_X86)
+	__builtin_cpu_init();
+	const unsigned int nlevels = __builtin_cpu_supports("avx2") ? 2u : 1u;
+	if (nlevels < 2u) printf("host has no AVX2, checking SSE2 only\n");
+#else
+	const unsigned int nlevels = 1u;
+	levels[0] = "NEON";
+#endif
+
+	for (unsigned int lv=0;lv < nlevels;lv++) {
+		sse2_available = true;
+		avx2_available = lv == 1u;
+		const unsigned long before = errors;
+
+		/* distinct colors, so that every pixel value shows */
+		for (unsigned int c=0;c < 16u;c++) {
+			pal8[c] = (uint8_t)(0x30u + c*7u);
+			pal32[c] = 0x01000000u*c + 0x00030507u*(c+1u);
+		}
+
+		/* every value of each plane byte, the other planes random */
+		for (unsigned int p=0;p < 4u;p++) {
+			for (unsigned int v=0;v < 256u;v += VGA_PLANAR_SIMD_LATCHES) {
+				for (unsigned int j=0;j < VGA_PLANAR_SIMD_LATCHES;j++)
+					latch[j] = (Random() & ~(0xFFu << (p*8u))) | ((v+j) << (p*8u));
+				Check(latch, VGA_PLANAR_SIMD_LATCHES, pal8, levels[lv]);
+				Check(latch, VGA_PLANAR_SIMD_LATCHES, pal32, levels[lv]);
+			}
+		}
+
+		/* random latches, palettes and lengths, to cover the scalar tails */
+		for (unsigned int it=0;it < 200000u;it++) {
+			const unsigned int count = 1u + (Random() % VGA_PLANAR_SIMD_LATCHES);
+			for (unsigned int j=0;j < count;j++) latch[j] = Random();
+			for (unsigned int c=0;c < 16u;c++) {
+				pal8[c] = (uint8_t)Random();
+				pal32[c] = Random();
+			}
+			Check(latch, count, pal8, levels[lv]);
+			Check(latch, count, pal32, levels[lv]);
+		}
+
+		/* all 2^32 latches */
+		if (all) {
+			uint64_t l = 0;
+			while (l < 0x100000000ull) {
+				for (unsigned int j=0;j < VGA_PLANAR_SIMD_LATCHES;j++)
+					latch[j] = (uint32_t)(l + j);
+				Check(latch, VGA_PLANAR_SIMD_LATCHES, pal8, levels[lv]);
+				l += VGA_PLANAR_SIMD_LATCHES;
+			}
+		}
+
+		printf("%s: %s\n", levels[lv], errors == before ? "ok" : "FAILED");
+	}
+
+	return errors != 0;
+}
+
+#endif
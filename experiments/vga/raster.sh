@@ -0,0 +1,52 @@
+#!/bin/sh
+# Run RASTER.COM (raster.S) under dosbox-x with "scanline batch size" 0, 64
+# and 1000 and compare the screenshots. Batched rendering has to give the
+# same picture as one event per scanline.
+#
+#   ./raster.sh [path/to/dosbox-x]
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+BIN=${1:-../../src/dosbox-x}
+
+make -C "$DIR" RASTER.COM >/dev/null || exit 1
+WORK=$(mktemp -d)
+cp "$DIR/RASTER.COM" "$WORK/"
+
+for batch in 0 64 1000; do
+	mkdir "$WORK/cap$batch"
+	cat > "$WORK/test.conf" <<CONFEOF
+[sdl]
+output=none
+[dosbox]
+captures=$WORK/cap$batch
+[cpu]
+integration device=true
+core=normal
+cputype=pentium
+cycles=fixed 20000
+[mixer]
+nosound=true
+[video]
+scanline batch size=$batch
+CONFEOF
+	SDL_AUDIODRIVER=dummy "$BIN" -conf "$WORK/test.conf" \
+		-c "mount c \"$WORK\"" -c "c:" -c "RASTER.COM" -c exit >/dev/null 2>&1
+done
+
+status=0
+for batch in 0 64 1000; do
+	f=$(ls "$WORK/cap$batch"/*.png 2>/dev/null | head -n 1)
+	if [ -z "$f" ]; then
+		echo "batch $batch: no screenshot"
+		status=1
+		continue
+	fi
+	sum=$(md5sum < "$f" | cut -d' ' -f1)
+	echo "batch $batch: $sum"
+	[ "$batch" = 0 ] && ref=$sum
+	[ "$sum" = "$ref" ] || status=1
+done
+[ $status = 0 ] && echo "identical" || echo "DIFFERENT"
+
+rm -rf "$WORK"
+exit $status
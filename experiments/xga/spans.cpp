@@ -0,0 +1,146 @@
+/* Equivalence test for the span based XGA rectangle fill, blit and pattern
+ * routines in src/hardware/vga_xga.cpp.
+ *
+ * The Makefile extracts the drawing code of vga_xga.cpp twice, once as is
+ * and once with the span routines disabled, so that every command runs
+ * through the per-point XGA_DrawPoint/XGA_GetPoint path. Random commands
+ * are run through both and the video memory and XGA registers compared.
+ * The dirty page map written by the span version has to cover every byte
+ * that changed. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+typedef uintptr_t Bitu;
+typedef intptr_t Bits;
+
+#define GCC_UNLIKELY(x) (x)
+#define LOG_MSG(...) do {} while (0)
+
+enum VGAModes { M_LIN4, M_LIN8, M_LIN15, M_LIN16, M_LIN24, M_LIN32 };
+
+#define VGA_DIRTY_SHIFT 12u
+
+static struct {
+	struct { Bitu xga_screen_width; VGAModes xga_color_mode; } s3;
+	struct { uint8_t *linear; uint32_t memsize; } mem;
+	struct { uint8_t *map; bool track; } dirty;
+} vga;
+
+static inline void VGA_MarkDirty(const Bitu addr) {
+	vga.dirty.map[addr >> VGA_DIRTY_SHIFT] = 1;
+}
+
+static inline void VGA_MarkDirtyRange(const Bitu addr,const Bitu len) {
+	for (Bitu p=addr >> VGA_DIRTY_SHIFT;p <= ((addr + len - 1u) >> VGA_DIRTY_SHIFT);p++)
+		vga.dirty.map[p] = 1;
+}
+
+#define XGA_SCREEN_WIDTH	vga.s3.xga_screen_width
+#define XGA_COLOR_MODE		vga.s3.xga_color_mode
+
+namespace Point {
+#include "xga_point.inc"
+}
+
+namespace Span {
+#include "xga_span.inc"
+}
+
+static uint32_t rng = 12345;
+static uint32_t Random(void) {
+	rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+	return rng;
+}
+
+#define MAXMEM (1024u*1024u)
+
+int main(int argc, char **argv) {
+	const unsigned int iterations = (argc > 1) ? (unsigned int)atoi(argv[1]) : 20000u;
+	static const uint32_t memsizes[3] = { 65536, 262144, MAXMEM };
+	static const VGAModes modes[4] = { M_LIN8, M_LIN15, M_LIN16, M_LIN32 };
+	static const char *opname[3] = { "rectangle", "blit", "pattern" };
+	static uint8_t a[MAXMEM], b[MAXMEM], orig[MAXMEM], dirty[MAXMEM >> VGA_DIRTY_SHIFT];
+	unsigned long errors = 0;
+
+	for (unsigned int it=0;it < iterations;it++) {
+		const uint32_t ms = memsizes[Random() % 3u];
+
+		/* few distinct values half of the time, so that compares and mixes hit */
+		for (uint32_t i=0;i < ms;i += 4u) {
+			const uint32_t r = Random() & ((it & 1u) ? 0x03030303u : 0xffffffffu);
+			memcpy(orig+i, &r, 4);
+		}
+		memcpy(a, orig, ms);
+		memcpy(b, orig, ms);
+
+		vga.mem.memsize = ms;
+		vga.s3.xga_color_mode = modes[Random() % 4u];
+		vga.s3.xga_screen_width = 8u + Random() % 1100u;
+		vga.dirty.map = dirty;
+		vga.dirty.track = true;
+
+		Point::XGAStatus s;
+		memset(&s, 0, sizeof(s));
+		if (Random() % 4u) {
+			s.scissors.x2 = 0xfff;
+			s.scissors.y2 = 0xfff;
+		}
+		else {
+			s.scissors.x1 = (uint16_t)(Random() % 600u);
+			s.scissors.y1 = (uint16_t)(Random() % 600u);
+			s.scissors.x2 = (uint16_t)(Random() % 1200u);
+			s.scissors.y2 = (uint16_t)(Random() % 1200u);
+		}
+		s.forecolor = (Random() % 3u) ? (Random() % 4u) : Random();
+		s.backcolor = (Random() % 3u) ? (Random() % 4u) : Random();
+		s.curcommand = (Random() % 10u) ? 0x11 : (Random() & 0x11);
+		s.foremix = (uint16_t)(Random() & 0x7f);
+		s.backmix = (uint16_t)(Random() & 0x7f);
+		if (Random() % 3u == 0u) s.foremix = (uint16_t)((s.foremix & 0x1f) | 0x60);
+		s.curx = (uint16_t)(Random() % ((Random() % 2u) ? 1200u : 4096u));
+		s.cury = (uint16_t)(Random() % ((Random() % 2u) ? 600u : 4096u));
+		s.destx = (uint16_t)(Random() % 1200u);
+		s.desty = (uint16_t)(Random() % ((Random() % 2u) ? 600u : 1200u));
+		if (Random() % 3u == 0u) {
+			/* overlapping blits */
+			s.destx = (uint16_t)(s.curx + (Random() % 9u) - 4u);
+			s.desty = (uint16_t)(s.cury + (Random() % 5u) - 2u);
+		}
+		s.MAPcount = (uint16_t)(Random() % ((Random() % 4u) ? 64u : 1100u));
+		s.MIPcount = (uint16_t)(Random() % ((Random() % 4u) ? 32u : 300u));
+		s.pix_cntl = (uint16_t)((Random() & 3u) << 6u);
+		const Bitu val = Random() & 0xa0;	/* x and y direction */
+		const unsigned int op = Random() % 3u;
+
+		Point::xga = s;
+		vga.mem.linear = a;
+		if (op == 0u) Point::XGA_DrawRectangle(val);
+		else if (op == 1u) Point::XGA_BlitRect(val);
+		else Point::XGA_DrawPattern(val);
+
+		memset(dirty, 0, sizeof(dirty));
+		memcpy(&Span::xga, &s, sizeof(s));
+		vga.mem.linear = b;
+		if (op == 0u) Span::XGA_DrawRectangle(val);
+		else if (op == 1u) Span::XGA_BlitRect(val);
+		else Span::XGA_DrawPattern(val);
+
+		bool bad = memcmp(a, b, ms) != 0 || memcmp(&Point::xga, &Span::xga, sizeof(s)) != 0;
+		for (uint32_t i=0;i < ms && !bad;i++) {
+			if (b[i] != orig[i] && !dirty[i >> VGA_DIRTY_SHIFT]) bad = true;
+		}
+		if (bad) {
+			if (errors < 10u)
+				printf("%s mismatch, iteration %u, mode %d, mix %02x/%02x, pix_cntl %x\n",
+					opname[op], it, (int)vga.s3.xga_color_mode, s.foremix, s.backmix, s.pix_cntl >> 6);
+			errors++;
+		}
+	}
+
+	printf("%u commands, %lu mismatches\n", iterations, errors);
+	return errors != 0;
+}
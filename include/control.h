@@ -101,6 +101,7 @@ public:
         opt_date_host_forced = false;
         opt_disable_numlock_check = false;
         opt_disable_dpi_awareness = false;
+        opt_fastforward = false;
         opt_time_limit = -1;
         opt_log_con = false;
     }
@@ -140,6 +141,7 @@ public:
     bool opt_securemode;
     bool opt_fullscreen;
     bool opt_fastlaunch;
+    bool opt_fastforward;
     bool opt_showcycles;
     bool opt_earlydebug;
     bool opt_logfileio;
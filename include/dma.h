@@ -92,6 +92,7 @@ public:
     }
 
 	DmaChannel(uint8_t num, bool dma16);
+	bool TransferDone(Bitu cando);
 	void DoCallBack(DMAEvent event) {
 		if (callback)	(*callback)(this,event);
 	}
@@ -131,6 +132,7 @@ public:
 	}
 	Bitu Read(Bitu want, uint8_t * buffer);
 	Bitu Write(Bitu want, uint8_t * buffer);
+	const uint8_t *ReadHostPt(Bitu want, Bitu &got);
 
 	void SaveState( std::ostream& stream );
 	void LoadState( std::istream& stream );
@@ -74,6 +74,16 @@
 // Microsoft C++ sizeof(long double) == sizeof(double)
 #elif defined(__arm__)
 // ARMv7 (Raspberry Pi) does not have long double, sizeof(long double) == sizeof(double)
+#elif defined(__LDBL_MANT_DIG__) && (__LDBL_MANT_DIG__ != 64)
+// long double is not the 80-bit extended format with a 64-bit mantissa. On AArch64 Linux it is
+// 128-bit quad precision done entirely in software, which is far too slow for FPU heavy games
+// (and does not match the FPU_Reg_80 layout), on Apple ARM64 it is just an alias of double.
+// Use the software 80-bit FPU core there (fpu_instructions_soft80.h), which computes exact
+// x87 results and takes the host double for the common cases. With --disable-fpu-soft80 the
+// double precision FPU core is used instead, faster but only 53 bits precise.
+# if C_FPU_SOFT80
+#  define HAS_FPU_SOFT80		1
+# endif
 #else
 // GCC, other compilers, have sizeof(long double) == 10 80-bit IEEE
 # define HAS_LONG_DOUBLE		1
@@ -156,14 +156,14 @@ enum FPU_Round {
 };
 
 typedef struct {
-#if defined(HAS_LONG_DOUBLE)//probably shouldn't allow struct to change size based on this
+#if defined(HAS_LONG_DOUBLE) || defined(HAS_FPU_SOFT80)//probably shouldn't allow struct to change size based on this
 	FPU_Reg		_do_not_use__regs[9];
 #else
 	FPU_Reg		regs[9];
 #endif
 	FPU_P_Reg	p_regs[9];
 	FPU_Reg_80	regs_80[9];
-#if defined(HAS_LONG_DOUBLE)//probably shouldn't allow struct to change size based on this
+#if defined(HAS_LONG_DOUBLE) || defined(HAS_FPU_SOFT80)//probably shouldn't allow struct to change size based on this
 	bool		_do_not_use__use80[9];		// if set, use the 80-bit precision version
 #else
 	bool		use80[9];		// if set, use the 80-bit precision version
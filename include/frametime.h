@@ -0,0 +1,63 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_FRAMETIME_H
+#define DOSBOX_FRAMETIME_H
+
+/* Frame timing instrumentation ([render] "frame timing" and "frame timing csv").
+ *
+ * The emulation thread is always "in" exactly one stage. Entering a stage
+ * suspends the current one, leaving it resumes the stage below, so the time
+ * of nested stages (the scalers called from a VGA scanline, the output called
+ * from RENDER_EndUpdate) is not counted twice. At every emulated vertical
+ * retrace the time per stage is added to a histogram. Emulation thread only. */
+
+enum FRAMETIME_STAGE {
+    FRAMETIME_OTHER=0,      /* anything not below: PIC events, other devices, host events, sleeping */
+    FRAMETIME_CPU,          /* CPU core slices run by Normal_Loop() */
+    FRAMETIME_VGA,          /* VGA scanline drawing */
+    FRAMETIME_SCALER,       /* scaler chain and RENDER_EndUpdate() */
+    FRAMETIME_OUTPUT,       /* GFX_EndUpdate(), presenting the frame */
+    FRAMETIME_MIXER,        /* mixing audio on the emulation thread */
+
+    FRAMETIME_STAGES
+};
+
+extern bool frametime_enabled;
+
+void FRAMETIME_Enter(FRAMETIME_STAGE stage);
+void FRAMETIME_Leave(void);
+void FRAMETIME_EndFrame(void);
+void FRAMETIME_Configure(bool title,const char *csv);
+/* averages since the last call for the title bar, NULL if not shown there */
+const char *FRAMETIME_TitleText(void);
+
+/* times the enclosing scope as one stage */
+class FrameTimeScope {
+public:
+    FrameTimeScope(const FRAMETIME_STAGE stage) : active(frametime_enabled) {
+        if (active) FRAMETIME_Enter(stage);
+    }
+    ~FrameTimeScope() {
+        if (active) FRAMETIME_Leave();
+    }
+private:
+    const bool active;
+};
+
+#endif /*DOSBOX_FRAMETIME_H*/
@@ -42,6 +42,10 @@ extern uint8_t MixTemp[MIXER_BUFSIZE];
 
 #define LOWPASS_ORDER 8
 
+#define MIXER_SINC_MAX_TAPS 64
+
+struct MixerSincTable;
+
 class MixerChannel {
 public:
 	void SetVolume(float _left,float _right);
@@ -67,6 +71,9 @@ public:
 	double timeSinceLastSample(void);
 
 	bool runSampleInterpolation(const Bitu upto);
+	bool runSincInterpolation(const Bitu upto);
+	void sincUpdate(void);
+	void sincPush(void);
 
 	void updateSlew(void);
 	void padFillSampleInterpolation(const Bitu upto);
@@ -111,6 +118,10 @@ public:
 	bool current_loaded;
 	int32_t current[2],last[2],delta[2],max_change;
 	int32_t msbuffer[2048][2];		// more than enough for 1ms of audio, at mixer sample rate
+	const MixerSincTable * sinc;		// resampler coefficients, NULL to interpolate linearly
+	uint64_t sinc_phase_mul;		// freq_f -> coefficient row, 32.32 fixed point
+	unsigned int sinc_pos;			// last write to sinc_hist
+	float sinc_hist[2][MIXER_SINC_MAX_TAPS*2];	// input history, each sample written twice so the last taps are contiguous
 	Bits last_sample_write;
 	Bitu msbuffer_o;
 	Bitu msbuffer_i;
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef DOSBOX_MIXER_QUEUE_H
+#define DOSBOX_MIXER_QUEUE_H
+
+#include <vector>
+
+#include "pic.h"
+
+/* Timestamped register writes for sound chips rendered by a mixer callback.
+ *
+ * Filling up the mixer on every register write keeps the chip sample accurate,
+ * but renders all channels a few samples at a time. Instead the port handler
+ * queues the write with its PIC_FullIndex() time, and the mixer callback
+ * renders the whole block at once, stopping at each write to apply it at its
+ * sample offset. The mixer renders up to the current emulated time, so the
+ * block ends "now" and a write made t ms ago lands t * rate / 1000 samples
+ * before its end.
+ *
+ * Render() takes two functors: render(offset,count) generates count samples
+ * at offset in the block, apply(reg,val) writes a register. Emulation thread
+ * only. */
+
+/* more writes than this without a render (channel disabled?) are applied at once */
+#define MIXER_QUEUE_MAX		8192
+
+class MixerRegQueue {
+public:
+	struct Write {
+		pic_tickindex_t	time;
+		uint32_t	reg;
+		uint32_t	val;
+	};
+
+	bool Empty(void) const {
+		return writes.empty();
+	}
+	bool Full(void) const {
+		return writes.size() >= MIXER_QUEUE_MAX;
+	}
+	void Add(uint32_t reg,uint32_t val) {
+		Write w;
+		w.time = PIC_FullIndex();
+		w.reg = reg;
+		w.val = val;
+		writes.push_back(w);
+	}
+	void Clear(void) {
+		writes.clear();
+	}
+
+	/* apply everything now, without rendering (save states, disabled channel) */
+	template <class APPLY> void Flush(APPLY apply) {
+		for (size_t i=0;i < writes.size();i++)
+			apply(writes[i].reg,writes[i].val);
+		writes.clear();
+	}
+
+	template <class RENDER,class APPLY> void Render(Bitu len,Bitu rate,RENDER render,APPLY apply) {
+		const pic_tickindex_t now = PIC_FullIndex();
+		Bitu done = 0;
+
+		for (size_t i=0;i < writes.size();i++) {
+			/* samples between the write and the end of the block */
+			const pic_tickindex_t ago = ((now - writes[i].time) * (pic_tickindex_t)rate) / 1000.0;
+			Bitu at = len;
+
+			if (ago >= (pic_tickindex_t)len) at = 0;
+			else if (ago > 0) at = len - (Bitu)(ago + 0.5);
+
+			if (at > done) {
+				render(done,at - done);
+				done = at;
+			}
+			apply(writes[i].reg,writes[i].val);
+		}
+		writes.clear();
+
+		if (done < len) render(done,len - done);
+	}
+private:
+	std::vector<Write> writes;
+};
+
+#endif /*DOSBOX_MIXER_QUEUE_H*/
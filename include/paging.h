@@ -28,9 +28,15 @@
 #include "mem.h"
 #endif
 
-// disable this to reduce the size of the TLB
-// NOTE: does not work with the dynamic core (dynrec is fine)
+// The full TLB keeps one flat array per field for all 1M linear pages (~20MB).
+// It is only required by the 32-bit backend of the dynamic x86 core, which
+// indexes those arrays directly from generated code and has no spare register
+// for a second lookup level. Everything else, including the x86-64 backend,
+// uses the compact TLB: packed entries in 4MB banks that are only allocated
+// once a page in them is linked.
+#if C_DYNAMIC_X86 && !(defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__))
 #define USE_FULL_TLB
+#endif
 
 class PageHandler;
 class MEM_CalloutObject;
@@ -65,13 +71,13 @@ static inline Bitu MEMMASK_Combine(const Bitu a,const Bitu b) {
 #define MEM_PAGE_SIZE	(4096)
 #define XMS_START		(0x110)
 
-#if defined(USE_FULL_TLB)
-#define TLB_SIZE		(1024*1024)
-#else
-#define TLB_SIZE		65536	// This must a power of 2 and greater then LINK_START
-#define BANK_SHIFT		28
-#define BANK_MASK		0xffff // always the same as TLB_SIZE-1?
-#define TLB_BANKS		((1024*1024/TLB_SIZE)-1)
+#define TLB_SIZE		(1024*1024)		// number of linear pages covered by the TLB
+#if !defined(USE_FULL_TLB)
+#define TLB_BANK_SHIFT	10				// one bank per page directory entry (4MB)
+#define TLB_BANK_SIZE	(1u<<TLB_BANK_SHIFT)	// must be greater than LINK_START
+#define TLB_BANK_MASK	(TLB_BANK_SIZE-1u)
+#define TLB_BANKS		(TLB_SIZE>>TLB_BANK_SHIFT)
+#define TLB_BANK_IDLE	64				// full flushes without a link before a bank is freed
 #endif
 
 #define PFLAG_READABLE		0x1u
@@ -214,7 +220,6 @@ void PAGING_InitTLB(void);
 void PAGING_ClearTLB(void);
 
 void PAGING_LinkPage(Bitu lin_page,Bitu phys_page);
-void PAGING_LinkPage_ReadOnly(Bitu lin_page,Bitu phys_page);
 void PAGING_UnlinkPages(Bitu lin_page,Bitu pages);
 /* This maps the page directly, only use when paging is disabled */
 void PAGING_MapPage(Bitu lin_page,Bitu phys_page);
@@ -291,8 +296,12 @@ struct PagingBlock {
 		uint32_t	phys_page[TLB_SIZE];
 	} tlb;
 #else
-	tlb_entry tlbh[TLB_SIZE];
-	tlb_entry *tlbh_banks[TLB_BANKS];
+	tlb_entry *tlbh_banks[TLB_BANKS];	// never NULL, unallocated banks point to tlbh_blank
+	tlb_entry tlbh[TLB_BANK_SIZE];		// bank 0 (first 4MB), always present
+	tlb_entry tlbh_blank[TLB_BANK_SIZE];	// shared by all unallocated banks, never written after init
+	uint8_t tlbh_idle[TLB_BANKS];		// full flushes since a page in the bank was last linked
+	uint16_t tlbh_alloc[TLB_BANKS];		// allocated banks other than bank 0
+	Bitu tlbh_alloc_used;
 #endif
 	struct {
 		Bitu used;
@@ -356,19 +365,31 @@ static INLINE PhysPt PAGING_GetPhysicalAddress(const PhysPt linAddr) {
 	return (paging.tlb.phys_page[linAddr>>12]<<12)|(linAddr&0xfff);
 }
 
+/* Writable access to the TLB fields of a linear page, for the paging code */
+#define TLB_READ(lin_page)			paging.tlb.read[lin_page]
+#define TLB_WRITE(lin_page)			paging.tlb.write[lin_page]
+#define TLB_READHANDLER(lin_page)	paging.tlb.readhandler[lin_page]
+#define TLB_WRITEHANDLER(lin_page)	paging.tlb.writehandler[lin_page]
+#define TLB_PHYS_PAGE(lin_page)		paging.tlb.phys_page[lin_page]
+
 #else
 
-void PAGING_InitTLBBank(tlb_entry **bank);
+tlb_entry *PAGING_InitTLBBank(Bitu bank);
 
+/* Lookup for memory accesses: unallocated banks resolve to the blank bank,
+ * whose entries send every access to the init handler, so no NULL check
+ * is needed on the fast path. */
 static INLINE tlb_entry *get_tlb_entry(const PhysPt address) {
 	const Bitu index=(address >> 12U);
-	if (TLB_BANKS && (index >= TLB_SIZE)) {
-		const Bitu bank=(address >> BANK_SHIFT) - 1U;
-		if (!paging.tlbh_banks[bank])
-			PAGING_InitTLBBank(&paging.tlbh_banks[bank]);
-		return &paging.tlbh_banks[bank][index & BANK_MASK];
-	}
-	return &paging.tlbh[index];
+	return &paging.tlbh_banks[index >> TLB_BANK_SHIFT][index & TLB_BANK_MASK];
+}
+
+/* Lookup for modifying an entry, allocates the bank on first use */
+static INLINE tlb_entry *get_tlb_entry_rw(const Bitu lin_page) {
+	tlb_entry *bank=paging.tlbh_banks[lin_page >> TLB_BANK_SHIFT];
+	if (GCC_UNLIKELY(bank == paging.tlbh_blank))
+		bank=PAGING_InitTLBBank(lin_page >> TLB_BANK_SHIFT);
+	return &bank[lin_page & TLB_BANK_MASK];
 }
 
 static INLINE HostPt get_tlb_read(const PhysPt address) {
@@ -394,6 +415,13 @@ static INLINE PhysPt PAGING_GetPhysicalAddress(const PhysPt linAddr) {
 	tlb_entry *entry = get_tlb_entry(linAddr);
 	return (entry->phys_page<<12)|(linAddr&0xfff);
 }
+
+/* Writable access to the TLB fields of a linear page, for the paging code */
+#define TLB_READ(lin_page)			(get_tlb_entry_rw(lin_page)->read)
+#define TLB_WRITE(lin_page)			(get_tlb_entry_rw(lin_page)->write)
+#define TLB_READHANDLER(lin_page)	(get_tlb_entry_rw(lin_page)->readhandler)
+#define TLB_WRITEHANDLER(lin_page)	(get_tlb_entry_rw(lin_page)->writehandler)
+#define TLB_PHYS_PAGE(lin_page)		(get_tlb_entry_rw(lin_page)->phys_page)
 #endif
 
 /* Special inlined memory reading/writing */
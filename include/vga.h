@@ -748,6 +748,20 @@ typedef struct {
 	PageHandler *handler;
 } VGA_LFB;
 
+/* Dirty page tracking for the linear SVGA modes. Writes to video memory through
+ * the LFB and banked page handlers (and S3 accelerator drawing) mark the 4KB page
+ * written, so that scanlines that did not change since the previous frame can be
+ * passed over by the scanline renderer. */
+#define VGA_DIRTY_SHIFT 12u
+
+typedef struct {
+	uint8_t*    map = NULL;             /* one byte per 4KB page of video memory, nonzero if written */
+	uint8_t*    prev = NULL;            /* pages written during the frame before, swapped with map at frame start */
+	bool        track = false;          /* LFB handler and accelerator mark written pages */
+	bool        complete = false;       /* ...and so does the handler mapped at A0000h for the current mode */
+	bool        all = true;             /* picture changed other than through video memory, redraw everything */
+} VGA_Dirty;
+
 static const size_t VGA_Draw_2_elem = 2;
 
 typedef struct VGA_Type_t {
@@ -773,6 +787,7 @@ typedef struct VGA_Type_t {
     VGA_OTHER other = {};
     VGA_Memory mem;
     VGA_LFB lfb = {};
+    VGA_Dirty dirty;
 } VGA_Type;
 
 
@@ -827,6 +842,26 @@ void VGA_SetOverride(bool vga_override);
 
 extern VGA_Type vga;
 
+/* call before a register that affects the picture is written: with batched scanline
+ * rendering the scanlines the beam has passed are drawn first, with the old value */
+extern bool vga_batch_frame;
+void VGA_BatchCatchUp(void);
+
+static inline void VGA_NoteRasterWrite(void) {
+	vga.dirty.all = true;
+	if (vga_batch_frame)
+		VGA_BatchCatchUp();
+}
+
+static inline void VGA_MarkDirty(const Bitu addr) {
+	vga.dirty.map[addr >> VGA_DIRTY_SHIFT] = 1;
+}
+
+static inline void VGA_MarkDirtyRange(const Bitu addr,const Bitu len) {
+	for (Bitu p=addr >> VGA_DIRTY_SHIFT;p <= ((addr + len - 1u) >> VGA_DIRTY_SHIFT);p++)
+		vga.dirty.map[p] = 1;
+}
+
 /* Support for modular SVGA implementation */
 /* Video mode extra data to be passed to FinishSetMode_SVGA().
    This structure will be in flux until all drivers (including S3)
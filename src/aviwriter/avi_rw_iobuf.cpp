@@ -29,15 +29,19 @@
  * If you know anything about syscall overhead and disk I/O,
  * that's a VERY inefficent way to do it! So index read/write
  * code uses our buffer to batch the index entries into RAM
- * and write them to disk in one burst */
-unsigned char*		avi_io_buf = NULL;
-unsigned char*		avi_io_read = NULL;
-unsigned char*		avi_io_write = NULL;
-unsigned char*		avi_io_fence = NULL;
-size_t			avi_io_elemsize = 0;
-size_t			avi_io_next_adv = 0;
-size_t			avi_io_elemcount = 0;
-unsigned char*		avi_io_readfence = NULL;
+ * and write them to disk in one burst.
+ *
+ * The buffer is per thread: the multitrack wave capture writes
+ * its AVI file from a writer thread while video capture writes
+ * from the emulation thread. */
+thread_local unsigned char*	avi_io_buf = NULL;
+thread_local unsigned char*	avi_io_read = NULL;
+thread_local unsigned char*	avi_io_write = NULL;
+thread_local unsigned char*	avi_io_fence = NULL;
+thread_local size_t		avi_io_elemsize = 0;
+thread_local size_t		avi_io_next_adv = 0;
+thread_local size_t		avi_io_elemcount = 0;
+thread_local unsigned char*	avi_io_readfence = NULL;
 
 unsigned char *avi_io_buffer_init(size_t structsize) {
 #define GROUPSIZE ((size_t)(65536*2))
@@ -16,14 +16,14 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-extern unsigned char*		avi_io_buf;
-extern unsigned char*		avi_io_read;
-extern unsigned char*		avi_io_write;
-extern unsigned char*		avi_io_fence;
-extern size_t			avi_io_elemsize;
-extern size_t			avi_io_next_adv;
-extern size_t			avi_io_elemcount;
-extern unsigned char*		avi_io_readfence;
+extern thread_local unsigned char*	avi_io_buf;
+extern thread_local unsigned char*	avi_io_read;
+extern thread_local unsigned char*	avi_io_write;
+extern thread_local unsigned char*	avi_io_fence;
+extern thread_local size_t		avi_io_elemsize;
+extern thread_local size_t		avi_io_next_adv;
+extern thread_local size_t		avi_io_elemcount;
+extern thread_local unsigned char*	avi_io_readfence;
 
 unsigned char *avi_io_buffer_init(size_t structsize);
 void avi_io_buffer_free();
@@ -771,6 +771,38 @@ static bool mem_writeb_checked_dcx64(PhysPt address, Bitu val) {
 	return get_tlb_writehandler(address)->writeb_checked(address, val);
 }
 
+// the lookup below scales the entry index by 5*8
+static_assert(sizeof(tlb_entry)==5*8,"tlb_entry layout does not match the generated TLB lookup");
+
+// Second temporary for the TLB lookup, must be taken before dyn_savestate.
+// Register tmp and the registers of keep1/keep2 are left alone.
+static uint8_t dyn_tlb_tmpreg(uint8_t tmp,GenReg * keep1,GenReg * keep2) {
+	GenReg *gentmp=NULL;
+	for (Bitu i=0;i<X64_REGS;i++)
+		if (x64gen.regs[i]->index==tmp) gentmp=x64gen.regs[i];
+	gentmp->notusable=true;
+	keep1->notusable=true;
+	keep2->notusable=true;
+	uint8_t tmp2=GetNextReg();
+	gentmp->notusable=false;
+	keep1->notusable=false;
+	keep2->notusable=false;
+	return tmp2;
+}
+
+// tmp = paging.tlbh_banks[page>>TLB_BANK_SHIFT][page&TLB_BANK_MASK].read/write,
+// for the linear page number in tmpd. Clobbers tmp2.
+static void dyn_tlb_lookup(uint8_t tmp,uint8_t tmp2,bool write) {
+	opcode(tmp2).setrm(tmp).Emit8(0x8B); // mov tmp2d, tmpd
+	opcode(5).setrm(tmp2).setimm(TLB_BANK_SHIFT,1).Emit8(0xC1); // shr tmp2d,TLB_BANK_SHIFT
+	opcode(4).setrm(tmp).setimm(TLB_BANK_MASK,4).Emit8(0x81); // and tmpd,TLB_BANK_MASK
+	// mov tmp2, [8*tmp2+paging.tlbh_banks(rbp)]
+	opcode(tmp2).set64().setea(5,tmp2,3,(Bits)paging.tlbh_banks-(Bits)&cpu_regs).Emit8(0x8B);
+	opcode(tmp).set64().setea(tmp,tmp,2).Emit8(0x8D); // lea tmp, [tmp+4*tmp]
+	// mov tmp, [tmp2+8*tmp+offsetof(tlb_entry,read/write)]
+	opcode(tmp).set64().setea(tmp2,tmp,3,write?offsetof(tlb_entry,write):offsetof(tlb_entry,read)).Emit8(0x8B);
+}
+
 static void dyn_read_word(DynReg * addr,DynReg * dst,bool dword,bool release=false) {
 	DynState callstate;
 	uint8_t tmp;
@@ -787,6 +819,7 @@ static void dyn_read_word(DynReg * addr,DynReg * dst,bool dword,bool release=fal
 	gensrc->notusable = false;
 	x64gen.regs[reg_args[0]]->notusable=false;
 	x64gen.regs[reg_args[1]]->notusable=false;
+	uint8_t tmp2 = dyn_tlb_tmpreg(tmp,gensrc,gendst);
 	dyn_savestate(&callstate);
 
 	uint8_t *page_brk;
@@ -801,8 +834,7 @@ static void dyn_read_word(DynReg * addr,DynReg * dst,bool dword,bool release=fal
 	}
 
 	opcode(5).setrm(tmp).setimm(12,1).Emit8(0xC1); // shr tmpd,12
-	// mov tmp, [8*tmp+paging.tlb.read(rbp)]
-	opcode(tmp).set64().setea(5,tmp,3,(Bits)paging.tlb.read-(Bits)&cpu_regs).Emit8(0x8B);
+	dyn_tlb_lookup(tmp,tmp2,false);
 	opcode(tmp).set64().setrm(tmp).Emit8(0x85); // test tmp,tmp
 	uint8_t *nomap=gen_create_branch(BR_Z);
 	//mov dst, [tmp+src]
@@ -840,6 +872,7 @@ static void dyn_read_byte(DynReg * addr,DynReg * dst,bool high,bool release=fals
 	GenReg *gensrc = FindDynReg(addr);
 	GenReg *gendst = FindDynReg(dst);
 	tmp = GetNextReg(high);
+	uint8_t tmp2 = dyn_tlb_tmpreg(tmp,gensrc,gendst);
 	if (release) gen_releasereg(addr);
 	dyn_savestate(&callstate);
 
@@ -847,8 +880,7 @@ static void dyn_read_byte(DynReg * addr,DynReg * dst,bool high,bool release=fals
 
 	opcode(tmp).setrm(gensrc->index).Emit8(0x8B); // mov tmp, src
 	opcode(5).setrm(tmp).setimm(12,1).Emit8(0xC1); // shr tmp,12
-	// mov tmp, [8*tmp+paging.tlb.read(rbp)]
-	opcode(tmp).set64().setea(5,tmp,3,(Bits)paging.tlb.read-(Bits)&cpu_regs).Emit8(0x8B);
+	dyn_tlb_lookup(tmp,tmp2,false);
 	opcode(tmp).set64().setrm(tmp).Emit8(0x85); // test tmp,tmp
 	uint8_t *nomap=gen_create_branch(BR_Z);
 
@@ -889,6 +921,7 @@ static void dyn_write_word(DynReg * addr,DynReg * val,bool dword,bool release=fa
 	tmp = GetNextReg();
 	x64gen.regs[reg_args[0]]->notusable=false;
 	x64gen.regs[reg_args[1]]->notusable=false;
+	uint8_t tmp2 = dyn_tlb_tmpreg(tmp,gendst,genval);
 	if (release) gen_releasereg(addr);
 	dyn_savestate(&callstate);
 
@@ -904,8 +937,7 @@ static void dyn_write_word(DynReg * addr,DynReg * val,bool dword,bool release=fa
 	}
 
 	opcode(5).setrm(tmp).setimm(12,1).Emit8(0xC1); // shr tmpd,12
-	// mov tmp, [8*tmp+paging.tlb.write(rbp)]
-	opcode(tmp).set64().setea(5,tmp,3,(Bits)paging.tlb.write-(Bits)&cpu_regs).Emit8(0x8B);
+	dyn_tlb_lookup(tmp,tmp2,true);
 	opcode(tmp).set64().setrm(tmp).Emit8(0x85); // test tmp,tmp
 	uint8_t *nomap=gen_create_branch(BR_Z);
 	//mov [tmp+src], dst
@@ -938,6 +970,7 @@ static void dyn_write_byte(DynReg * addr,DynReg * val,bool high,bool release=fal
 	GenReg *gendst = FindDynReg(addr);
 	GenReg *genval = FindDynReg(val);
 	tmp = GetNextReg(high);
+	uint8_t tmp2 = dyn_tlb_tmpreg(tmp,gendst,genval);
 	if (release) gen_releasereg(addr);
 	dyn_savestate(&callstate);
 
@@ -945,8 +978,7 @@ static void dyn_write_byte(DynReg * addr,DynReg * val,bool high,bool release=fal
 
 	opcode(tmp).setrm(gendst->index).Emit8(0x8B); // mov tmpd, dst
 	opcode(5).setrm(tmp).setimm(12,1).Emit8(0xC1); // shr tmpd,12
-	// mov tmp, [8*tmp+paging.tlb.write(rbp)]
-	opcode(tmp).set64().setea(5,tmp,3,(Bits)paging.tlb.write-(Bits)&cpu_regs).Emit8(0x8B);
+	dyn_tlb_lookup(tmp,tmp2,true);
 	opcode(tmp).set64().setrm(tmp).Emit8(0x85); // test tmp,tmp
 	uint8_t *nomap=gen_create_branch(BR_Z);
 
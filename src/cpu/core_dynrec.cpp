@@ -28,6 +28,10 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 #if defined (WIN32)
 #include <windows.h>
 #include <winbase.h>
@@ -424,9 +428,17 @@ void CPU_Core_Dynrec_Cache_Init(bool enable_cache) {
 }
 
 void CPU_Core_Dynrec_Cache_Close(void) {
+	cache_profile_save();
 	cache_close();
 }
 
+void CPU_Core_Dynrec_Cache_ProfileFile(const std::string &path) {
+	if (cache_profile.enabled && cache_profile.path==path) return;
+	// write out the profiles gathered so far before switching files
+	cache_profile_save();
+	cache_profile_load(path);
+}
+
 void CPU_Core_Dynrec_Cache_Reset(void) {
 	cache_reset();
 }
@@ -79,6 +79,45 @@ static CacheBlockDynRec * cache_blocks=NULL;
 static CacheBlockDynRec link_blocks[2];		// default linking (specially marked)
 
 
+// persistent code page profiles. The invalidation map of a code page (the
+// bytes that were modified while being part of translated code) is kept,
+// keyed by a hash of the unmodified page contents and the cpu mode, and
+// can be saved to disk. When the same page is set up again (in this or a
+// later run) the map is restored, so self-modifying code is translated
+// with the memory-reading immediates or left to the normal core right away
+// instead of going through several translate/invalidate rounds first.
+// Translated host code itself is not stored, it contains absolute host
+// addresses that are only valid within the current process.
+#define CACHE_PROFILE_MAX	(64*1024)
+#define CACHE_PROFILE_MAGIC	"DBXDRC01"
+
+struct CacheProfileDynRec {
+	std::vector<uint16_t> offset;	// modified bytes of the page
+	std::vector<uint8_t> count;		// invalidation count of each modified byte
+};
+
+static struct {
+	bool enabled;
+	bool dirty;
+	std::string path;
+	std::map<uint64_t,CacheProfileDynRec> pages;
+	Bitu hits;
+} cache_profile;
+
+static uint64_t cache_profile_key(const uint8_t * mem) {
+	// FNV-1a over the page contents
+	uint64_t hash=0xcbf29ce484222325ull;
+	for (Bitu i=0;i<4096;i++) {
+		hash^=mem[i];
+		hash*=0x100000001b3ull;
+	}
+	// the translation depends on the code segment size and the cpu mode
+	hash^=(cpu.code.big?1u:0u)|(cpu.pmode?2u:0u)|((reg_flags&FLAG_VM)?4u:0u);
+	hash*=0x100000001b3ull;
+	return hash;
+}
+
+
 // the CodePageHandlerDynRec class provides access to the contained
 // cache blocks and intercepts writes to the code for special treatment
 class CodePageHandlerDynRec : public PageHandler {
@@ -107,6 +146,47 @@ public:
 			free(invalidation_map);
 			invalidation_map=NULL;
 		}
+
+		profile_valid=false;
+		if (cache_profile.enabled) {
+			HostPt mem=old_pagehandler->GetHostReadPt(phys_page);
+			if (mem!=NULL) {
+				profile_key=cache_profile_key(mem);
+				profile_valid=true;
+				LoadProfile();
+			}
+		}
+	}
+
+	// restore the invalidation map from a profile of identical page contents
+	void LoadProfile(void) {
+		std::map<uint64_t,CacheProfileDynRec>::const_iterator it=cache_profile.pages.find(profile_key);
+		if (it==cache_profile.pages.end()) return;
+		const CacheProfileDynRec &prof=it->second;
+		if (prof.offset.empty()) return;
+		invalidation_map=(uint8_t*)malloc(4096);
+		if (invalidation_map==NULL) E_Exit("Memory allocation failed in LoadProfile");
+		memset(invalidation_map,0,4096);
+		for (size_t i=0;i<prof.offset.size();i++)
+			invalidation_map[prof.offset[i]&4095]=prof.count[i];
+		cache_profile.hits++;
+	}
+
+	// remember the invalidation map of this page for later setups
+	void SaveProfile(void) {
+		if (!profile_valid || invalidation_map==NULL) return;
+		if (cache_profile.pages.size()>=CACHE_PROFILE_MAX &&
+			cache_profile.pages.find(profile_key)==cache_profile.pages.end()) return;
+		CacheProfileDynRec &prof=cache_profile.pages[profile_key];
+		prof.offset.clear();
+		prof.count.clear();
+		for (Bitu i=0;i<4096;i++) {
+			if (invalidation_map[i]) {
+				prof.offset.push_back((uint16_t)i);
+				prof.count.push_back(invalidation_map[i]);
+			}
+		}
+		cache_profile.dirty=true;
 	}
 
 	// clear out blocks that contain code which has been modified
@@ -359,6 +439,7 @@ public:
 	}
 
 	void Release(void) {
+		if (cache_profile.enabled) SaveProfile();
 		MEM_SetPageHandler(phys_page,1,old_pagehandler);	// revert to old handler
 		PAGING_ClearTLB();
 
@@ -418,6 +499,8 @@ private:
     Bitu active_count = 0;      // delaying parameter to not immediately release a page
     HostPt hostmem = NULL;
     Bitu phys_page = 0;
+    uint64_t profile_key = 0;   // hash of the page contents at setup time
+    bool profile_valid = false;
 };
 
 
@@ -809,3 +892,97 @@ static void cache_close(void) {
 	cache_code_link_blocks = NULL;
 	cache_initialized = false; */
 }
+
+static bool cache_profile_read(FILE * f,void * data,size_t len) {
+	return fread(data,len,1,f)==1;
+}
+
+static bool cache_profile_write(FILE * f,const void * data,size_t len) {
+	return fwrite(data,len,1,f)==1;
+}
+
+// load the page profiles from disk, the file format is
+//   magic, number of pages, then per page:
+//   key (8 bytes), number of entries (2 bytes), offsets (2 bytes each), counts (1 byte each)
+// all values little endian
+static void cache_profile_load(const std::string &path) {
+	cache_profile.pages.clear();
+	cache_profile.path=path;
+	cache_profile.enabled=!path.empty();
+	cache_profile.dirty=false;
+	cache_profile.hits=0;
+	if (!cache_profile.enabled) return;
+
+	FILE * f=fopen(path.c_str(),"rb");
+	if (f==NULL) return;	// no profiles yet, the file is created on exit
+
+	char magic[8];
+	uint8_t tmp[8];
+	if (!cache_profile_read(f,magic,8) || memcmp(magic,CACHE_PROFILE_MAGIC,8) ||
+		!cache_profile_read(f,tmp,4)) {
+		LOG_MSG("DYNREC:Ignoring invalid cache profile file %s",path.c_str());
+		fclose(f);
+		return;
+	}
+	Bitu pages=host_readd(tmp);
+	if (pages>CACHE_PROFILE_MAX) pages=CACHE_PROFILE_MAX;
+	for (Bitu p=0;p<pages;p++) {
+		if (!cache_profile_read(f,tmp,8)) break;
+		uint64_t key=host_readq(tmp);
+		if (!cache_profile_read(f,tmp,2)) break;
+		Bitu entries=host_readw(tmp);
+		if (entries>4096) break;
+
+		CacheProfileDynRec prof;
+		prof.offset.resize(entries);
+		prof.count.resize(entries);
+		bool ok=true;
+		for (Bitu i=0;i<entries && ok;i++) {
+			ok=cache_profile_read(f,tmp,2);
+			prof.offset[i]=host_readw(tmp)&4095;
+		}
+		if (ok && entries) ok=cache_profile_read(f,&prof.count[0],entries);
+		if (!ok) break;
+		cache_profile.pages[key]=prof;
+	}
+	fclose(f);
+	LOG_MSG("DYNREC:Loaded %lu code page profiles from %s",(unsigned long)cache_profile.pages.size(),path.c_str());
+}
+
+// collect the profiles of the pages still in use and write all profiles to disk
+static void cache_profile_save(void) {
+	if (!cache_profile.enabled) return;
+	if (cache_initialized) {
+		for (CodePageHandlerDynRec * cpage=cache.used_pages;cpage;cpage=cpage->next)
+			cpage->SaveProfile();
+	}
+	if (!cache_profile.dirty) return;
+
+	FILE * f=fopen(cache_profile.path.c_str(),"wb");
+	if (f==NULL) {
+		LOG_MSG("DYNREC:Unable to write cache profile file %s",cache_profile.path.c_str());
+		return;
+	}
+	uint8_t tmp[8];
+	bool ok=cache_profile_write(f,CACHE_PROFILE_MAGIC,8);
+	host_writed(tmp,(uint32_t)cache_profile.pages.size());
+	ok=ok && cache_profile_write(f,tmp,4);
+	for (std::map<uint64_t,CacheProfileDynRec>::const_iterator it=cache_profile.pages.begin();
+		ok && it!=cache_profile.pages.end();++it) {
+		const CacheProfileDynRec &prof=it->second;
+		host_writeq(tmp,it->first);
+		ok=cache_profile_write(f,tmp,8);
+		host_writew(tmp,(uint16_t)prof.offset.size());
+		ok=ok && cache_profile_write(f,tmp,2);
+		for (size_t i=0;ok && i<prof.offset.size();i++) {
+			host_writew(tmp,prof.offset[i]);
+			ok=cache_profile_write(f,tmp,2);
+		}
+		if (ok && !prof.count.empty()) ok=cache_profile_write(f,&prof.count[0],prof.count.size());
+	}
+	if (fclose(f)!=0) ok=false;
+	if (!ok) LOG_MSG("DYNREC:Error writing cache profile file %s",cache_profile.path.c_str());
+	else LOG_MSG("DYNREC:Saved %lu code page profiles (%lu reused this run)",
+		(unsigned long)cache_profile.pages.size(),(unsigned long)cache_profile.hits);
+	cache_profile.dirty=false;
+}
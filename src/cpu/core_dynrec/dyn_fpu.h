@@ -50,11 +50,32 @@ static void FPU_FFREE(Bitu st) {
 #include "../../fpu/fpu_instructions_x86.h"
 #elif defined(HAS_LONG_DOUBLE)
 #include "../../fpu/fpu_instructions_longdouble.h"
+#elif defined(HAS_FPU_SOFT80)
+#include "../../fpu/fpu_instructions_soft80.h"
 #else
 #include "../../fpu/fpu_instructions.h"
 #endif
 
 
+// st(FC_OP1) = st(FC_OP1) <op> st(FC_OP2) for the arithmetic instructions.
+// Backends that can do double precision arithmetic themselves emit it inline
+// when the double precision fpu core is used, everything else (and FADD, which
+// also updates the denormal flag) calls the fpu core function.
+#if defined(DRC_FPU_NATIVE_ARITH) && !(C_FPU_X86) && !defined(HAS_LONG_DOUBLE) && !defined(HAS_FPU_SOFT80)
+#define dyn_fpu_arith(native_op,reverse,func)					\
+	gen_fpu_arith(native_op,reverse,FC_OP1,FC_OP2,&fpu.regs[0],&fpu.use80[0])
+// the memory operand has been loaded into register 8
+#define dyn_fpu_arith_ea(native_op,reverse,func) {				\
+	gen_mov_dword_to_reg_imm(FC_OP2,8);						\
+	gen_fpu_arith(native_op,reverse,FC_OP1,FC_OP2,&fpu.regs[0],&fpu.use80[0]);	\
+}
+#else
+#define dyn_fpu_arith(native_op,reverse,func)					\
+	gen_call_function_RR(func,FC_OP1,FC_OP2)
+#define dyn_fpu_arith_ea(native_op,reverse,func)				\
+	gen_call_function_R(func,FC_OP1)
+#endif
+
 static INLINE void dyn_fpu_top() {
 	gen_mov_word_to_reg(FC_OP2,(void*)(&TOP),true);
 	gen_add_imm(FC_OP2,decode.modrm.rm);
@@ -77,7 +98,7 @@ static void dyn_eatree() {
 		gen_call_function_R(FPU_FADD_EA,FC_OP1);
 		break;
 	case 0x01:		// FMUL  ST,STi
-		gen_call_function_R(FPU_FMUL_EA,FC_OP1);
+		dyn_fpu_arith_ea(FPU_ARITH_MUL,false,FPU_FMUL_EA);
 		break;
 	case 0x02:		// FCOM  STi
 		gen_call_function_R(FPU_FCOM_EA,FC_OP1);
@@ -87,16 +108,16 @@ static void dyn_eatree() {
 		gen_call_function_raw(FPU_FPOP);
 		break;
 	case 0x04:		// FSUB  ST,STi
-		gen_call_function_R(FPU_FSUB_EA,FC_OP1);
+		dyn_fpu_arith_ea(FPU_ARITH_SUB,false,FPU_FSUB_EA);
 		break;	
 	case 0x05:		// FSUBR ST,STi
-		gen_call_function_R(FPU_FSUBR_EA,FC_OP1);
+		dyn_fpu_arith_ea(FPU_ARITH_SUB,true,FPU_FSUBR_EA);
 		break;
 	case 0x06:		// FDIV  ST,STi
-		gen_call_function_R(FPU_FDIV_EA,FC_OP1);
+		dyn_fpu_arith_ea(FPU_ARITH_DIV,false,FPU_FDIV_EA);
 		break;
 	case 0x07:		// FDIVR ST,STi
-		gen_call_function_R(FPU_FDIVR_EA,FC_OP1);
+		dyn_fpu_arith_ea(FPU_ARITH_DIV,true,FPU_FDIVR_EA);
 		break;
 	default:
 		break;
@@ -113,7 +134,7 @@ static void dyn_fpu_esc0(){
 			gen_call_function_RR(FPU_FADD,FC_OP1,FC_OP2);
 			break;
 		case 0x01:		// FMUL  ST,STi
-			gen_call_function_RR(FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_MUL,false,FPU_FMUL);
 			break;
 		case 0x02:		// FCOM  STi
 			gen_call_function_RR(FPU_FCOM,FC_OP1,FC_OP2);
@@ -123,16 +144,16 @@ static void dyn_fpu_esc0(){
 			gen_call_function_raw(FPU_FPOP);
 			break;
 		case 0x04:		// FSUB  ST,STi
-			gen_call_function_RR(FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,false,FPU_FSUB);
 			break;	
 		case 0x05:		// FSUBR ST,STi
-			gen_call_function_RR(FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,true,FPU_FSUBR);
 			break;
 		case 0x06:		// FDIV  ST,STi
-			gen_call_function_RR(FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,false,FPU_FDIV);
 			break;
 		case 0x07:		// FDIVR ST,STi
-			gen_call_function_RR(FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,true,FPU_FDIVR);
 			break;
 		default:
 			break;
@@ -443,7 +464,7 @@ static void dyn_fpu_esc4(){
 			break;
 		case 0x01:	/* FMUL STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_MUL,false,FPU_FMUL);
 			break;
 		case 0x02:  /* FCOM*/
 			dyn_fpu_top();
@@ -456,19 +477,19 @@ static void dyn_fpu_esc4(){
 			break;
 		case 0x04:  /* FSUBR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,true,FPU_FSUBR);
 			break;
 		case 0x05:  /* FSUB  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,false,FPU_FSUB);
 			break;
 		case 0x06:  /* FDIVR STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,true,FPU_FDIVR);
 			break;
 		case 0x07:  /* FDIV STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,false,FPU_FDIV);
 			break;
 		default:
 			break;
@@ -563,7 +584,7 @@ static void dyn_fpu_esc6(){
 			break;
 		case 0x01:	/* FMULP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FMUL,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_MUL,false,FPU_FMUL);
 			break;
 		case 0x02:  /* FCOMP5*/
 			dyn_fpu_top();
@@ -583,19 +604,19 @@ static void dyn_fpu_esc6(){
 			break;
 		case 0x04:  /* FSUBRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FSUBR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,true,FPU_FSUBR);
 			break;
 		case 0x05:  /* FSUBP  STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FSUB,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_SUB,false,FPU_FSUB);
 			break;
 		case 0x06:	/* FDIVRP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FDIVR,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,true,FPU_FDIVR);
 			break;
 		case 0x07:  /* FDIVP STi,ST*/
 			dyn_fpu_top_swapped();
-			gen_call_function_RR(FPU_FDIV,FC_OP1,FC_OP2);
+			dyn_fpu_arith(FPU_ARITH_DIV,false,FPU_FDIV);
 			break;
 		default:
 			break;
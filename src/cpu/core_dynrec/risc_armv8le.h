@@ -340,6 +340,22 @@ typedef uint8_t HostReg;
 // ubfm dst, src, #rimm, #simm		@	0 <= rimm < 64, 0 <= simm < 64
 #define UBFM64(dst, src, rimm, simm) (0xd3400000 + (dst) + ((src) << 5) + ((rimm) << 16) + ((simm) << 10) )
 
+// floating point (double precision, dst/src are simd&fp register numbers)
+// ldr dst, [addr1, addr2, lsl #3]
+#define LDR_D_REG_LSL3(dst, addr1, addr2) (0xfc607800 + (dst) + ((addr1) << 5) + ((addr2) << 16) )
+// str src, [addr1, addr2, lsl #3]
+#define STR_D_REG_LSL3(src, addr1, addr2) (0xfc207800 + (src) + ((addr1) << 5) + ((addr2) << 16) )
+// strb src, [addr1, addr2]
+#define STRB_REG(src, addr1, addr2) (0x38206800 + (src) + ((addr1) << 5) + ((addr2) << 16) )
+// fadd dst, src1, src2
+#define FADD_D(dst, src1, src2) (0x1e602800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fsub dst, src1, src2
+#define FSUB_D(dst, src1, src2) (0x1e603800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fmul dst, src1, src2
+#define FMUL_D(dst, src1, src2) (0x1e600800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+// fdiv dst, src1, src2
+#define FDIV_D(dst, src1, src2) (0x1e601800 + (dst) + ((src1) << 5) + ((src2) << 16) )
+
 
 // move a full register from reg_src to reg_dst
 static void gen_mov_regs(HostReg reg_dst,HostReg reg_src) {
@@ -1241,3 +1257,42 @@ static void gen_mov_regbyte_from_reg_low(HostReg src_reg,Bitu index) {
 }
 
 #endif
+
+
+// x87 arithmetic done inline on the double precision fpu registers (see dyn_fpu.h)
+#define DRC_FPU_NATIVE_ARITH
+
+enum FPUArithOps {
+	FPU_ARITH_ADD,FPU_ARITH_SUB,
+	FPU_ARITH_MUL,FPU_ARITH_DIV
+};
+
+// regs[op1] = regs[op1] <op> regs[op2] (regs[op2] <op> regs[op1] if reverse is set),
+// op1 and op2 hold the register indices (zero extended), use80[op1] is cleared.
+// d0/d1 are caller saved and not used by the generated code otherwise
+static void gen_fpu_arith(FPUArithOps op,bool reverse,HostReg op1,HostReg op2,void* regs,void* use80) {
+	gen_mov_qword_to_reg_imm(temp1, (uint64_t)regs);
+	cache_addd( LDR_D_REG_LSL3(0, temp1, op1) );      // ldr d0, [temp1, op1, lsl #3]
+	cache_addd( LDR_D_REG_LSL3(1, temp1, op2) );      // ldr d1, [temp1, op2, lsl #3]
+	HostReg src1=reverse?1:0;
+	HostReg src2=reverse?0:1;
+	switch (op) {
+		case FPU_ARITH_ADD:
+			cache_addd( FADD_D(0, src1, src2) );      // fadd d0, src1, src2
+			break;
+		case FPU_ARITH_SUB:
+			cache_addd( FSUB_D(0, src1, src2) );      // fsub d0, src1, src2
+			break;
+		case FPU_ARITH_MUL:
+			cache_addd( FMUL_D(0, src1, src2) );      // fmul d0, src1, src2
+			break;
+		case FPU_ARITH_DIV:
+			cache_addd( FDIV_D(0, src1, src2) );      // fdiv d0, src1, src2
+			break;
+		default:
+			E_Exit("gen_fpu_arith: unknown operation %d",(int)op);
+	}
+	cache_addd( STR_D_REG_LSL3(0, temp1, op1) );      // str d0, [temp1, op1, lsl #3]
+	gen_mov_qword_to_reg_imm(temp2, (uint64_t)use80);
+	cache_addd( STRB_REG(HOST_wzr, temp2, op1) );     // strb wzr, [temp2, op1]
+}
@@ -75,6 +75,26 @@ Bitu cycle_count;
 
 #define CPU_TRAP_DECODER	CPU_Core_Normal_Trap_Run
 
+/* Threaded dispatch: jump to the opcode through a table of label addresses
+ * (a GCC/Clang extension) instead of the large switch. This gives every opcode
+ * its own indirect branch, which host branch predictors handle much better.
+ * The switch is kept and is still used the first time each opcode is seen,
+ * and with compilers that do not support labels as values (MSVC).
+ *
+ * The learning code sits in front of each opcode label, so it only runs when
+ * the opcode came in through the switch: once per table entry. Jumps through
+ * the table land behind it. threaded_learn is set by the switch path and
+ * cleared by the first case reached, so a case body falling through into the
+ * next case does not store the wrong label. */
+#if C_CORE_THREADED && defined(__GNUC__)
+#define CPU_CORE_THREADED 1
+#define THREADED_LEARN(_LABEL)						\
+	if (GCC_UNLIKELY(threaded_learn)) {				\
+		threaded_table[dispatch]=&&_LABEL;			\
+		threaded_learn=false;						\
+	}
+#endif
+
 #define OPCODE_NONE			0x000u
 #define OPCODE_0F			0x100u
 #define OPCODE_SIZE			0x200u
@@ -114,12 +134,29 @@ static struct {
 	bool rep_zero;
 	Bitu prefixes;
 	GetEAHandler * ea_table;
+	HostPt fetch_host;		// host pointer of the code page (as returned by the TLB), NULL if not directly readable
+	PhysPt fetch_lin;		// linear address of the code page
 } core;
 
+/* Code fetch window. The TLB is consulted once whenever CS:EIP is (re)loaded
+ * instead of once for every opcode, ModRM, SIB, displacement and immediate byte.
+ * Fetches read the same host memory the TLB points to, so writes to the code
+ * (self-modifying code) are seen exactly as before. Fetches outside the page,
+ * or from pages without a direct host mapping, go through LoadMb() and friends
+ * so page faults and memory mapped I/O behave as before. */
+static INLINE void FetchSetup() {
+	core.fetch_lin=core.cseip&~((PhysPt)0xfffu);
+	core.fetch_host=get_tlb_read(core.cseip);
+}
+
+static INLINE bool FetchInWindow(const PhysPt len) {
+	return core.fetch_host!=NULL && (PhysPt)(core.cseip-core.fetch_lin)<=(PhysPt)(4096u-len);
+}
+
 /* FIXME: Someone at Microsoft tell how subtracting PhysPt - PhysPt = __int64, or PhysPt + PhysPt = __int64 */
 #define GETIP		((PhysPt)(core.cseip-SegBase(cs)))
 #define SAVEIP		reg_eip=GETIP;
-#define LOADIP		core.cseip=((PhysPt)(SegBase(cs)+reg_eip));
+#define LOADIP		core.cseip=((PhysPt)(SegBase(cs)+reg_eip));FetchSetup();
 
 #define SegBase(c)	SegPhys(c)
 #define BaseDS		core.base_ds
@@ -130,23 +167,30 @@ static INLINE void FetchDiscardb() {
 }
 
 static INLINE uint8_t FetchPeekb() {
+	if (GCC_LIKELY(FetchInWindow(1))) return host_readb(core.fetch_host+core.cseip);
 	uint8_t temp=LoadMb(core.cseip);
 	return temp;
 }
 
 static INLINE uint8_t Fetchb() {
-	uint8_t temp=LoadMb(core.cseip);
+	uint8_t temp;
+	if (GCC_LIKELY(FetchInWindow(1))) temp=host_readb(core.fetch_host+core.cseip);
+	else temp=LoadMb(core.cseip);
 	core.cseip+=1;
 	return temp;
 }
 
 static INLINE uint16_t Fetchw() {
-	uint16_t temp=LoadMw(core.cseip);
+	uint16_t temp;
+	if (GCC_LIKELY(FetchInWindow(2))) temp=host_readw(core.fetch_host+core.cseip);
+	else temp=LoadMw(core.cseip);
 	core.cseip+=2;
 	return temp;
 }
 static INLINE uint32_t Fetchd() {
-	uint32_t temp=LoadMd(core.cseip);
+	uint32_t temp;
+	if (GCC_LIKELY(FetchInWindow(4))) temp=host_readd(core.fetch_host+core.cseip);
+	else temp=LoadMd(core.cseip);
 	core.cseip+=4;
 	return temp;
 }
@@ -163,10 +207,29 @@ static INLINE uint32_t Fetchd() {
 
 #define EALookupTable (core.ea_table)
 
+/* labels as values are an extension, -Wpedantic warns about every use */
+#if defined(CPU_CORE_THREADED)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
 Bits CPU_Core_Normal_Run(void) {
     if (CPU_Cycles <= 0)
 	    return CBRET_NONE;
 
+#if defined(CPU_CORE_THREADED)
+	static void * threaded_table[OPCODE_0F+OPCODE_SIZE+0x100u];
+	static bool threaded_init=false;
+	bool threaded_learn=false;
+	Bitu dispatch;
+
+	if (GCC_UNLIKELY(!threaded_init)) {
+		for (Bitu i=0;i<(OPCODE_0F+OPCODE_SIZE+0x100u);i++)
+			threaded_table[i]=&&dispatch_switch;
+		threaded_init=true;
+	}
+#endif
+
 	while (CPU_Cycles-->0) {
 		LOADIP;
 		core.opcode_index=cpu.code.big*(Bitu)0x200u;
@@ -185,7 +248,15 @@ Bits CPU_Core_Normal_Run(void) {
 #endif
 		cycle_count++;
 restart_opcode:
+#if defined(CPU_CORE_THREADED)
+		dispatch=core.opcode_index+Fetchb();
+		goto *threaded_table[dispatch];
+dispatch_switch:
+		threaded_learn=true;
+		switch (dispatch) {
+#else
 		switch (core.opcode_index+Fetchb()) {
+#endif
 		#include "core_normal/prefix_none.h"
 		#include "core_normal/prefix_0f.h"
 		#include "core_normal/prefix_66.h"
@@ -226,6 +297,10 @@ decode_end:
 	return CBRET_NONE;
 }
 
+#if defined(CPU_CORE_THREADED)
+#pragma GCC diagnostic pop
+#endif
+
 Bits CPU_Core_Normal_Trap_Run(void) {
 	Bits oldCycles = CPU_Cycles;
 	CPU_Cycles = 1;
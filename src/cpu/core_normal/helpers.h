@@ -141,30 +141,61 @@
 	}																		\
 }
 
-#define CASE_W(_WHICH)							\
+/* With threaded dispatch (see CPU_CORE_THREADED in core_normal.cpp) every case
+ * also gets a label. The first time an opcode is dispatched through the switch
+ * the label is stored in the dispatch table, after that the core jumps to it
+ * directly. Cores without threaded dispatch just get the case labels. */
+#if defined(CPU_CORE_THREADED)
+# define CASE_LABEL(_NAME)						\
+	THREADED_LEARN(op_##_NAME) op_##_NAME:
+#else
+# define CASE_LABEL(_NAME)
+#endif
+
+#define CASE_W_ONLY(_WHICH)						\
 	case (OPCODE_NONE+_WHICH):
 
 #if CPU_CORE >= CPU_ARCHTYPE_386
-# define CASE_D(_WHICH)							\
+# define CASE_D_ONLY(_WHICH)					\
 	case (OPCODE_SIZE+_WHICH):
 #else
+# define CASE_D_ONLY(_WHICH)
+#endif
+
+#define CASE_0F_W_ONLY(_WHICH)					\
+	case ((OPCODE_0F|OPCODE_NONE)+_WHICH):
+
+#if CPU_CORE >= CPU_ARCHTYPE_386
+# define CASE_0F_D_ONLY(_WHICH)					\
+	case ((OPCODE_0F|OPCODE_SIZE)+_WHICH):
+#else
+# define CASE_0F_D_ONLY(_WHICH)
+#endif
+
+#define CASE_W(_WHICH)							\
+	CASE_W_ONLY(_WHICH) CASE_LABEL(W_##_WHICH)
+
+#if CPU_CORE >= CPU_ARCHTYPE_386
+# define CASE_D(_WHICH)							\
+	CASE_D_ONLY(_WHICH) CASE_LABEL(D_##_WHICH)
+#else
 # define CASE_D(_WHICH)
 #endif
 
 #define CASE_B(_WHICH)							\
-	CASE_W(_WHICH)								\
-	CASE_D(_WHICH)
+	CASE_W_ONLY(_WHICH)							\
+	CASE_D_ONLY(_WHICH) CASE_LABEL(B_##_WHICH)
 
 #define CASE_0F_W(_WHICH)						\
-	case ((OPCODE_0F|OPCODE_NONE)+_WHICH):
+	CASE_0F_W_ONLY(_WHICH) CASE_LABEL(0F_W_##_WHICH)
 
 #if CPU_CORE >= CPU_ARCHTYPE_386
 # define CASE_0F_D(_WHICH)						\
-	case ((OPCODE_0F|OPCODE_SIZE)+_WHICH):
+	CASE_0F_D_ONLY(_WHICH) CASE_LABEL(0F_D_##_WHICH)
 #else
 # define CASE_0F_D(_WHICH)
 #endif
 
 #define CASE_0F_B(_WHICH)						\
-	CASE_0F_W(_WHICH)							\
-	CASE_0F_D(_WHICH)
+	CASE_0F_W_ONLY(_WHICH)						\
+	CASE_0F_D_ONLY(_WHICH) CASE_LABEL(0F_B_##_WHICH)
@@ -179,6 +179,7 @@ void CPU_Core_Dyn_X86_Cache_Reset(void);
 void CPU_Core_Dynrec_Init(void);
 void CPU_Core_Dynrec_Cache_Init(bool enable_cache);
 void CPU_Core_Dynrec_Cache_Close(void);
+void CPU_Core_Dynrec_Cache_ProfileFile(const std::string &path);
 void CPU_Core_Dynrec_Cache_Reset(void);
 #endif
 
@@ -3294,6 +3295,10 @@ public:
 		dynamic_core_cache_block_size = section->Get_int("dynamic core cache block size");
 		if (dynamic_core_cache_block_size < 1 || dynamic_core_cache_block_size > 65536) dynamic_core_cache_block_size = 32;
 
+#if (C_DYNREC)
+		CPU_Core_Dynrec_Cache_ProfileFile(section->Get_string("dynamic core smc profile file"));
+#endif
+
 		Prop_multival* p = section->Get_multival("cycles");
 		std::string type = p->GetSection()->Get_string("type");
 		std::string str ;
@@ -27,7 +27,7 @@
 #if C_FPU
 
 MMX_reg *reg_mmx[8] = {
-#if defined(HAS_LONG_DOUBLE)
+#if defined(HAS_LONG_DOUBLE) || defined(HAS_FPU_SOFT80)
 	&fpu._do_not_use__regs[0].reg_mmx,
 	&fpu._do_not_use__regs[1].reg_mmx,
 	&fpu._do_not_use__regs[2].reg_mmx,
@@ -342,10 +342,10 @@ class PageFoilHandler : public PageHandler {
 private:
 	void work(PhysPt addr) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 			
 		// set the page dirty in the tlb
-		paging.tlb.phys_page[lin_page] |= PHYSPAGE_DITRY;
+		TLB_PHYS_PAGE(lin_page) |= PHYSPAGE_DITRY;
 
 		// mark the page table entry dirty
 		X86PageEntry dir_entry, table_entry;
@@ -380,9 +380,9 @@ private:
 		
 		// replace this handler with the real thing
 		if (handler->getFlags() & PFLAG_WRITEABLE)
-			paging.tlb.write[lin_page] = handler->GetHostWritePt(phys_page) - (lin_page << 12);
-		else paging.tlb.write[lin_page]=0;
-		paging.tlb.writehandler[lin_page]=handler;
+			TLB_WRITE(lin_page) = handler->GetHostWritePt(phys_page) - (lin_page << 12);
+		else TLB_WRITE(lin_page)=0;
+		TLB_WRITEHANDLER(lin_page)=handler;
 
 		return;
 	}
@@ -437,7 +437,7 @@ class ExceptionPageHandler : public PageHandler {
 private:
 	PageHandler* getHandler(PhysPt addr) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		return handler;
 					}
@@ -450,7 +450,7 @@ private:
 		// the exception happens. Here we have gazillions of TLB entries so the
 		// exception occurs if we don't check for it.
 
-		Bitu old_attirbs = paging.tlb.phys_page[addr>>12] >> 30;
+		Bitu old_attirbs = TLB_PHYS_PAGE(addr>>12) >> 30;
 		X86PageEntry dir_entry, table_entry;
 		
 		dir_entry.load = phys_readd(GetPageDirectoryEntryAddr(addr));
@@ -485,7 +485,7 @@ private:
 
 	uint8_t readb_through(PhysPt addr) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_READABLE) {
 			return host_readb(handler->GetHostReadPt(phys_page) + (addr&0xfff));
@@ -494,7 +494,7 @@ private:
 					}
 	uint16_t readw_through(PhysPt addr) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_READABLE) {
 			return host_readw(handler->GetHostReadPt(phys_page) + (addr&0xfff));
@@ -503,7 +503,7 @@ private:
 			}
 	uint32_t readd_through(PhysPt addr) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_READABLE) {
 			return host_readd(handler->GetHostReadPt(phys_page) + (addr&0xfff));
@@ -513,7 +513,7 @@ private:
 
 	void writeb_through(PhysPt addr, uint8_t val) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_WRITEABLE) {
 			return host_writeb(handler->GetHostWritePt(phys_page) + (addr&0xfff), val);
@@ -523,7 +523,7 @@ private:
 
 	void writew_through(PhysPt addr, uint16_t val) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_WRITEABLE) {
 			return host_writew(handler->GetHostWritePt(phys_page) + (addr&0xfff), val);
@@ -533,7 +533,7 @@ private:
 
 	void writed_through(PhysPt addr, uint32_t val) {
 		Bitu lin_page = addr >> 12;
-		uint32_t phys_page = paging.tlb.phys_page[lin_page] & PHYSPAGE_ADDR;
+		uint32_t phys_page = TLB_PHYS_PAGE(lin_page) & PHYSPAGE_ADDR;
 		PageHandler* handler = MEM_GetPageHandler(phys_page);
 		if (handler->getFlags() & PFLAG_WRITEABLE) {
 			return host_writed(handler->GetHostWritePt(phys_page) + (addr&0xfff), val);
@@ -907,18 +907,86 @@ Bitu PAGING_GetDirBase(void) {
 }
 
 #if defined(USE_FULL_TLB)
+static INLINE void PAGING_ResetTLBEntry(Bitu lin_page) {
+	paging.tlb.read[lin_page]=0;
+	paging.tlb.write[lin_page]=0;
+	paging.tlb.readhandler[lin_page]=&init_page_handler;
+	paging.tlb.writehandler[lin_page]=&init_page_handler;
+}
+
 void PAGING_InitTLB(void) {
-	for (Bitu i=0;i<TLB_SIZE;i++) {
-		paging.tlb.read[i]=0;
-		paging.tlb.write[i]=0;
-		paging.tlb.readhandler[i]=&init_page_handler;
-		paging.tlb.writehandler[i]=&init_page_handler;
+	for (Bitu i=0;i<TLB_SIZE;i++) PAGING_ResetTLBEntry(i);
+	paging.ur_links.used=0;
+	paging.krw_links.used=0;
+	paging.kr_links.used=0;
+	paging.links.used=0;
+}
+#else
+static INLINE void InitTLBInt(tlb_entry *bank) {
+	for (Bitu i=0;i<TLB_BANK_SIZE;i++) {
+		bank[i].read=0;
+		bank[i].write=0;
+		bank[i].readhandler=&init_page_handler;
+		bank[i].writehandler=&init_page_handler;
+		bank[i].phys_page=0;
 	}
+}
+
+tlb_entry *PAGING_InitTLBBank(Bitu bank) {
+	tlb_entry *entries=(tlb_entry *)malloc(sizeof(tlb_entry)*TLB_BANK_SIZE);
+	if (!entries) E_Exit("Out of Memory");
+	InitTLBInt(entries);
+	paging.tlbh_banks[bank]=entries;
+	paging.tlbh_idle[bank]=0;
+	paging.tlbh_alloc[paging.tlbh_alloc_used++]=(uint16_t)bank;
+	return entries;
+}
+
+/* Called on a full flush, once every linked entry has been reset. Banks
+ * stay allocated across flushes so a context switch does not have to
+ * allocate them again, but banks no page was linked in for TLB_BANK_IDLE
+ * flushes are given back, so address spaces that went away do not keep
+ * their banks forever. */
+static void PAGING_ReleaseIdleTLBBanks(void) {
+	for (Bitu i=0;i<paging.tlbh_alloc_used;) {
+		const Bitu bank=paging.tlbh_alloc[i];
+		if (++paging.tlbh_idle[bank] < TLB_BANK_IDLE) {
+			i++;
+			continue;
+		}
+		free(paging.tlbh_banks[bank]);
+		paging.tlbh_banks[bank]=paging.tlbh_blank;
+		paging.tlbh_alloc[i]=paging.tlbh_alloc[--paging.tlbh_alloc_used];
+	}
+}
+
+static INLINE void PAGING_ResetTLBEntry(Bitu lin_page) {
+	tlb_entry *bank=paging.tlbh_banks[lin_page >> TLB_BANK_SHIFT];
+	if (bank == paging.tlbh_blank) return; // nothing was ever linked here
+	paging.tlbh_idle[lin_page >> TLB_BANK_SHIFT]=0;
+	tlb_entry *entry=&bank[lin_page & TLB_BANK_MASK];
+	entry->read=0;
+	entry->write=0;
+	entry->readhandler=&init_page_handler;
+	entry->writehandler=&init_page_handler;
+}
+
+void PAGING_InitTLB(void) {
+	InitTLBInt(paging.tlbh);
+	InitTLBInt(paging.tlbh_blank);
+	paging.tlbh_banks[0]=paging.tlbh;
+	for (Bitu i=1;i<TLB_BANKS;i++) {
+		if (paging.tlbh_banks[i] && paging.tlbh_banks[i] != paging.tlbh_blank)
+			free(paging.tlbh_banks[i]);
+		paging.tlbh_banks[i]=paging.tlbh_blank;
+	}
+	paging.tlbh_alloc_used=0;
 	paging.ur_links.used=0;
 	paging.krw_links.used=0;
 	paging.kr_links.used=0;
 	paging.links.used=0;
 }
+#endif
 
 void PAGING_ClearTLB(void) {
 //	LOG_MSG("CLEAR                          m% 4u, kr% 4u, krw% 4u, ur% 4u",
@@ -927,11 +995,11 @@ void PAGING_ClearTLB(void) {
 	uint32_t * entries=&paging.links.entries[0];
 	for (;paging.links.used>0;paging.links.used--) {
 		Bitu page=*entries++;
-		paging.tlb.read[page]=0;
-		paging.tlb.write[page]=0;
-		paging.tlb.readhandler[page]=&init_page_handler;
-		paging.tlb.writehandler[page]=&init_page_handler;
+		PAGING_ResetTLBEntry(page);
 	}
+#if !defined(USE_FULL_TLB)
+	PAGING_ReleaseIdleTLBBanks();
+#endif
 	paging.ur_links.used=0;
 	paging.krw_links.used=0;
 	paging.kr_links.used=0;
@@ -940,10 +1008,7 @@ void PAGING_ClearTLB(void) {
 
 void PAGING_UnlinkPages(Bitu lin_page,Bitu pages) {
 	for (;pages>0;pages--) {
-		paging.tlb.read[lin_page]=0;
-		paging.tlb.write[lin_page]=0;
-		paging.tlb.readhandler[lin_page]=&init_page_handler;
-		paging.tlb.writehandler[lin_page]=&init_page_handler;
+		PAGING_ResetTLBEntry(lin_page);
 		lin_page++;
 	}
 }
@@ -951,10 +1016,7 @@ void PAGING_UnlinkPages(Bitu lin_page,Bitu pages) {
 void PAGING_MapPage(Bitu lin_page,Bitu phys_page) {
 	if (lin_page<LINK_START) {
 		paging.firstmb[lin_page]=(uint32_t)phys_page;
-		paging.tlb.read[lin_page]=0;
-		paging.tlb.write[lin_page]=0;
-		paging.tlb.readhandler[lin_page]=&init_page_handler;
-		paging.tlb.writehandler[lin_page]=&init_page_handler;
+		PAGING_ResetTLBEntry(lin_page);
 	} else {
 		PAGING_LinkPage(lin_page,phys_page);
 	}
@@ -981,41 +1043,41 @@ static void PAGING_LinkPageNew(Bitu lin_page, Bitu phys_page, Bitu linkmode, boo
 	// bit31-30 ACMAP_
 	// bit29	dirty
 	// these bits are shifted off at the places paging.tlb.phys_page is read
-	paging.tlb.phys_page[lin_page]= (uint32_t)(phys_page | (linkmode<< 30) | (dirty? PHYSPAGE_DITRY:0));
+	TLB_PHYS_PAGE(lin_page)= (uint32_t)(phys_page | (linkmode<< 30) | (dirty? PHYSPAGE_DITRY:0));
 	switch(outcome) {
 	case ACMAP_RW:
 		// read
-		if (handler->getFlags() & PFLAG_READABLE) paging.tlb.read[lin_page] = 
+		if (handler->getFlags() & PFLAG_READABLE) TLB_READ(lin_page) = 
 			handler->GetHostReadPt(phys_page)-lin_base;
-	else paging.tlb.read[lin_page]=0;
-	paging.tlb.readhandler[lin_page]=handler;
+	else TLB_READ(lin_page)=0;
+	TLB_READHANDLER(lin_page)=handler;
 		
 		// write
 		if (dirty) { // in case it is already dirty we don't need to check
-			if (handler->getFlags() & PFLAG_WRITEABLE) paging.tlb.write[lin_page] = 
+			if (handler->getFlags() & PFLAG_WRITEABLE) TLB_WRITE(lin_page) = 
 				handler->GetHostWritePt(phys_page)-lin_base;
-			else paging.tlb.write[lin_page]=0;
-	paging.tlb.writehandler[lin_page]=handler;
+			else TLB_WRITE(lin_page)=0;
+	TLB_WRITEHANDLER(lin_page)=handler;
 		} else {
-			paging.tlb.writehandler[lin_page]= &foiling_handler;
-			paging.tlb.write[lin_page]=0;
+			TLB_WRITEHANDLER(lin_page)= &foiling_handler;
+			TLB_WRITE(lin_page)=0;
 		}
 		break;
 	case ACMAP_RE:
 		// read
-		if (handler->getFlags() & PFLAG_READABLE) paging.tlb.read[lin_page] = 
+		if (handler->getFlags() & PFLAG_READABLE) TLB_READ(lin_page) = 
 			handler->GetHostReadPt(phys_page)-lin_base;
-		else paging.tlb.read[lin_page]=0;
-		paging.tlb.readhandler[lin_page]=handler;
+		else TLB_READ(lin_page)=0;
+		TLB_READHANDLER(lin_page)=handler;
 		// exception
-		paging.tlb.writehandler[lin_page]= &exception_handler;
-		paging.tlb.write[lin_page]=0;
+		TLB_WRITEHANDLER(lin_page)= &exception_handler;
+		TLB_WRITE(lin_page)=0;
 		break;
 	case ACMAP_EE:
-		paging.tlb.readhandler[lin_page]= &exception_handler;
-		paging.tlb.writehandler[lin_page]= &exception_handler;
-		paging.tlb.read[lin_page]=0;
-		paging.tlb.write[lin_page]=0;
+		TLB_READHANDLER(lin_page)= &exception_handler;
+		TLB_WRITEHANDLER(lin_page)= &exception_handler;
+		TLB_READ(lin_page)=0;
+		TLB_WRITE(lin_page)=0;
 		break;
 }
 
@@ -1047,15 +1109,15 @@ void PAGING_LinkPage(Bitu lin_page,Bitu phys_page) {
 		PAGING_ClearTLB();
 	}
 
-	paging.tlb.phys_page[lin_page]= (uint32_t)phys_page;
-	if (handler->getFlags() & PFLAG_READABLE) paging.tlb.read[lin_page]=handler->GetHostReadPt(phys_page)-lin_base;
-	else paging.tlb.read[lin_page]=0;
-	if (handler->getFlags() & PFLAG_WRITEABLE) paging.tlb.write[lin_page]=handler->GetHostWritePt(phys_page)-lin_base;
-	else paging.tlb.write[lin_page]=0;
+	TLB_PHYS_PAGE(lin_page)= (uint32_t)phys_page;
+	if (handler->getFlags() & PFLAG_READABLE) TLB_READ(lin_page)=handler->GetHostReadPt(phys_page)-lin_base;
+	else TLB_READ(lin_page)=0;
+	if (handler->getFlags() & PFLAG_WRITEABLE) TLB_WRITE(lin_page)=handler->GetHostWritePt(phys_page)-lin_base;
+	else TLB_WRITE(lin_page)=0;
 
 	paging.links.entries[paging.links.used++]= (uint32_t)lin_page;
-	paging.tlb.readhandler[lin_page]=handler;
-	paging.tlb.writehandler[lin_page]=handler;
+	TLB_READHANDLER(lin_page)=handler;
+	TLB_WRITEHANDLER(lin_page)=handler;
 }
 
 // parameter is the new cpl mode
@@ -1071,36 +1133,36 @@ void PAGING_SwitchCPL(bool isUser) {
 		// sv -> us: rw -> ee 
 		for(Bitu i = 0; i < paging.krw_links.used; i++) {
 			Bitu tlb_index = paging.krw_links.entries[i];
-			paging.tlb.readhandler[tlb_index] = &exception_handler;
-			paging.tlb.writehandler[tlb_index] = &exception_handler;
-			paging.tlb.read[tlb_index] = 0;
-			paging.tlb.write[tlb_index] = 0;
+			TLB_READHANDLER(tlb_index) = &exception_handler;
+			TLB_WRITEHANDLER(tlb_index) = &exception_handler;
+			TLB_READ(tlb_index) = 0;
+			TLB_WRITE(tlb_index) = 0;
 		}
 	} else {
 		// us -> sv: ee -> rw
 		for(Bitu i = 0; i < paging.krw_links.used; i++) {
 			Bitu tlb_index = paging.krw_links.entries[i];
-			Bitu phys_page = paging.tlb.phys_page[tlb_index];
+			Bitu phys_page = TLB_PHYS_PAGE(tlb_index);
 			Bitu lin_base = tlb_index << 12;
 			bool dirty = (phys_page & PHYSPAGE_DITRY)? true:false;
 			phys_page &= PHYSPAGE_ADDR;
 			PageHandler* handler = MEM_GetPageHandler(phys_page);
 			
 			// map read handler
-			paging.tlb.readhandler[tlb_index] = handler;
+			TLB_READHANDLER(tlb_index) = handler;
 			if (handler->getFlags()&PFLAG_READABLE)
-				paging.tlb.read[tlb_index] = handler->GetHostReadPt(phys_page)-lin_base;
-			else paging.tlb.read[tlb_index] = 0;
+				TLB_READ(tlb_index) = handler->GetHostReadPt(phys_page)-lin_base;
+			else TLB_READ(tlb_index) = 0;
 			
 			// map write handler
 			if (dirty) {
-				paging.tlb.writehandler[tlb_index] = handler;
+				TLB_WRITEHANDLER(tlb_index) = handler;
 				if (handler->getFlags()&PFLAG_WRITEABLE)
-					paging.tlb.write[tlb_index] = handler->GetHostWritePt(phys_page)-lin_base;
-				else paging.tlb.write[tlb_index] = 0;
+					TLB_WRITE(tlb_index) = handler->GetHostWritePt(phys_page)-lin_base;
+				else TLB_WRITE(tlb_index) = 0;
 			} else {
-				paging.tlb.writehandler[tlb_index] = &foiling_handler;
-				paging.tlb.write[tlb_index] = 0;
+				TLB_WRITEHANDLER(tlb_index) = &foiling_handler;
+				TLB_WRITE(tlb_index) = 0;
 			}
 		}
 	}
@@ -1112,21 +1174,21 @@ void PAGING_SwitchCPL(bool isUser) {
 			// sv -> us: re -> ee 
 			for(Bitu i = 0; i < paging.kr_links.used; i++) {
 				Bitu tlb_index = paging.kr_links.entries[i];
-				paging.tlb.readhandler[tlb_index] = &exception_handler;
-				paging.tlb.read[tlb_index] = 0;
+				TLB_READHANDLER(tlb_index) = &exception_handler;
+				TLB_READ(tlb_index) = 0;
 			}
 		} else {
 			// us -> sv: ee -> re
 			for(Bitu i = 0; i < paging.kr_links.used; i++) {
 				Bitu tlb_index = paging.kr_links.entries[i];
 				Bitu lin_base = tlb_index << 12;
-				Bitu phys_page = paging.tlb.phys_page[tlb_index] & PHYSPAGE_ADDR;
+				Bitu phys_page = TLB_PHYS_PAGE(tlb_index) & PHYSPAGE_ADDR;
 				PageHandler* handler = MEM_GetPageHandler(phys_page);
 
-				paging.tlb.readhandler[tlb_index] = handler;
+				TLB_READHANDLER(tlb_index) = handler;
 				if (handler->getFlags()&PFLAG_READABLE)
-					paging.tlb.read[tlb_index] = handler->GetHostReadPt(phys_page)-lin_base;
-				else paging.tlb.read[tlb_index] = 0;
+					TLB_READ(tlb_index) = handler->GetHostReadPt(phys_page)-lin_base;
+				else TLB_READ(tlb_index) = 0;
 			}
 		}
 	} else { // WP=0
@@ -1135,137 +1197,33 @@ void PAGING_SwitchCPL(bool isUser) {
 			// sv -> us: rw -> re 
 			for(Bitu i = 0; i < paging.ur_links.used; i++) {
 				Bitu tlb_index = paging.ur_links.entries[i];
-				paging.tlb.writehandler[tlb_index] = &exception_handler;
-				paging.tlb.write[tlb_index] = 0;
+				TLB_WRITEHANDLER(tlb_index) = &exception_handler;
+				TLB_WRITE(tlb_index) = 0;
 			}
 		} else {
 			// us -> sv: re -> rw
 			for(Bitu i = 0; i < paging.ur_links.used; i++) {
 				Bitu tlb_index = paging.ur_links.entries[i];
-				Bitu phys_page = paging.tlb.phys_page[tlb_index];
+				Bitu phys_page = TLB_PHYS_PAGE(tlb_index);
 				bool dirty = (phys_page & PHYSPAGE_DITRY)? true:false;
 				phys_page &= PHYSPAGE_ADDR;
 				PageHandler* handler = MEM_GetPageHandler(phys_page);
 
 				if (dirty) {
 					Bitu lin_base = tlb_index << 12;
-					paging.tlb.writehandler[tlb_index] = handler;
+					TLB_WRITEHANDLER(tlb_index) = handler;
 					if (handler->getFlags()&PFLAG_WRITEABLE)
-						paging.tlb.write[tlb_index] = handler->GetHostWritePt(phys_page)-lin_base;
-					else paging.tlb.write[tlb_index] = 0;
+						TLB_WRITE(tlb_index) = handler->GetHostWritePt(phys_page)-lin_base;
+					else TLB_WRITE(tlb_index) = 0;
 				} else {
-					paging.tlb.writehandler[tlb_index] = &foiling_handler;
-					paging.tlb.write[tlb_index] = 0;
+					TLB_WRITEHANDLER(tlb_index) = &foiling_handler;
+					TLB_WRITE(tlb_index) = 0;
 				}
 			}
 		}
 	}
 }
 
-#else
-
-static INLINE void InitTLBInt(tlb_entry *bank) {
- 	for (Bitu i=0;i<TLB_SIZE;i++) {
-		bank[i].read=0;
-		bank[i].write=0;
-		bank[i].readhandler=&init_page_handler;
-		bank[i].writehandler=&init_page_handler;
- 	}
-}
-
-void PAGING_InitTLBBank(tlb_entry **bank) {
-	*bank = (tlb_entry *)malloc(sizeof(tlb_entry)*TLB_SIZE);
-	if(!*bank) E_Exit("Out of Memory");
-	InitTLBInt(*bank);
-}
-
-void PAGING_InitTLB(void) {
-	InitTLBInt(paging.tlbh);
- 	paging.links.used=0;
-}
-
-void PAGING_ClearTLB(void) {
-	uint32_t * entries=&paging.links.entries[0];
-	for (;paging.links.used>0;paging.links.used--) {
-		Bitu page=*entries++;
-		tlb_entry *entry = get_tlb_entry(page<<12);
-		entry->read=0;
-		entry->write=0;
-		entry->readhandler=&init_page_handler;
-		entry->writehandler=&init_page_handler;
-	}
-	paging.links.used=0;
-}
-
-void PAGING_UnlinkPages(Bitu lin_page,Bitu pages) {
-	for (;pages>0;pages--) {
-		tlb_entry *entry = get_tlb_entry(lin_page<<12);
-		entry->read=0;
-		entry->write=0;
-		entry->readhandler=&init_page_handler;
-		entry->writehandler=&init_page_handler;
-		lin_page++;
-	}
-}
-
-void PAGING_MapPage(Bitu lin_page,Bitu phys_page) {
-	if (lin_page<LINK_START) {
-		paging.firstmb[lin_page]=phys_page;
-		paging.tlbh[lin_page].read=0;
-		paging.tlbh[lin_page].write=0;
-		paging.tlbh[lin_page].readhandler=&init_page_handler;
-		paging.tlbh[lin_page].writehandler=&init_page_handler;
-	} else {
-		PAGING_LinkPage(lin_page,phys_page);
-	}
-}
-
-void PAGING_LinkPage(Bitu lin_page,Bitu phys_page) {
-	PageHandler * handler=MEM_GetPageHandler(phys_page);
-	Bitu lin_base=lin_page << 12;
-	if (lin_page>=(TLB_SIZE*(TLB_BANKS+1)) || phys_page>=(TLB_SIZE*(TLB_BANKS+1))) 
-		E_Exit("Illegal page");
-
-	if (paging.links.used>=PAGING_LINKS) {
-		LOG(LOG_PAGING,LOG_NORMAL)("Not enough paging links, resetting cache");
-		PAGING_ClearTLB();
-	}
-
-	tlb_entry *entry = get_tlb_entry(lin_base);
-	entry->phys_page=phys_page;
-	if (handler->getFlags() & PFLAG_READABLE) entry->read=handler->GetHostReadPt(phys_page)-lin_base;
-	else entry->read=0;
-	if (handler->getFlags() & PFLAG_WRITEABLE) entry->write=handler->GetHostWritePt(phys_page)-lin_base;
-	else entry->write=0;
-
- 	paging.links.entries[paging.links.used++]=lin_page;
-	entry->readhandler=handler;
-	entry->writehandler=handler;
-}
-
-void PAGING_LinkPage_ReadOnly(Bitu lin_page,Bitu phys_page) {
-	PageHandler * handler=MEM_GetPageHandler(phys_page);
-	Bitu lin_base=lin_page << 12;
-	if (lin_page>=(TLB_SIZE*(TLB_BANKS+1)) || phys_page>=(TLB_SIZE*(TLB_BANKS+1))) 
-		E_Exit("Illegal page");
-
-	if (paging.links.used>=PAGING_LINKS) {
-		LOG(LOG_PAGING,LOG_NORMAL)("Not enough paging links, resetting cache");
-		PAGING_ClearTLB();
-	}
-
-	tlb_entry *entry = get_tlb_entry(lin_base);
-	entry->phys_page=phys_page;
-	if (handler->getFlags() & PFLAG_READABLE) entry->read=handler->GetHostReadPt(phys_page)-lin_base;
-	else entry->read=0;
-	entry->write=0;
-
- 	paging.links.entries[paging.links.used++]=lin_page;
-	entry->readhandler=handler;
-	entry->writehandler=&init_page_handler_userro;
-}
-
-#endif
 
 #define USERWRITE_PROHIBITED			((cpu.cpl&cpu.mpl)==3)
 class InitPageUserROHandler : public PageHandler {
@@ -1473,9 +1431,16 @@ void POD_Save_CPU_Paging( std::ostream& stream )
 //	WRITE_POD( &paging.wp, paging.wp );
 	WRITE_POD( &paging.base, paging.base );
 
+#if defined(USE_FULL_TLB)
 	WRITE_POD( &paging.tlb.read, paging.tlb.read );
 	WRITE_POD( &paging.tlb.write, paging.tlb.write );
 	WRITE_POD( &paging.tlb.phys_page, paging.tlb.phys_page );
+#else
+	// same layout as the full TLB so save states stay interchangeable
+	for (Bitu i=0;i<TLB_SIZE;i++) { HostPt p=get_tlb_entry((PhysPt)(i<<12))->read; WRITE_POD( &p, p ); }
+	for (Bitu i=0;i<TLB_SIZE;i++) { HostPt p=get_tlb_entry((PhysPt)(i<<12))->write; WRITE_POD( &p, p ); }
+	for (Bitu i=0;i<TLB_SIZE;i++) { uint32_t p=get_tlb_entry((PhysPt)(i<<12))->phys_page; WRITE_POD( &p, p ); }
+#endif
 
 	WRITE_POD( &paging.links, paging.links );
 //	WRITE_POD( &paging.ur_links, paging.ur_links );
@@ -1495,9 +1460,14 @@ void POD_Load_CPU_Paging( std::istream& stream )
 //	READ_POD( &paging.wp, paging.wp );
 	READ_POD( &paging.base, paging.base );
 
+#if defined(USE_FULL_TLB)
 	READ_POD( &paging.tlb.read, paging.tlb.read );
 	READ_POD( &paging.tlb.write, paging.tlb.write );
 	READ_POD( &paging.tlb.phys_page, paging.tlb.phys_page );
+#else
+	// the TLB is rebuilt on demand below, skip its contents
+	stream.ignore((std::streamsize)(TLB_SIZE*(sizeof(HostPt)*2+sizeof(uint32_t))));
+#endif
 
 	READ_POD( &paging.links, paging.links );
 //	READ_POD( &paging.ur_links, paging.ur_links );
@@ -1512,11 +1482,5 @@ void POD_Load_CPU_Paging( std::istream& stream )
 	// reset all information
 	paging.links.used = PAGING_LINKS;
 	PAGING_ClearTLB();
-
-	for( int lcv=0; lcv<TLB_SIZE; lcv++ ) {
-		paging.tlb.read[lcv] = 0;
-		paging.tlb.write[lcv] = 0;
-		paging.tlb.readhandler[lcv] = &init_page_handler;
-		paging.tlb.writehandler[lcv] = &init_page_handler;
-	}
+	PAGING_InitTLB();
 }
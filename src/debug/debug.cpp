@@ -50,6 +50,9 @@ using namespace std;
 #include "programs.h"
 #include "debug_inc.h"
 #include "../cpu/lazyflags.h"
+#if defined(HAS_FPU_SOFT80)
+#include "../fpu/fpu_soft80.h"
+#endif
 #include "keyboard.h"
 #include "setup.h"
 
@@ -76,6 +79,7 @@ extern bool                 dos_kernel_disabled;
 extern bool                 is_paused;
 extern bool                 pc98_crt_mode;
 extern uint8_t              GDC_display_plane;
+extern unsigned long        vga_batch_frames,vga_batch_catchups;
 extern uint8_t              GDC_display_plane_pending;
 extern bool                 pc98_256kb_boundary;
 extern bool                         gdc_5mhz_mode;
@@ -328,12 +332,23 @@ static list<string>::iterator histBuffPos = histBuff.end();
 /* Helpers */
 /***********/
 
+#if defined(HAS_FPU_SOFT80)
+static double F80ToDouble(int regIndex) {
+	FPU_Soft80 r;
+	r.m = fpu.regs_80[regIndex].raw.l;
+	r.se = fpu.regs_80[regIndex].raw.h;
+	return Soft80_ToDouble(r);
+}
+#endif
+
 /* dest here must be a string with a minimum length of 11. */
 static char* F80ToString(int regIndex, char* dest) {
 #if C_FPU_X86
 	snprintf(dest, 11, "%08.2Lf", reinterpret_cast<long double&>(fpu.p_regs[regIndex]));
 #elif defined(HAS_LONG_DOUBLE)
 	snprintf(dest, 11, "%08.2Lf", fpu.regs_80[regIndex].v);
+#elif defined(HAS_FPU_SOFT80)
+	snprintf(dest, 11, "%08.2f", F80ToDouble(regIndex));
 #else
 	snprintf(dest, 11, "%08.2f", fpu.regs[regIndex].d);
 #endif
@@ -350,6 +365,8 @@ static bool F80TestUpdate(int regIndex) {
 	return !(fpu.p_regs[regIndex].m1 == oldfpu.p_regs[regIndex].m1 && fpu.p_regs[regIndex].m2 == oldfpu.p_regs[regIndex].m2 && fpu.p_regs[regIndex].m3 == oldfpu.p_regs[regIndex].m3);
 #elif defined(HAS_LONG_DOUBLE)
 	return fpu.regs_80[regIndex].v != oldfpu.regs_80[regIndex].v; /* I'm certain that strict float equality can be used here. */
+#elif defined(HAS_FPU_SOFT80)
+	return fpu.regs_80[regIndex].raw.l != oldfpu.regs_80[regIndex].raw.l || fpu.regs_80[regIndex].raw.h != oldfpu.regs_80[regIndex].raw.h;
 #else
 	return fpu.regs[regIndex].d != oldfpu.regs[regIndex].d;
 #endif
@@ -944,9 +961,9 @@ static void DrawData(void) {
 
                 /* save the original page addr.
                  * we must hack the phys page tlb to make the hardware handler map 1:1 the page for this call. */
-                PhysPt opg = paging.tlb.phys_page[address>>12];
+                PhysPt opg = TLB_PHYS_PAGE(address>>12);
 
-                paging.tlb.phys_page[address>>12] = (uint32_t)(address>>12);
+                TLB_PHYS_PAGE(address>>12) = (uint32_t)(address>>12);
 
                 PageHandler *ph = MEM_GetPageHandler((Bitu)(address>>12));
 
@@ -955,7 +972,7 @@ static void DrawData(void) {
                 else
                     ch = ph->readb((PhysPt)address);
 
-                paging.tlb.phys_page[address>>12] = opg;
+                TLB_PHYS_PAGE(address>>12) = opg;
 
                 wattrset (dbg.win_data,0);
                 mvwprintw (dbg.win_data,y,14+3*x,"%02X",ch);
@@ -2163,6 +2180,8 @@ bool ParseCommand(char* str) {
             DEBUG_ShowMsg("line-total=%lu vblank-skip=%lu lines-done=%lu split-line=%lu",
                 (unsigned long)vga.draw.lines_total,(unsigned long)vga.draw.vblank_skip,
                 (unsigned long)vga.draw.lines_done,(unsigned long)vga.draw.split_line);
+            DEBUG_ShowMsg("batched-frames=%lu batch-catchups=%lu",
+                vga_batch_frames,vga_batch_catchups);
             DEBUG_ShowMsg("byte-pan-shft=%lu render-stop=%lu render-max=%lu scrn-ratio=%.3f",
                 (unsigned long)vga.draw.byte_panning_shift,(unsigned long)vga.draw.render_step,
                 (unsigned long)vga.draw.render_max,(double)vga.draw.screen_ratio);
@@ -3909,6 +3928,8 @@ static void LogFPUInfo(void) {
 
 #if defined(HAS_LONG_DOUBLE)//probably shouldn't allow struct to change size based on this
         DEBUG_ShowMsg(" st(%u): %s val=%.9f",i,FPU_tag(fpu.tags[adj]),(double)fpu.regs_80[adj].v);
+#elif defined(HAS_FPU_SOFT80)
+        DEBUG_ShowMsg(" st(%u): %s val=%.9f",i,FPU_tag(fpu.tags[adj]),F80ToDouble((int)adj));
 #else
         DEBUG_ShowMsg(" st(%u): %s use80=%u val=%.9f",i,FPU_tag(fpu.tags[adj]),fpu.use80[adj],fpu.regs[adj].d);
 #endif
@@ -71,6 +71,7 @@
 #include "ints/int10.h"
 #include "menu.h"
 #include "render.h"
+#include "frametime.h"
 #include "pci_bus.h"
 #include "parport.h"
 #include "clockdomain.h"
@@ -329,7 +330,7 @@ static Bitu Normal_Loop(void) {
     bool saved_allow = dosbox_allow_nonrecursive_page_fault;
     Bits ret;
 
-    if (!menu.hidecycles || menu.showrt) { /* sdlmain.cpp/render.cpp doesn't even maintain the frames count when hiding cycles! */
+    if (!menu.hidecycles || menu.showrt || frametime_enabled) { /* sdlmain.cpp/render.cpp doesn't even maintain the frames count when hiding cycles! */
         uint32_t ticksNew = GetTicks();
         if (ticksNew >= Ticks) {
             uint32_t interval = ticksNew - ticksLastFramecounter;
@@ -357,7 +358,10 @@ static Bitu Normal_Loop(void) {
 
                 saved_allow = dosbox_allow_nonrecursive_page_fault;
                 dosbox_allow_nonrecursive_page_fault = true;
-                ret = (*cpudecoder)();
+                {
+                    FrameTimeScope timing(FRAMETIME_CPU);
+                    ret = (*cpudecoder)();
+                }
                 dosbox_allow_nonrecursive_page_fault = saved_allow;
 
                 if (GCC_UNLIKELY(ret<0))
@@ -1266,6 +1270,7 @@ void DOSBOX_SetupConfigSections(void) {
     const char* vsyncmode[] = { "off", "on" ,"force", "host", 0 };
     const char* captureformats[] = { "default", "avi-zmbv", "mpegts-h264", 0 };
     const char* blocksizes[] = {"1024", "2048", "4096", "8192", "512", "256", 0};
+    const char* resamplers[] = {"linear", "sinc-low", "sinc-high", 0};
     const char* capturechromaformats[] = { "auto", "4:4:4", "4:2:2", "4:2:0", 0};
     const char* controllertypes[] = { "auto", "at", "xt", "pcjr", "pc98", 0}; // Future work: Tandy(?) and USB
     const char* auxdevices[] = {"none","2button","3button","intellimouse","intellimouse45",0};
@@ -2064,6 +2069,18 @@ void DOSBOX_SetupConfigSections(void) {
     Pbool->Set_help("This setting affects the VGA Line Compare register. Set to false (default value) to emulate most VGA behavior\n"
             "Set to true for the value to latch once at the start of the frame.");
 
+    Pint = secprop->Add_int("scanline batch size",Property::Changeable::Always,0);
+    Pint->SetMinMax(0,4096);
+    Pint->Set_help("If greater than 1, EGA/VGA frames are rendered up to this many scanlines per emulator event instead\n"
+            "of one event per scanline. Scanlines are drawn once the beam has passed them, and a CRTC, attribute, sequencer or\n"
+            "DAC write first draws the scanlines up to the beam, so raster effects look the same as without batching.\n"
+            "Set to a value at least as large as the screen height to render whole frames at once. 0 disables batching.");
+
+    Pbool = secprop->Add_bool("lfb dirty page tracking",Property::Changeable::Always,false);
+    Pbool->Set_help("If set, writes to video memory in the SVGA linear (8/15/16/24/32bpp) modes are tracked per 4KB page, and scanlines whose\n"
+            "video memory was not written since the previous frame are not redrawn. This makes mostly static screens such as an idle\n"
+            "desktop almost free to display, at the cost of slower CPU writes to the linear framebuffer. Applies from the next mode set.");
+
     Pbool = secprop->Add_bool("ignore vblank wraparound",Property::Changeable::Always,false);
     Pbool->Set_help("DOSBox-X can handle active display properly if games or demos reprogram vertical blanking to end in the active picture area.\n"
             "If the wraparound handling prevents the game from displaying properly, set this to false. Out of bounds vblank values will be ignored.\n");
@@ -2231,6 +2248,19 @@ void DOSBOX_SetupConfigSections(void) {
     Pbool = secprop->Add_bool("alt render",Property::Changeable::Always,false);
     Pbool->Set_help("If set, use a new experimental rendering engine");
 
+    Pbool = secprop->Add_bool("render thread",Property::Changeable::OnlyAtStart,false);
+    Pbool->Set_help("If set, palette lookup and scaling of each frame is done by a separate render thread while\n"
+                    "the emulation thread continues with the next frame. The frame is shown within 1 ms of being scaled.\n"
+                    "Presentation to the screen is still done by the main thread. Not used with TTF output.");
+
+    Pbool = secprop->Add_bool("frame timing",Property::Changeable::Always,false);
+    Pbool->Set_help("If set, the time spent per emulated frame in the CPU core, VGA scanline drawing, the scalers,\n"
+                    "the video output and the mixer is measured and the averages (ms/frame) are shown in the title bar.");
+
+    Pstring = secprop->Add_string("frame timing csv",Property::Changeable::Always,"");
+    Pstring->Set_help("If set, the frame timing above is collected into per stage histograms that are written to\n"
+                      "this CSV file when DOSBox-X exits.");
+
     Pstring = secprop->Add_string("aspect", Property::Changeable::Always, "false");
     Pstring->Set_values(aspectmodes);
     Pstring->Set_help(
@@ -2485,6 +2515,13 @@ void DOSBOX_SetupConfigSections(void) {
             "also causes problems with 32-bit protected mode DOS games and reduces the performance\n"
             "of the dynamic core.\n");
 
+    Pstring = secprop->Add_string("dynamic core smc profile file",Property::Changeable::Always,"");
+    Pstring->Set_help("If set, the dynamic core remembers which parts of each code page turned out to be self-modifying\n"
+            "and saves this information to the given file on exit. On the next run, code pages with identical contents\n"
+            "reuse it and skip the repeated retranslation that self-modifying code otherwise causes (e.g. Windows 3.x/9x boot).\n"
+            "Translated code is not saved, each code block is still translated once per run.\n"
+            "Leave empty to disable.");
+
     Pstring = secprop->Add_string("cputype",Property::Changeable::Always,"auto");
     Pstring->Set_values(cputype_values);
     Pstring->Set_help("CPU Type used in emulation. auto emulates a 486 which tolerates Pentium instructions.");
@@ -2651,6 +2688,21 @@ void DOSBOX_SetupConfigSections(void) {
     Pint->SetMinMax(0,100);
     Pint->Set_help("How many milliseconds of data to keep on top of the blocksize.");
 
+    Pstring = secprop->Add_string("resampler",Property::Changeable::OnlyAtStart,"linear");
+    Pstring->Set_values(resamplers);
+    Pstring->Set_help("How sound devices running at a different rate than the mixer are converted to the mixer rate.\n"
+            "  linear:    Linear interpolation, the lowest latency.\n"
+            "  sinc-low:  16-tap windowed sinc filter, much less aliasing than linear interpolation.\n"
+            "  sinc-high: 32-tap windowed sinc filter, the best quality.");
+
+    Pstring = secprop->Add_string("stream",Property::Changeable::OnlyAtStart,"");
+    Pstring->Set_help("Send the mixer output to this file instead of the sound device, as 16-bit stereo WAV at the mixer rate.\n"
+            "A FIFO or other non-regular file, or - for stdout, gets a streaming WAV header and the samples as they are mixed.\n"
+            "Mixing then follows emulated time only, so an unthrottled guest (fast forward, -fastforward) renders faster than real time.\n"
+            "With - anything else written to stdout ends up in the stream and corrupts it: the debugger's console, log output on builds\n"
+            "that log to stdout, and messages of the program itself. Use a FIFO instead when any of these are in use.\n"
+            "Leave empty to use the sound device.");
+
     secprop=control->AddSection_prop("midi",&Null_Init,true);//done
 
     Pstring = secprop->Add_string("mpu401",Property::Changeable::WhenIdle,"intelligent");
@@ -2879,6 +2931,38 @@ void DOSBOX_SetupConfigSections(void) {
 	Pint = secprop->Add_int("fluid.chorus.type",Property::Changeable::WhenIdle,0);
 	Pint->Set_values(fluidchorustypes);
 	Pint->Set_help("Fluidsynth chorus type. 0 is sine wave, 1 is triangle wave.");
+
+	Pbool = secprop->Add_bool("fluid.thread",Property::Changeable::WhenIdle,false);
+	Pbool->Set_help("Render the built-in synth (mididevice=synth) in a separate thread, ahead of the mixer.\n"
+		"MIDI events are delayed by fluid.prebuffer to keep their timing.");
+
+	const char *fluidchunk[] = {"2", "3", "16", "99", "100",0};
+	Pint = secprop->Add_int("fluid.chunk",Property::Changeable::WhenIdle,16);
+	Pint->Set_values(fluidchunk);
+	Pint->SetMinMax(2,100);
+	Pint->Set_help("Minimum milliseconds of data to render at once. (min 2, max 100)\n"
+		"Valid for rendering in separate thread only.");
+
+	const char *fluidprebuffer[] = {"3", "4", "32", "199", "200",0};
+	Pint = secprop->Add_int("fluid.prebuffer",Property::Changeable::WhenIdle,32);
+	Pint->Set_values(fluidprebuffer);
+	Pint->SetMinMax(3,200);
+	Pint->Set_help("How many milliseconds of data to render ahead. (min 3, max 200)\n"
+		"Increasing this value may help to avoid underruns but also increases audio lag.\n"
+		"Cannot be set less than or equal to fluid.chunk value.\n"
+		"Valid for rendering in separate thread only.");
+
+	Pbool = secprop->Add_bool("fluid.sample.mmap",Property::Changeable::WhenIdle,true);
+	Pbool->Set_help("Map the sample data of the sound font file of the built-in synth instead of reading it into memory.\n"
+		"Loading a large sound font is then almost instant, only the samples that are played are read from disk\n"
+		"and several emulator instances share the same memory. Used by the bundled FluidSynth library only.");
+
+	const char *fluidsamplepin[] = {"0", "20", "50", "100", "1000",0};
+	Pint = secprop->Add_int("fluid.sample.pin",Property::Changeable::WhenIdle,0);
+	Pint->Set_values(fluidsamplepin);
+	Pint->SetMinMax(0,1000);
+	Pint->Set_help("Milliseconds at the start of every sample of a mapped sound font to keep in memory, so that notes\n"
+		"do not wait for the disk when they are first played. 0 reads every sample when it is first used. (min 0, max 1000)");
 #endif
 
     secprop=control->AddSection_prop("sblaster",&Null_Init,true);
@@ -49,6 +49,8 @@ uint16_t FPU_GetTag(void){
 #include "fpu_instructions_x86.h"
 #elif defined(HAS_LONG_DOUBLE)
 #include "fpu_instructions_longdouble.h"
+#elif defined(HAS_FPU_SOFT80)
+#include "fpu_instructions_soft80.h"
 #else
 #include "fpu_instructions.h"
 #endif
@@ -996,6 +998,8 @@ dump:
 		(int)ft.f.exponent - FPU_Reg_64_exponent_bias,
 		(unsigned long long)ft.f.mantissa,
 		(unsigned long long)ft.f.mantissa);
+#elif defined(HAS_FPU_SOFT80)
+	LOG(LOG_FPU,LOG_DEBUG)("FPU80 selftest skipped, using the software 80-bit FPU");
 #else
 	LOG(LOG_FPU,LOG_DEBUG)("FPU80 selftest skipped, compiler does not have long double as 80-bit IEEE");
 #endif
@@ -1022,6 +1026,8 @@ void FPU_Selftest() {
     LOG(LOG_FPU,LOG_NORMAL)("FPU core: x86 FPU");
 #elif defined(HAS_LONG_DOUBLE)
     LOG(LOG_FPU,LOG_NORMAL)("FPU core: long double FPU");
+#elif defined(HAS_FPU_SOFT80)
+    LOG(LOG_FPU,LOG_NORMAL)("FPU core: software 80-bit FPU");
 #else
     LOG(LOG_FPU,LOG_NORMAL)("FPU core: double FPU (caution: possible precision errors)");
 #endif
@@ -0,0 +1,589 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* FPU core for hosts without an x87 compatible "long double" (ARM64 and others).
+ * Registers hold the exact 80-bit image in fpu.regs_80[].raw and all arithmetic is
+ * done by fpu_soft80.h, which honours the precision and rounding control of the
+ * control word. The host rounding mode is never changed. */
+
+#include "cpu/lazyflags.h"
+#include "fpu_soft80.h"
+
+static inline FPU_Soft80 FPU_GetReg(Bitu reg) {
+	FPU_Soft80 r;
+	r.m = fpu.regs_80[reg].raw.l;
+	r.se = fpu.regs_80[reg].raw.h;
+	return r;
+}
+
+static inline void FPU_SetReg(Bitu reg,const FPU_Soft80 &v) {
+	fpu.regs_80[reg].raw.l = v.m;
+	fpu.regs_80[reg].raw.h = v.se;
+}
+
+/* significand bits selected by the precision control */
+static inline unsigned int FPU_Soft80_PC(void) {
+	return Soft80_Precision((fpu.cw >> 8u) & 3u);
+}
+
+static void FPU_FINIT(void) {
+	FPU_SetCW(0x37F);
+	fpu.sw = 0;
+	TOP=FPU_GET_TOP();
+	fpu.tags[0] = TAG_Empty;
+	fpu.tags[1] = TAG_Empty;
+	fpu.tags[2] = TAG_Empty;
+	fpu.tags[3] = TAG_Empty;
+	fpu.tags[4] = TAG_Empty;
+	fpu.tags[5] = TAG_Empty;
+	fpu.tags[6] = TAG_Empty;
+	fpu.tags[7] = TAG_Empty;
+	fpu.tags[8] = TAG_Valid; // is only used by us (FIXME: why?)
+}
+
+static void FPU_FCLEX(void){
+	fpu.sw &= 0x7f00;			//should clear exceptions
+}
+
+static void FPU_FNOP(void){
+	return;
+}
+
+static void FPU_PUSH(const FPU_Soft80 &in){
+	TOP = (TOP - 1) &7;
+	//actually check if empty
+	fpu.tags[TOP] = TAG_Valid;
+	FPU_SetReg(TOP,in);
+}
+
+static void FPU_PREP_PUSH(void){
+	TOP = (TOP - 1) &7;
+	fpu.tags[TOP] = TAG_Valid;
+}
+
+static void FPU_FPOP(void){
+	fpu.tags[TOP]=TAG_Empty;
+	//maybe set zero in it as well
+	TOP = ((TOP+1)&7);
+}
+
+// TODO: Incorporate into paging.h
+static inline uint64_t mem_readq(PhysPt addr) {
+    uint64_t tmp;
+
+    tmp  = (uint64_t)mem_readd(addr);
+    tmp |= (uint64_t)mem_readd(addr+4ul) << (uint64_t)32ul;
+
+    return tmp;
+}
+
+static inline void mem_writeq(PhysPt addr,uint64_t v) {
+    mem_writed(addr,    (uint32_t)v);
+    mem_writed(addr+4ul,(uint32_t)(v >> (uint64_t)32ul));
+}
+
+static void FPU_FLD80(PhysPt addr,Bitu reg) {
+    fpu.regs_80[reg].raw.l = mem_readq(addr);
+    fpu.regs_80[reg].raw.h = mem_readw(addr+8ul);
+}
+
+static void FPU_ST80(PhysPt addr,Bitu reg) {
+    mem_writeq(addr    ,fpu.regs_80[reg].raw.l);
+    mem_writew(addr+8ul,fpu.regs_80[reg].raw.h);
+}
+
+
+static void FPU_FLD_F32(PhysPt addr,Bitu store_to) {
+	FPU_SetReg(store_to,Soft80_FromF32(mem_readd(addr)));
+}
+
+static void FPU_FLD_F64(PhysPt addr,Bitu store_to) {
+	FPU_SetReg(store_to,Soft80_FromF64(mem_readq(addr)));
+}
+
+static void FPU_FLD_F80(PhysPt addr) {
+	FPU_FLD80(addr,TOP);
+}
+
+static void FPU_FLD_I16(PhysPt addr,Bitu store_to) {
+	FPU_SetReg(store_to,Soft80_FromI64((int16_t)mem_readw(addr)));
+}
+
+static void FPU_FLD_I32(PhysPt addr,Bitu store_to) {
+	FPU_SetReg(store_to,Soft80_FromI64((int32_t)mem_readd(addr)));
+}
+
+static void FPU_FLD_I64(PhysPt addr,Bitu store_to) {
+	FPU_SetReg(store_to,Soft80_FromI64((int64_t)mem_readq(addr)));
+}
+
+static void FPU_FBLD(PhysPt addr,Bitu store_to) {
+	uint64_t val = 0;
+	Bitu in = 0;
+	uint64_t base = 1;
+	for(Bitu i = 0;i < 9;i++){
+		in = mem_readb(addr + i);
+		val += ( (in&0xf) * base); //in&0xf shouldn't be higher then 9
+		base *= 10;
+		val += ((( in>>4)&0xf) * base);
+		base *= 10;
+	}
+
+	in = mem_readb(addr + 9);
+	val += ( (in&0xf) * base );
+	FPU_SetReg(store_to,Soft80_FromU64((in&0x80)?1:0,val));
+}
+
+
+static INLINE void FPU_FLD_F32_EA(PhysPt addr) {
+	FPU_FLD_F32(addr,8);
+}
+static INLINE void FPU_FLD_F64_EA(PhysPt addr) {
+	FPU_FLD_F64(addr,8);
+}
+static INLINE void FPU_FLD_I32_EA(PhysPt addr) {
+	FPU_FLD_I32(addr,8);
+}
+static INLINE void FPU_FLD_I16_EA(PhysPt addr) {
+	FPU_FLD_I16(addr,8);
+}
+
+
+static void FPU_FST_F32(PhysPt addr) {
+	mem_writed(addr,Soft80_ToF32(FPU_GetReg(TOP),fpu.round));
+}
+
+static void FPU_FST_F64(PhysPt addr) {
+	mem_writeq(addr,Soft80_ToF64(FPU_GetReg(TOP),fpu.round));
+}
+
+static void FPU_FST_F80(PhysPt addr) {
+	FPU_ST80(addr,TOP);
+}
+
+static void FPU_FST_I16(PhysPt addr) {
+	mem_writew(addr,(uint16_t)Soft80_ToInt(FPU_GetReg(TOP),16,fpu.round));
+}
+
+static void FPU_FST_I32(PhysPt addr) {
+	mem_writed(addr,(uint32_t)Soft80_ToInt(FPU_GetReg(TOP),32,fpu.round));
+}
+
+static void FPU_FST_I64(PhysPt addr) {
+	mem_writeq(addr,(uint64_t)Soft80_ToInt(FPU_GetReg(TOP),64,fpu.round));
+}
+
+static void FPU_FBST(PhysPt addr) {
+	unsigned int sign;
+	uint64_t val;
+
+	if (!Soft80_RoundToInt(FPU_GetReg(TOP),fpu.round,sign,val) || val >= 1000000000000000000ull) {
+		// packed BCD indefinite
+		for(Bitu i=0;i<7;i++) mem_writeb(addr+i,0);
+		mem_writeb(addr+7,0xC0);
+		mem_writeb(addr+8,0xFF);
+		mem_writeb(addr+9,0xFF);
+		return;
+	}
+	//numbers from back to front
+	for(Bitu i=0;i<9;i++){
+		Bitu p = (Bitu)(val % 10);
+		val /= 10;
+		p |= (Bitu)(val % 10) << 4;
+		val /= 10;
+		mem_writeb(addr+i,p);
+	}
+	mem_writeb(addr+9,sign?0x80:0);
+}
+
+static void FPU_FADD(Bitu op1, Bitu op2){
+	// HACK: Set the denormal flag according to whether the source or final result is a denormalized number.
+	//       This is vital if we don't want certain DOS programs to mis-detect our FPU emulation as an IIT clone chip when cputype == 286
+	const FPU_Soft80 a = FPU_GetReg(op1), b = FPU_GetReg(op2);
+	const FPU_Soft80 r = Soft80_Add(a,b,false,FPU_Soft80_PC(),fpu.round);
+	FPU_SetReg(op1,r);
+	FPU_SET_D(Soft80_NotNormal(a) || Soft80_NotNormal(r) || Soft80_NotNormal(b));
+}
+
+static void FPU_FSIN(void){
+	FPU_SetReg(TOP,Soft80_FromDouble(sin(Soft80_ToDouble(FPU_GetReg(TOP)))));
+	FPU_SET_C2(0);
+}
+
+static void FPU_FSINCOS(void){
+	const double temp = Soft80_ToDouble(FPU_GetReg(TOP));
+	FPU_SetReg(TOP,Soft80_FromDouble(sin(temp)));
+	FPU_PUSH(Soft80_FromDouble(cos(temp)));
+	FPU_SET_C2(0);
+}
+
+static void FPU_FCOS(void){
+	FPU_SetReg(TOP,Soft80_FromDouble(cos(Soft80_ToDouble(FPU_GetReg(TOP)))));
+	FPU_SET_C2(0);
+}
+
+static void FPU_FSQRT(void){
+	FPU_SetReg(TOP,Soft80_Sqrt(FPU_GetReg(TOP),FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FPATAN(void){
+	const double y = Soft80_ToDouble(FPU_GetReg(STV(1)));
+	const double x = Soft80_ToDouble(FPU_GetReg(TOP));
+	FPU_SetReg(STV(1),Soft80_FromDouble(atan2(y,x)));
+	FPU_FPOP();
+}
+
+static void FPU_FPTAN(void){
+	FPU_SetReg(TOP,Soft80_FromDouble(tan(Soft80_ToDouble(FPU_GetReg(TOP)))));
+	FPU_PUSH(SOFT80_ONE);
+	FPU_SET_C2(0);
+}
+
+static void FPU_FDIV(Bitu st, Bitu other){
+	FPU_SetReg(st,Soft80_Div(FPU_GetReg(st),FPU_GetReg(other),FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FDIVR(Bitu st, Bitu other){
+	FPU_SetReg(st,Soft80_Div(FPU_GetReg(other),FPU_GetReg(st),FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FMUL(Bitu st, Bitu other){
+	FPU_SetReg(st,Soft80_Mul(FPU_GetReg(st),FPU_GetReg(other),FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FSUB(Bitu st, Bitu other){
+	FPU_SetReg(st,Soft80_Add(FPU_GetReg(st),FPU_GetReg(other),true,FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FSUBR(Bitu st, Bitu other){
+	FPU_SetReg(st,Soft80_Add(FPU_GetReg(other),FPU_GetReg(st),true,FPU_Soft80_PC(),fpu.round));
+}
+
+static void FPU_FXCH(Bitu st, Bitu other){
+	FPU_Reg_80 reg80 = fpu.regs_80[other];
+	FPU_Tag tag = fpu.tags[other];
+
+	fpu.regs_80[other] = fpu.regs_80[st];
+	fpu.tags[other] = fpu.tags[st];
+
+	fpu.regs_80[st] = reg80;
+	fpu.tags[st] = tag;
+}
+
+static void FPU_FST(Bitu st, Bitu other){
+	fpu.regs_80[other] = fpu.regs_80[st];
+	fpu.tags[other] = fpu.tags[st];
+}
+
+static inline void FPU_FCMOV(Bitu st, Bitu other){
+	fpu.regs_80[st] = fpu.regs_80[other];
+	fpu.tags[st] = fpu.tags[other];
+}
+
+static void FPU_FCOM(Bitu st, Bitu other){
+	FPU_SET_C1(0);
+	if(((fpu.tags[st] != TAG_Valid) && (fpu.tags[st] != TAG_Zero)) ||
+		((fpu.tags[other] != TAG_Valid) && (fpu.tags[other] != TAG_Zero))){
+		FPU_SET_C3(1);FPU_SET_C2(1);FPU_SET_C0(1);return;
+	}
+
+	const FPU_Soft80 a = FPU_GetReg(st), b = FPU_GetReg(other);
+
+	/* HACK: If emulating a 286 processor we want the guest to think it's talking to a 287.
+	 *       For more info, read [http://www.intel-assembler.it/portale/5/cpu-identification/asm-source-to-find-intel-cpu.asp]. */
+	if (CPU_ArchitectureType<CPU_ARCHTYPE_386) {
+		if ((a.se & 0x7FFF) == 0x7FFF && (a.m << 1) == 0 && (b.se & 0x7FFF) == 0x7FFF && (b.m << 1) == 0) {
+			/* 8087/287 consider -inf == +inf and that's what DOS programs test for to detect 287 vs 387 */
+			FPU_SET_C3(1);FPU_SET_C2(0);FPU_SET_C0(0);return;
+		}
+	}
+
+	switch (Soft80_Compare(a,b)) {
+		case 0:		FPU_SET_C3(1);FPU_SET_C2(0);FPU_SET_C0(0);return;
+		case -1:	FPU_SET_C3(0);FPU_SET_C2(0);FPU_SET_C0(1);return;
+		case 1:		FPU_SET_C3(0);FPU_SET_C2(0);FPU_SET_C0(0);return;
+		default:	FPU_SET_C3(1);FPU_SET_C2(1);FPU_SET_C0(1);return;
+	}
+}
+
+static void FPU_FUCOM(Bitu st, Bitu other){
+	//does atm the same as fcom
+	FPU_FCOM(st,other);
+}
+
+static void FPU_FUCOMI(Bitu st, Bitu other){
+
+	FillFlags();
+	SETFLAGBIT(OF,false);
+
+	switch (Soft80_Compare(FPU_GetReg(st),FPU_GetReg(other))) {
+		case 0:		SETFLAGBIT(ZF,true);SETFLAGBIT(PF,false);SETFLAGBIT(CF,false);return;
+		case -1:	SETFLAGBIT(ZF,false);SETFLAGBIT(PF,false);SETFLAGBIT(CF,true);return;
+		case 1:		SETFLAGBIT(ZF,false);SETFLAGBIT(PF,false);SETFLAGBIT(CF,false);return;
+		default:	SETFLAGBIT(ZF,true);SETFLAGBIT(PF,true);SETFLAGBIT(CF,true);return;
+	}
+}
+
+static inline void FPU_FCOMI(Bitu st, Bitu other){
+	FPU_FUCOMI(st,other);
+
+	if(((fpu.tags[st] != TAG_Valid) && (fpu.tags[st] != TAG_Zero)) ||
+		((fpu.tags[other] != TAG_Valid) && (fpu.tags[other] != TAG_Zero))){
+		SETFLAGBIT(ZF,true);SETFLAGBIT(PF,true);SETFLAGBIT(CF,true);return;
+	}
+
+}
+
+static void FPU_FRNDINT(void){
+	FPU_SetReg(TOP,Soft80_RoundInt(FPU_GetReg(TOP),fpu.round));
+}
+
+static void FPU_FPREM_common(bool round_nearest){
+	unsigned int q;
+	bool complete;
+	const FPU_Soft80 r = Soft80_Remainder(FPU_GetReg(TOP),FPU_GetReg(STV(1)),round_nearest,q,complete);
+	FPU_SetReg(TOP,r);
+	FPU_SET_C2(complete?0:1);
+	if (Soft80_IsNaN(r)) return;	// invalid operands leave C0, C1 and C3 alone
+	FPU_SET_C0(q&4);
+	FPU_SET_C3(q&2);
+	FPU_SET_C1(q&1);
+}
+
+static void FPU_FPREM(void){
+	FPU_FPREM_common(false);
+}
+
+static void FPU_FPREM1(void){
+	FPU_FPREM_common(true);
+}
+
+static void FPU_FXAM(void){
+	const FPU_Soft80 a = FPU_GetReg(TOP);
+	const unsigned int exp = a.se & 0x7FFFu;
+
+	FPU_SET_C1((a.se & 0x8000u) ? 1 : 0);
+	if(fpu.tags[TOP] == TAG_Empty)
+	{
+		FPU_SET_C3(1);FPU_SET_C2(0);FPU_SET_C0(1);
+		return;
+	}
+	if (exp == 0x7FFFu) {
+		if (!(a.m >> 63)) {			// unsupported
+			FPU_SET_C3(0);FPU_SET_C2(0);FPU_SET_C0(0);
+		}
+		else if ((a.m << 1) == 0) {		// infinity
+			FPU_SET_C3(0);FPU_SET_C2(1);FPU_SET_C0(1);
+		}
+		else {					// NaN
+			FPU_SET_C3(0);FPU_SET_C2(0);FPU_SET_C0(1);
+		}
+	}
+	else if (exp == 0) {
+		if (a.m == 0) {				// zero
+			FPU_SET_C3(1);FPU_SET_C2(0);FPU_SET_C0(0);
+		}
+		else {					// denormal
+			FPU_SET_C3(1);FPU_SET_C2(1);FPU_SET_C0(0);
+		}
+	}
+	else if (a.m >> 63) {				// normal
+		FPU_SET_C3(0);FPU_SET_C2(1);FPU_SET_C0(0);
+	}
+	else {						// unnormal, unsupported
+		FPU_SET_C3(0);FPU_SET_C2(0);FPU_SET_C0(0);
+	}
+}
+
+
+static void FPU_F2XM1(void){
+	FPU_SetReg(TOP,Soft80_FromDouble(expm1(Soft80_ToDouble(FPU_GetReg(TOP)) * LN2)));
+}
+
+static void FPU_FYL2X(void){
+	const double x = Soft80_ToDouble(FPU_GetReg(TOP));
+	const double y = Soft80_ToDouble(FPU_GetReg(STV(1)));
+	FPU_SetReg(STV(1),Soft80_FromDouble(y * (log(x) / LN2)));
+	FPU_FPOP();
+}
+
+static void FPU_FYL2XP1(void){
+	const double x = Soft80_ToDouble(FPU_GetReg(TOP));
+	const double y = Soft80_ToDouble(FPU_GetReg(STV(1)));
+	FPU_SetReg(STV(1),Soft80_FromDouble(y * (log1p(x) / LN2)));
+	FPU_FPOP();
+}
+
+static void FPU_FSCALE(void){
+	FPU_SetReg(TOP,Soft80_Scale(FPU_GetReg(TOP),FPU_GetReg(STV(1)),fpu.round));
+}
+
+static void FPU_FSTENV(PhysPt addr){
+	FPU_SET_TOP(TOP);
+	if(!cpu.code.big) {
+		mem_writew(addr+0,static_cast<uint16_t>(fpu.cw));
+		mem_writew(addr+2,static_cast<uint16_t>(fpu.sw));
+		mem_writew(addr+4,static_cast<uint16_t>(FPU_GetTag()));
+	} else {
+		mem_writed(addr+0,static_cast<uint32_t>(fpu.cw));
+		mem_writed(addr+4,static_cast<uint32_t>(fpu.sw));
+		mem_writed(addr+8,static_cast<uint32_t>(FPU_GetTag()));
+	}
+}
+
+static void FPU_FLDENV(PhysPt addr){
+	uint16_t tag;
+	uint32_t tagbig;
+	Bitu cw;
+	if(!cpu.code.big) {
+		cw     = mem_readw(addr+0);
+		fpu.sw = mem_readw(addr+2);
+		tag    = mem_readw(addr+4);
+	} else {
+		cw     = mem_readd(addr+0);
+		fpu.sw = (uint16_t)mem_readd(addr+4);
+		tagbig = mem_readd(addr+8);
+		tag    = static_cast<uint16_t>(tagbig);
+	}
+	FPU_SetTag(tag);
+	FPU_SetCW(cw);
+	TOP = FPU_GET_TOP();
+}
+
+static void FPU_FSAVE(PhysPt addr){
+	FPU_FSTENV(addr);
+	Bitu start = (cpu.code.big?28:14);
+	for(Bitu i = 0;i < 8;i++){
+		FPU_ST80(addr+start,STV(i));
+		start += 10;
+	}
+	FPU_FINIT();
+}
+
+static void FPU_FRSTOR(PhysPt addr){
+	FPU_FLDENV(addr);
+	Bitu start = (cpu.code.big?28:14);
+	for(Bitu i = 0;i < 8;i++){
+		FPU_FLD80(addr+start,STV(i));
+		start += 10;
+	}
+}
+
+static void FPU_FXTRACT(void) {
+	// function stores real bias in st and
+	// pushes the significant number onto the stack
+	const FPU_Soft80 a = FPU_GetReg(TOP);
+	unsigned int sign;
+	int32_t exp;
+	uint64_t m;
+
+	switch (Soft80_Unpack(a,sign,exp,m)) {
+		case SOFT80_NAN:
+			FPU_SetReg(TOP,Soft80_PropagateNaN(a,a));
+			FPU_PUSH(Soft80_PropagateNaN(a,a));
+			break;
+		case SOFT80_INVALID:
+			FPU_SetReg(TOP,Soft80_Indefinite());
+			FPU_PUSH(Soft80_Indefinite());
+			break;
+		case SOFT80_ZERO:	// divide by zero, masked
+			FPU_SetReg(TOP,Soft80_Inf(1));
+			FPU_PUSH(a);
+			break;
+		case SOFT80_INF:
+			FPU_SetReg(TOP,Soft80_Inf(0));
+			FPU_PUSH(a);
+			break;
+		default:
+			FPU_SetReg(TOP,Soft80_FromI64(exp - FPU_Reg_80_exponent_bias));
+			FPU_PUSH(Soft80_Make(sign,FPU_Reg_80_exponent_bias,m));
+			break;
+	}
+}
+
+static void FPU_FCHS(void){
+	fpu.regs_80[TOP].raw.h ^= 0x8000u;
+}
+
+static void FPU_FABS(void){
+	fpu.regs_80[TOP].raw.h &= 0x7FFFu;
+}
+
+static void FPU_FTST(void){
+	FPU_SetReg(8,Soft80_Zero(0));
+	FPU_FCOM(TOP,8);
+}
+
+static void FPU_FLD1(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_ONE);
+}
+
+static void FPU_FLDL2T(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_L2T);
+}
+
+static void FPU_FLDL2E(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_L2E);
+}
+
+static void FPU_FLDPI(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_PI);
+}
+
+static void FPU_FLDLG2(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_LG2);
+}
+
+static void FPU_FLDLN2(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,SOFT80_LN2);
+}
+
+static void FPU_FLDZ(void){
+	FPU_PREP_PUSH();
+	FPU_SetReg(TOP,Soft80_Zero(0));
+	fpu.tags[TOP] = TAG_Zero;
+}
+
+
+static INLINE void FPU_FADD_EA(Bitu op1){
+	FPU_FADD(op1,8);
+}
+static INLINE void FPU_FMUL_EA(Bitu op1){
+	FPU_FMUL(op1,8);
+}
+static INLINE void FPU_FSUB_EA(Bitu op1){
+	FPU_FSUB(op1,8);
+}
+static INLINE void FPU_FSUBR_EA(Bitu op1){
+	FPU_FSUBR(op1,8);
+}
+static INLINE void FPU_FDIV_EA(Bitu op1){
+	FPU_FDIV(op1,8);
+}
+static INLINE void FPU_FDIVR_EA(Bitu op1){
+	FPU_FDIVR(op1,8);
+}
+static INLINE void FPU_FCOM_EA(Bitu op1){
+	FPU_FCOM(op1,8);
+}
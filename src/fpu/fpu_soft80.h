@@ -0,0 +1,965 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* 80-bit extended precision arithmetic in software, for hosts where "long double"
+ * is not the x87 format (fpu_instructions_soft80.h). Values are kept exactly as
+ * in an x87 register: 64-bit significand with explicit integer bit, 15-bit biased
+ * exponent and sign. Results are rounded to the precision control (24, 53 or 64
+ * bits) and rounding control of the control word, with the extended exponent range.
+ *
+ * The arithmetic first tries the host "double": when both operands are exactly
+ * representable as double, the double result is the x87 result if it is exact, or
+ * if rounding is to nearest at 53-bit precision (or at 24-bit precision with single
+ * precision operands, rounding the double result again) and it is a normal number.
+ * Everything else (64-bit precision with inexact results, directed rounding, operands
+ * with more than 53 significant bits, zero, denormal, infinite and NaN results) is
+ * done in integer arithmetic.
+ *
+ * Transcendental functions (FSIN, FPATAN, F2XM1, ...) are computed in double.
+ *
+ * This header only depends on the C library so that experiments/fpu can test it
+ * against a host x87. */
+
+#ifndef DOSBOX_FPU_SOFT80_H
+#define DOSBOX_FPU_SOFT80_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <cmath>
+
+typedef struct {
+	uint64_t	m;		/* significand, bit 63 is the integer bit */
+	uint16_t	se;		/* sign (bit 15) and biased exponent */
+} FPU_Soft80;
+
+#define SOFT80_BIAS		16383
+#define SOFT80_EXP_MAX		0x7FFF
+#define SOFT80_INT_BIT		((uint64_t)1 << 63)
+#define SOFT80_QUIET_BIT	((uint64_t)1 << 62)
+
+/* rounding control, same values as enum FPU_Round */
+#define SOFT80_RC_NEAREST	0
+#define SOFT80_RC_DOWN		1
+#define SOFT80_RC_UP		2
+#define SOFT80_RC_CHOP		3
+
+enum {
+	SOFT80_ZERO = 0,
+	SOFT80_FINITE,
+	SOFT80_INF,
+	SOFT80_NAN,
+	SOFT80_INVALID		/* unnormal, pseudo-infinity or pseudo-NaN, rejected since the 387 */
+};
+
+#if defined(FP_FAST_FMA)
+# define SOFT80_FAST_FMA	1
+#endif
+
+/* precision control field of the control word to significand bits, 1 is reserved */
+static inline unsigned int Soft80_Precision(unsigned int pc) {
+	static const unsigned char bits[4] = { 24, 64, 53, 64 };
+	return bits[pc & 3];
+}
+
+static inline unsigned int Soft80_CLZ64(uint64_t x) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_clzll(x);
+#else
+	unsigned int n = 0;
+	if (!(x >> 32)) { n += 32; x <<= 32; }
+	if (!(x >> 48)) { n += 16; x <<= 16; }
+	if (!(x >> 56)) { n += 8; x <<= 8; }
+	if (!(x >> 60)) { n += 4; x <<= 4; }
+	if (!(x >> 62)) { n += 2; x <<= 2; }
+	if (!(x >> 63)) { n += 1; }
+	return n;
+#endif
+}
+
+static inline unsigned int Soft80_CTZ64(uint64_t x) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctzll(x);
+#else
+	unsigned int n = 0;
+	while (!(x & 1)) { n++; x >>= 1; }
+	return n;
+#endif
+}
+
+/* 64x64 -> 128 bit multiply */
+static inline void Soft80_Mul64(uint64_t a,uint64_t b,uint64_t &hi,uint64_t &lo) {
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 u128;
+	const u128 p = (u128)a * b;
+	hi = (uint64_t)(p >> 64);
+	lo = (uint64_t)p;
+#else
+	const uint64_t al = (uint32_t)a, ah = a >> 32;
+	const uint64_t bl = (uint32_t)b, bh = b >> 32;
+	const uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+	const uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+	lo = (mid << 32) | (uint32_t)ll;
+	hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/* (nh:nl) / d, requires nh < d */
+static inline uint64_t Soft80_Div128(uint64_t nh,uint64_t nl,uint64_t d,uint64_t &rem) {
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 u128;
+	const u128 n = ((u128)nh << 64) | nl;
+	rem = (uint64_t)(n % d);
+	return (uint64_t)(n / d);
+#else
+	uint64_t q = 0;
+	for (unsigned int i = 0;i < 64;i++) {
+		const bool carry = (nh >> 63) != 0;
+		nh = (nh << 1) | (nl >> 63);
+		nl <<= 1;
+		q <<= 1;
+		if (carry || nh >= d) {
+			nh -= d;
+			q |= 1;
+		}
+	}
+	rem = nh;
+	return q;
+#endif
+}
+
+/* shift (hi:lo) right by n, or-ing everything shifted out into the lowest bit */
+static inline void Soft80_ShiftRightJam(uint64_t &hi,uint64_t &lo,int32_t n) {
+	if (n <= 0) return;
+	if (n < 64) {
+		lo = (hi << (64 - n)) | (lo >> n) | ((lo << (64 - n)) != 0 ? 1 : 0);
+		hi >>= n;
+	}
+	else if (n == 64) {
+		lo = hi | (lo != 0 ? 1 : 0);
+		hi = 0;
+	}
+	else if (n < 128) {
+		lo = (hi >> (n - 64)) | (((hi << (128 - n)) | lo) != 0 ? 1 : 0);
+		hi = 0;
+	}
+	else {
+		lo = (hi | lo) != 0 ? 1 : 0;
+		hi = 0;
+	}
+}
+
+static inline FPU_Soft80 Soft80_Make(unsigned int sign,unsigned int exp,uint64_t m) {
+	FPU_Soft80 r;
+	r.m = m;
+	r.se = (uint16_t)((sign << 15) | exp);
+	return r;
+}
+
+static inline FPU_Soft80 Soft80_Zero(unsigned int sign) {
+	return Soft80_Make(sign,0,0);
+}
+
+static inline FPU_Soft80 Soft80_Inf(unsigned int sign) {
+	return Soft80_Make(sign,SOFT80_EXP_MAX,SOFT80_INT_BIT);
+}
+
+/* the "real indefinite" QNaN returned by invalid operations */
+static inline FPU_Soft80 Soft80_Indefinite(void) {
+	return Soft80_Make(1,SOFT80_EXP_MAX,SOFT80_INT_BIT | SOFT80_QUIET_BIT);
+}
+
+static inline bool Soft80_IsNaN(const FPU_Soft80 &a) {
+	return (a.se & SOFT80_EXP_MAX) == SOFT80_EXP_MAX && (a.m << 1) != 0;
+}
+
+/* zero, denormal, unnormal, infinity or NaN */
+static inline bool Soft80_NotNormal(const FPU_Soft80 &a) {
+	const unsigned int e = a.se & SOFT80_EXP_MAX;
+	return e == 0 || e == SOFT80_EXP_MAX || !(a.m >> 63);
+}
+
+/* Split into sign, exponent and significand. Finite nonzero values come back
+ * normalized (integer bit set), denormals with an exponent below 1. */
+static inline unsigned int Soft80_Unpack(const FPU_Soft80 &a,unsigned int &sign,int32_t &exp,uint64_t &m) {
+	sign = a.se >> 15;
+	exp = a.se & SOFT80_EXP_MAX;
+	m = a.m;
+	if (exp == SOFT80_EXP_MAX) {
+		if (!(m >> 63)) return SOFT80_INVALID;
+		return ((m << 1) == 0) ? SOFT80_INF : SOFT80_NAN;
+	}
+	if (exp == 0) {
+		if (m == 0) return SOFT80_ZERO;
+		exp = 1;			/* denormal, or pseudo-denormal with the integer bit set */
+	}
+	else if (!(m >> 63)) {
+		return SOFT80_INVALID;
+	}
+	if (!(m >> 63)) {
+		const unsigned int s = Soft80_CLZ64(m);
+		m <<= s;
+		exp -= (int32_t)s;
+	}
+	return SOFT80_FINITE;
+}
+
+/* NaN result of an operation with a NaN operand: a QNaN operand is preferred over
+ * a SNaN, otherwise the larger significand wins. The result is always quiet. */
+static inline FPU_Soft80 Soft80_PropagateNaN(const FPU_Soft80 &a,const FPU_Soft80 &b) {
+	const bool an = Soft80_IsNaN(a), bn = Soft80_IsNaN(b);
+	FPU_Soft80 r;
+
+	if (an && bn) {
+		const bool aq = (a.m & SOFT80_QUIET_BIT) != 0, bq = (b.m & SOFT80_QUIET_BIT) != 0;
+		if (aq != bq) r = aq ? a : b;
+		else r = ((a.m << 1) >= (b.m << 1)) ? a : b;
+	}
+	else {
+		r = an ? a : b;
+	}
+	r.m |= SOFT80_QUIET_BIT;
+	return r;
+}
+
+/* Round (m:x) * 2^(exp - BIAS - 63) to pc significand bits in rounding mode rc.
+ * x holds the bits below m, its lowest bit may be a sticky bit. m need not be
+ * normalized, exp may be out of range (denormal result or overflow). */
+static FPU_Soft80 Soft80_RoundPack(unsigned int sign,int32_t exp,uint64_t m,uint64_t x,unsigned int pc,unsigned int rc) {
+	if (m == 0) {
+		if (x == 0) return Soft80_Zero(sign);
+		m = x;
+		x = 0;
+		exp -= 64;
+	}
+	if (!(m >> 63)) {
+		const unsigned int s = Soft80_CLZ64(m);
+		m = (m << s) | (x >> (64 - s));
+		x <<= s;
+		exp -= (int32_t)s;
+	}
+	if (exp <= 0) {
+		Soft80_ShiftRightJam(m,x,1 - exp);
+		exp = 0;
+	}
+
+	bool inexact, nearest_up;
+	uint64_t lsb;
+	if (pc >= 64) {
+		inexact = x != 0;
+		nearest_up = x > SOFT80_INT_BIT || (x == SOFT80_INT_BIT && (m & 1));
+		lsb = 1;
+	}
+	else {
+		lsb = (uint64_t)1 << (64 - pc);
+		const uint64_t low = m & (lsb - 1), half = lsb >> 1;
+		inexact = low != 0 || x != 0;
+		nearest_up = low > half || (low == half && (x != 0 || (m & lsb)));
+		m &= ~(lsb - 1);
+	}
+
+	bool up;
+	switch (rc) {
+		case SOFT80_RC_NEAREST:	up = nearest_up; break;
+		case SOFT80_RC_DOWN:	up = inexact && sign; break;
+		case SOFT80_RC_UP:	up = inexact && !sign; break;
+		default:		up = false; break;
+	}
+	if (up) {
+		m += lsb;
+		if (m == 0) {
+			m = SOFT80_INT_BIT;
+			exp++;
+		}
+	}
+	if (exp == 0 && (m >> 63)) exp = 1;	/* denormal rounded up to the smallest normal */
+
+	if (exp >= SOFT80_EXP_MAX) {
+		/* overflow, masked: infinity, or the largest finite value when rounding towards zero */
+		if (rc == SOFT80_RC_NEAREST || (rc == SOFT80_RC_UP && !sign) || (rc == SOFT80_RC_DOWN && sign))
+			return Soft80_Inf(sign);
+		return Soft80_Make(sign,SOFT80_EXP_MAX - 1,(pc >= 64) ? ~(uint64_t)0 : ~(((uint64_t)1 << (64 - pc)) - 1));
+	}
+	return Soft80_Make(sign,(unsigned int)exp,m);
+}
+
+/* Fast path helpers. Soft80_ToDouble_Exact converts a if it is zero or a normal
+ * value with at most 53 significant bits in the double exponent range. */
+static inline bool Soft80_ToDouble_Exact(const FPU_Soft80 &a,double &d) {
+	const uint32_t e = a.se & SOFT80_EXP_MAX;
+	uint64_t bits;
+
+	if (e == 0) {
+		if (a.m != 0) return false;
+		bits = 0;
+	}
+	else {
+		if ((a.m & 0x7FF) != 0 || !(a.m >> 63) || (e - (SOFT80_BIAS - 1022)) >= 2046u) return false;
+		bits = ((uint64_t)(e - SOFT80_BIAS + 1023) << 52) | ((a.m >> 11) & 0xFFFFFFFFFFFFFull);
+	}
+	bits |= (uint64_t)(a.se >> 15) << 63;
+	memcpy(&d,&bits,sizeof(d));
+	return true;
+}
+
+/* at most 24 significant bits */
+static inline bool Soft80_IsSingle(const FPU_Soft80 &a) {
+	return (a.m & 0xFFFFFFFFFFull) == 0;
+}
+
+enum {
+	SOFT80_FAST_EXACT = 0,		/* only an exact double result can be used */
+	SOFT80_FAST_53,			/* the double result is the x87 result */
+	SOFT80_FAST_24			/* the double result rounded to 24 bits is the x87 result */
+};
+
+static inline unsigned int Soft80_FastMode(unsigned int pc,unsigned int rc,bool single) {
+	if (rc != SOFT80_RC_NEAREST) return SOFT80_FAST_EXACT;
+	if (pc == 53) return SOFT80_FAST_53;
+	if (pc == 24 && single) return SOFT80_FAST_24;
+	return SOFT80_FAST_EXACT;
+}
+
+/* Convert the double result r of a fast path operation. Fails for zero, denormal,
+ * infinite and NaN results (which need the sign and exception rules of the x87) and
+ * for exact results with more significant bits than the precision control allows. */
+static inline bool Soft80_FromDouble_Fast(double r,unsigned int mode,unsigned int pc,FPU_Soft80 &res) {
+	uint64_t bits;
+	memcpy(&bits,&r,sizeof(bits));
+
+	if (mode == SOFT80_FAST_24) {
+		/* round to nearest even at 24 bits, a carry moves into the exponent */
+		const uint64_t low = bits & 0x1FFFFFFFull;
+		bits &= ~0x1FFFFFFFull;
+		if (low > 0x10000000ull || (low == 0x10000000ull && (bits & 0x20000000ull))) bits += 0x20000000ull;
+	}
+	else if (mode == SOFT80_FAST_EXACT && pc == 24) {
+		if (bits & 0x1FFFFFFFull) return false;
+	}
+
+	const unsigned int e = (unsigned int)(bits >> 52) & 0x7FF;
+	if (e == 0 || e == 0x7FF) return false;
+	res.m = SOFT80_INT_BIT | (bits << 11);
+	res.se = (uint16_t)(((bits >> 63) << 15) | (e - 1023 + SOFT80_BIAS));
+	return true;
+}
+
+/* TwoSum, the rounding error of r = x + y (exactly representable, barring overflow) */
+static inline double Soft80_AddError(double x,double y,double r) {
+	const double t = r - x;
+	return (x - (r - t)) + (y - t);
+}
+
+/* The exact sum r + err of a TwoSum at 64-bit precision, if it fits in 64 bits.
+ * Sums of values with nearby exponents usually do, which keeps the default
+ * precision control of DOS programs off the integer path. */
+static inline bool Soft80_FromDouble_Sum(double r,double err,FPU_Soft80 &res) {
+	uint64_t rb, eb;
+	memcpy(&rb,&r,sizeof(rb));
+	memcpy(&eb,&err,sizeof(eb));
+
+	const unsigned int er = (unsigned int)(rb >> 52) & 0x7FF, ee = (unsigned int)(eb >> 52) & 0x7FF;
+	if (er == 0 || er == 0x7FF || ee == 0 || er - ee > 63) return false;
+
+	/* err is below half an ulp of r, so its bits land in the 11 bits below r's significand */
+	const unsigned int shift = er - ee;
+	const uint64_t me = SOFT80_INT_BIT | (eb << 11);
+	if (Soft80_CTZ64(me) < shift) return false;
+
+	uint64_t m = SOFT80_INT_BIT | (rb << 11);
+	unsigned int exp = er - 1023 + SOFT80_BIAS;
+	if ((rb ^ eb) >> 63) {
+		m -= me >> shift;
+		if (!(m >> 63)) {
+			m <<= 1;
+			exp--;
+		}
+	}
+	else {
+		m += me >> shift;
+	}
+	res = Soft80_Make((unsigned int)(rb >> 63),exp,m);
+	return true;
+}
+
+static inline bool Soft80_ExactMul(const FPU_Soft80 &a,const FPU_Soft80 &b,double x,double y,double r) {
+	/* few enough significant bits, which covers integers and short fractions */
+	if (a.m == 0 || b.m == 0 || (128 - Soft80_CTZ64(a.m) - Soft80_CTZ64(b.m)) <= 53) return true;
+#if defined(SOFT80_FAST_FMA)
+	return std::fma(x,y,-r) == 0.0;
+#else
+	(void)x; (void)y; (void)r;
+	return false;
+#endif
+}
+
+static inline bool Soft80_ExactDiv(double x,double y,double r) {
+#if defined(SOFT80_FAST_FMA)
+	return std::fma(r,y,-x) == 0.0;
+#else
+	(void)x; (void)y; (void)r;
+	return false;
+#endif
+}
+
+static inline bool Soft80_ExactSqrt(double x,double r) {
+#if defined(SOFT80_FAST_FMA)
+	return std::fma(r,r,-x) == 0.0;
+#else
+	(void)x; (void)r;
+	return false;
+#endif
+}
+
+/* Software arithmetic */
+
+static FPU_Soft80 Soft80_AddSlow(const FPU_Soft80 &a,const FPU_Soft80 &b,bool sub,unsigned int pc,unsigned int rc) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+
+	sb ^= sub ? 1 : 0;
+	if (ca == SOFT80_INVALID || cb == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN) return Soft80_PropagateNaN(a,b);
+	if (ca == SOFT80_INF) {
+		if (cb == SOFT80_INF && sa != sb) return Soft80_Indefinite();
+		return Soft80_Inf(sa);
+	}
+	if (cb == SOFT80_INF) return Soft80_Inf(sb);
+	if (ca == SOFT80_ZERO && cb == SOFT80_ZERO)
+		return Soft80_Zero((sa == sb) ? sa : (rc == SOFT80_RC_DOWN ? 1 : 0));
+	if (ca == SOFT80_ZERO) return Soft80_RoundPack(sb,eb,mb,0,pc,rc);
+	if (cb == SOFT80_ZERO) return Soft80_RoundPack(sa,ea,ma,0,pc,rc);
+
+	if (ea < eb || (ea == eb && ma < mb)) {
+		unsigned int ts = sa; sa = sb; sb = ts;
+		int32_t te = ea; ea = eb; eb = te;
+		uint64_t tm = ma; ma = mb; mb = tm;
+	}
+
+	uint64_t bh = mb, bl = 0;
+	Soft80_ShiftRightJam(bh,bl,ea - eb);
+	if (sa == sb) {
+		uint64_t hi = ma + bh, lo = bl;
+		if (hi < ma) {
+			lo = (lo >> 1) | (hi << 63) | (lo & 1);
+			hi = (hi >> 1) | SOFT80_INT_BIT;
+			ea++;
+		}
+		return Soft80_RoundPack(sa,ea,hi,lo,pc,rc);
+	}
+
+	const uint64_t lo = (uint64_t)0 - bl;
+	const uint64_t hi = ma - bh - (bl != 0 ? 1 : 0);
+	if (hi == 0 && lo == 0) return Soft80_Zero(rc == SOFT80_RC_DOWN ? 1 : 0);
+	return Soft80_RoundPack(sa,ea,hi,lo,pc,rc);
+}
+
+static FPU_Soft80 Soft80_MulSlow(const FPU_Soft80 &a,const FPU_Soft80 &b,unsigned int pc,unsigned int rc) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+	const unsigned int sign = sa ^ sb;
+
+	if (ca == SOFT80_INVALID || cb == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN) return Soft80_PropagateNaN(a,b);
+	if (ca == SOFT80_INF || cb == SOFT80_INF) {
+		if (ca == SOFT80_ZERO || cb == SOFT80_ZERO) return Soft80_Indefinite();
+		return Soft80_Inf(sign);
+	}
+	if (ca == SOFT80_ZERO || cb == SOFT80_ZERO) return Soft80_Zero(sign);
+
+	uint64_t hi, lo;
+	int32_t exp = ea + eb - SOFT80_BIAS + 1;
+	Soft80_Mul64(ma,mb,hi,lo);
+	if (!(hi >> 63)) {
+		hi = (hi << 1) | (lo >> 63);
+		lo <<= 1;
+		exp--;
+	}
+	return Soft80_RoundPack(sign,exp,hi,lo,pc,rc);
+}
+
+static FPU_Soft80 Soft80_DivSlow(const FPU_Soft80 &a,const FPU_Soft80 &b,unsigned int pc,unsigned int rc) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+	const unsigned int sign = sa ^ sb;
+
+	if (ca == SOFT80_INVALID || cb == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN) return Soft80_PropagateNaN(a,b);
+	if (ca == SOFT80_INF) {
+		if (cb == SOFT80_INF) return Soft80_Indefinite();
+		return Soft80_Inf(sign);
+	}
+	if (cb == SOFT80_INF) return Soft80_Zero(sign);
+	if (cb == SOFT80_ZERO) {
+		if (ca == SOFT80_ZERO) return Soft80_Indefinite();
+		return Soft80_Inf(sign);	/* division by zero, masked */
+	}
+	if (ca == SOFT80_ZERO) return Soft80_Zero(sign);
+
+	uint64_t nh, nl, rem, rem2;
+	int32_t exp;
+	if (ma >= mb) {
+		nh = ma >> 1;
+		nl = ma << 63;
+		exp = ea - eb + SOFT80_BIAS;
+	}
+	else {
+		nh = ma;
+		nl = 0;
+		exp = ea - eb + SOFT80_BIAS - 1;
+	}
+	const uint64_t q = Soft80_Div128(nh,nl,mb,rem);
+	const uint64_t q2 = Soft80_Div128(rem,0,mb,rem2);
+	return Soft80_RoundPack(sign,exp,q,q2 | (rem2 != 0 ? 1 : 0),pc,rc);
+}
+
+static FPU_Soft80 Soft80_SqrtSlow(const FPU_Soft80 &a,unsigned int pc,unsigned int rc) {
+	unsigned int sa;
+	int32_t ea;
+	uint64_t ma;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+
+	if (ca == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN) return Soft80_PropagateNaN(a,a);
+	if (ca == SOFT80_ZERO) return a;
+	if (sa) return Soft80_Indefinite();
+	if (ca == SOFT80_INF) return a;
+
+	/* integer square root of the significand scaled to 127 or 128 bits, so that
+	 * the root has 64 bits and the exponent stays a whole number */
+	const int32_t e = ea - SOFT80_BIAS;
+	uint64_t nh, nl;
+	int32_t exp;
+	if (e & 1) {
+		nh = ma;
+		nl = 0;
+		exp = (e - 1) / 2 + SOFT80_BIAS;
+	}
+	else {
+		nh = ma >> 1;
+		nl = ma << 63;
+		exp = e / 2 + SOFT80_BIAS;
+	}
+
+	uint64_t rh = 0, rl = 0, bh = (uint64_t)1 << 62, bl = 0;
+	for (unsigned int i = 0;i < 64;i++) {
+		const uint64_t tl = rl + bl;
+		const uint64_t th = rh + bh + (tl < rl ? 1 : 0);
+		const bool ge = nh > th || (nh == th && nl >= tl);
+		if (ge) {
+			nh = nh - th - (nl < tl ? 1 : 0);
+			nl -= tl;
+		}
+		rl = (rl >> 1) | (rh << 63);
+		rh >>= 1;
+		if (ge) {
+			rl += bl;
+			rh += bh + (rl < bl ? 1 : 0);
+		}
+		bl = (bl >> 2) | (bh << 62);
+		bh >>= 2;
+	}
+
+	/* remainder n - root^2 is at most 2*root, above root means above the halfway point */
+	uint64_t x = 0;
+	if (nh != 0 || nl != 0) x = (nh != 0 || nl > rl) ? (SOFT80_INT_BIT | 1) : 1;
+	return Soft80_RoundPack(0,exp,rl,x,pc,rc);
+}
+
+/* Arithmetic with the double fast path */
+
+static inline FPU_Soft80 Soft80_Add(const FPU_Soft80 &a,const FPU_Soft80 &b,bool sub,unsigned int pc,unsigned int rc) {
+	double x, y;
+	if (Soft80_ToDouble_Exact(a,x) && Soft80_ToDouble_Exact(b,y)) {
+		if (sub) y = -y;
+		const double r = x + y;
+		const unsigned int mode = Soft80_FastMode(pc,rc,Soft80_IsSingle(a) && Soft80_IsSingle(b));
+		FPU_Soft80 res;
+		if (mode != SOFT80_FAST_EXACT) {
+			if (Soft80_FromDouble_Fast(r,mode,pc,res)) return res;
+		}
+		else {
+			const double err = Soft80_AddError(x,y,r);
+			if (err == 0.0) {
+				if (Soft80_FromDouble_Fast(r,mode,pc,res)) return res;
+			}
+			else if (pc == 64 && Soft80_FromDouble_Sum(r,err,res)) {
+				return res;
+			}
+		}
+	}
+	return Soft80_AddSlow(a,b,sub,pc,rc);
+}
+
+static inline FPU_Soft80 Soft80_Mul(const FPU_Soft80 &a,const FPU_Soft80 &b,unsigned int pc,unsigned int rc) {
+	double x, y;
+	if (Soft80_ToDouble_Exact(a,x) && Soft80_ToDouble_Exact(b,y)) {
+		const double r = x * y;
+		const unsigned int mode = Soft80_FastMode(pc,rc,Soft80_IsSingle(a) && Soft80_IsSingle(b));
+		FPU_Soft80 res;
+		if ((mode != SOFT80_FAST_EXACT || Soft80_ExactMul(a,b,x,y,r)) && Soft80_FromDouble_Fast(r,mode,pc,res)) return res;
+	}
+	return Soft80_MulSlow(a,b,pc,rc);
+}
+
+static inline FPU_Soft80 Soft80_Div(const FPU_Soft80 &a,const FPU_Soft80 &b,unsigned int pc,unsigned int rc) {
+	double x, y;
+	if (Soft80_ToDouble_Exact(a,x) && Soft80_ToDouble_Exact(b,y) && y != 0.0) {
+		const double r = x / y;
+		const unsigned int mode = Soft80_FastMode(pc,rc,Soft80_IsSingle(a) && Soft80_IsSingle(b));
+		FPU_Soft80 res;
+		if ((mode != SOFT80_FAST_EXACT || Soft80_ExactDiv(x,y,r)) && Soft80_FromDouble_Fast(r,mode,pc,res)) return res;
+	}
+	return Soft80_DivSlow(a,b,pc,rc);
+}
+
+static inline FPU_Soft80 Soft80_Sqrt(const FPU_Soft80 &a,unsigned int pc,unsigned int rc) {
+	double x;
+	if (Soft80_ToDouble_Exact(a,x) && x > 0.0) {
+		const double r = sqrt(x);
+		const unsigned int mode = Soft80_FastMode(pc,rc,Soft80_IsSingle(a));
+		FPU_Soft80 res;
+		if ((mode != SOFT80_FAST_EXACT || Soft80_ExactSqrt(x,r)) && Soft80_FromDouble_Fast(r,mode,pc,res)) return res;
+	}
+	return Soft80_SqrtSlow(a,pc,rc);
+}
+
+/* -1 a < b, 0 a == b, 1 a > b, 2 unordered */
+static int Soft80_Compare(const FPU_Soft80 &a,const FPU_Soft80 &b) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN || ca == SOFT80_INVALID || cb == SOFT80_INVALID) return 2;
+	if (ca == SOFT80_ZERO && cb == SOFT80_ZERO) return 0;
+	if (ca == SOFT80_ZERO) return sb ? 1 : -1;
+	if (cb == SOFT80_ZERO) return sa ? -1 : 1;
+	if (sa != sb) return sa ? -1 : 1;
+	if (ca == SOFT80_INF) { ea = SOFT80_EXP_MAX; ma = SOFT80_INT_BIT; }
+	if (cb == SOFT80_INF) { eb = SOFT80_EXP_MAX; mb = SOFT80_INT_BIT; }
+
+	int mag;
+	if (ea != eb) mag = (ea > eb) ? 1 : -1;
+	else if (ma != mb) mag = (ma > mb) ? 1 : -1;
+	else mag = 0;
+	return sa ? -mag : mag;
+}
+
+/* Conversions */
+
+static inline FPU_Soft80 Soft80_FromU64(unsigned int sign,uint64_t v) {
+	if (v == 0) return Soft80_Zero(sign);
+	const unsigned int s = Soft80_CLZ64(v);
+	return Soft80_Make(sign,SOFT80_BIAS + 63 - s,v << s);
+}
+
+static inline FPU_Soft80 Soft80_FromI64(int64_t v) {
+	if (v < 0) return Soft80_FromU64(1,(uint64_t)0 - (uint64_t)v);
+	return Soft80_FromU64(0,(uint64_t)v);
+}
+
+/* load a binary32/binary64 image, p = significand bits with the implied bit */
+static inline FPU_Soft80 Soft80_FromBinary(uint64_t bits,unsigned int p,unsigned int ebits) {
+	const unsigned int sign = (unsigned int)(bits >> (p + ebits - 1)) & 1;
+	const unsigned int emax = (1u << ebits) - 1, bias = emax >> 1;
+	const unsigned int e = (unsigned int)(bits >> (p - 1)) & emax;
+	const uint64_t f = bits & (((uint64_t)1 << (p - 1)) - 1);
+
+	if (e == emax) {
+		if (f == 0) return Soft80_Inf(sign);
+		return Soft80_Make(sign,SOFT80_EXP_MAX,SOFT80_INT_BIT | SOFT80_QUIET_BIT | (f << (64 - p)));
+	}
+	if (e == 0) {
+		if (f == 0) return Soft80_Zero(sign);
+		const unsigned int s = Soft80_CLZ64(f);
+		return Soft80_Make(sign,SOFT80_BIAS + 63 - (bias + p - 2) - s,f << s);
+	}
+	return Soft80_Make(sign,e - bias + SOFT80_BIAS,SOFT80_INT_BIT | (f << (64 - p)));
+}
+
+static inline FPU_Soft80 Soft80_FromF32(uint32_t bits) {
+	return Soft80_FromBinary(bits,24,8);
+}
+
+static inline FPU_Soft80 Soft80_FromF64(uint64_t bits) {
+	return Soft80_FromBinary(bits,53,11);
+}
+
+/* store as binary32/binary64 image, rounded in mode rc */
+static uint64_t Soft80_ToBinary(const FPU_Soft80 &a,unsigned int p,unsigned int ebits,unsigned int rc) {
+	unsigned int sign;
+	int32_t exp;
+	uint64_t m;
+	const unsigned int c = Soft80_Unpack(a,sign,exp,m);
+	const int32_t emax = (1 << ebits) - 1, bias = emax >> 1;
+	const uint64_t inf = (uint64_t)emax << (p - 1);
+	const uint64_t sbit = (uint64_t)sign << (p + ebits - 1);
+
+	if (c == SOFT80_ZERO) return sbit;
+	if (c == SOFT80_INF) return sbit | inf;
+	if (c == SOFT80_NAN) return sbit | inf | ((m | SOFT80_QUIET_BIT) << 1 >> (65 - p));
+	if (c == SOFT80_INVALID) return ((uint64_t)1 << (p + ebits - 1)) | inf | ((uint64_t)1 << (p - 2));
+
+	const int32_t e = exp - SOFT80_BIAS;
+	const int32_t emin = 1 - bias;
+	bool overflow = e > bias;
+	uint64_t r = 0;
+
+	if (!overflow) {
+		int32_t shift = 64 - (int32_t)p;
+		if (e < emin) shift += emin - e;
+
+		uint64_t keep, low, half;
+		bool inexact, nearest_up;
+		if (shift < 64) {
+			keep = m >> shift;
+			low = m & (((uint64_t)1 << shift) - 1);
+			half = (uint64_t)1 << (shift - 1);
+			inexact = low != 0;
+			nearest_up = low > half || (low == half && (keep & 1));
+		}
+		else {
+			keep = 0;
+			inexact = true;
+			nearest_up = (shift == 64) && m > SOFT80_INT_BIT;
+		}
+
+		bool up;
+		switch (rc) {
+			case SOFT80_RC_NEAREST:	up = nearest_up; break;
+			case SOFT80_RC_DOWN:	up = inexact && sign; break;
+			case SOFT80_RC_UP:	up = inexact && !sign; break;
+			default:		up = false; break;
+		}
+		if (up) keep++;
+
+		/* the implied bit of a normal number adds one to the biased exponent, a carry out of
+		 * the significand rounds up to the next exponent (or from denormal to normal) */
+		if (e < emin) r = keep;
+		else r = ((uint64_t)(e + bias - 1) << (p - 1)) + keep;
+		overflow = r >= inf;
+	}
+	if (overflow) {
+		if (rc == SOFT80_RC_NEAREST || (rc == SOFT80_RC_UP && !sign) || (rc == SOFT80_RC_DOWN && sign)) r = inf;
+		else r = inf - 1;
+	}
+	return sbit | r;
+}
+
+static inline uint32_t Soft80_ToF32(const FPU_Soft80 &a,unsigned int rc) {
+	return (uint32_t)Soft80_ToBinary(a,24,8,rc);
+}
+
+static inline uint64_t Soft80_ToF64(const FPU_Soft80 &a,unsigned int rc) {
+	return Soft80_ToBinary(a,53,11,rc);
+}
+
+/* nearest double, for the transcendental functions and the debugger */
+static inline double Soft80_ToDouble(const FPU_Soft80 &a) {
+	double d;
+	const uint64_t bits = Soft80_ToF64(a,SOFT80_RC_NEAREST);
+	memcpy(&d,&bits,sizeof(d));
+	return d;
+}
+
+static inline FPU_Soft80 Soft80_FromDouble(double d) {
+	uint64_t bits;
+	memcpy(&bits,&d,sizeof(bits));
+	return Soft80_FromF64(bits);
+}
+
+/* Round to an integer in mode rc, returns false if the magnitude does not fit in 64 bits
+ * (or a is infinite or NaN). */
+static bool Soft80_RoundToInt(const FPU_Soft80 &a,unsigned int rc,unsigned int &sign,uint64_t &mag) {
+	int32_t exp;
+	uint64_t m;
+	const unsigned int c = Soft80_Unpack(a,sign,exp,m);
+
+	mag = 0;
+	if (c == SOFT80_ZERO) return true;
+	if (c != SOFT80_FINITE) return false;
+
+	const int32_t e = exp - SOFT80_BIAS;
+	if (e >= 64) return false;
+	if (e == 63) {
+		mag = m;
+		return true;
+	}
+
+	uint64_t low, half;
+	if (e >= 0) {
+		const unsigned int shift = (unsigned int)(63 - e);
+		mag = m >> shift;
+		low = m & (((uint64_t)1 << shift) - 1);
+		half = (uint64_t)1 << (shift - 1);
+	}
+	else if (e == -1) {
+		low = m;
+		half = SOFT80_INT_BIT;
+	}
+	else {
+		low = 1;			/* below one half, the value is only sticky */
+		half = SOFT80_INT_BIT;
+	}
+
+	bool up;
+	switch (rc) {
+		case SOFT80_RC_NEAREST:	up = low > half || (low == half && (mag & 1)); break;
+		case SOFT80_RC_DOWN:	up = low != 0 && sign; break;
+		case SOFT80_RC_UP:	up = low != 0 && !sign; break;
+		default:		up = false; break;
+	}
+	if (up) {
+		mag++;
+		if (mag == 0) return false;
+	}
+	return true;
+}
+
+/* FIST: integer of the given width, or the integer indefinite (most negative value) */
+static inline int64_t Soft80_ToInt(const FPU_Soft80 &a,unsigned int bits,unsigned int rc) {
+	const uint64_t limit = (uint64_t)1 << (bits - 1);
+	unsigned int sign;
+	uint64_t mag;
+
+	if (!Soft80_RoundToInt(a,rc,sign,mag) || mag > limit || (mag == limit && !sign))
+		return (int64_t)((uint64_t)0 - limit);
+	return sign ? (int64_t)((uint64_t)0 - mag) : (int64_t)mag;
+}
+
+static FPU_Soft80 Soft80_RoundInt(const FPU_Soft80 &a,unsigned int rc) {
+	unsigned int sign;
+	uint64_t mag, m;
+	int32_t exp;
+
+	if (Soft80_IsNaN(a)) return Soft80_PropagateNaN(a,a);
+	if (!Soft80_RoundToInt(a,rc,sign,mag)) {
+		if (Soft80_Unpack(a,sign,exp,m) == SOFT80_INVALID) return Soft80_Indefinite();
+		return a;	/* infinity, or already an integer */
+	}
+	return Soft80_FromU64(sign,mag);
+}
+
+/* FPREM (round_nearest false) and FPREM1. Returns the remainder, the low three bits of the
+ * quotient in q and sets complete to false if only a partial remainder was computed (C2). */
+static FPU_Soft80 Soft80_Remainder(const FPU_Soft80 &a,const FPU_Soft80 &b,bool round_nearest,unsigned int &q,bool &complete) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+
+	q = 0;
+	complete = true;
+	if (ca == SOFT80_INVALID || cb == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN) return Soft80_PropagateNaN(a,b);
+	if (ca == SOFT80_INF || cb == SOFT80_ZERO) return Soft80_Indefinite();
+	if (ca == SOFT80_ZERO || cb == SOFT80_INF) return a;
+
+	int32_t d = ea - eb;
+	if (d >= 64) {
+		/* reduce by a multiple of b * 2^(d - n) with n in 32..63 picked like the x87 does,
+		 * the guest loops until C2 is clear */
+		complete = false;
+		d = (d & 31) | 32;
+		eb = ea - d;
+	}
+
+	if (d < 0) {
+		/* |a| < |b|, FPREM1 subtracts b if |a| is above half of it */
+		if (round_nearest && d == -1 && ma > mb) {
+			q = 1;
+			return Soft80_RoundPack(sa ^ 1,ea,mb - (ma - mb),0,64,SOFT80_RC_NEAREST);
+		}
+		return a;
+	}
+
+	uint64_t r = ma, quot = 0;
+	bool carry = false;
+	for (int32_t i = d;i >= 0;i--) {
+		quot <<= 1;
+		if (carry || r >= mb) {
+			r -= mb;
+			quot |= 1;
+		}
+		if (i) {
+			carry = (r >> 63) != 0;
+			r <<= 1;
+		}
+	}
+
+	unsigned int sign = sa;
+	if (round_nearest && complete && r != 0) {
+		/* compare the remainder against half of b */
+		if ((r >> 63) || (r << 1) > mb || ((r << 1) == mb && (quot & 1))) {
+			r = mb - r;
+			quot++;
+			sign ^= 1;
+		}
+	}
+	/* a partial remainder leaves C0, C1 and C3 clear */
+	q = complete ? (unsigned int)(quot & 7) : 0;
+	if (r == 0) return Soft80_Zero(sa);
+	return Soft80_RoundPack(sign,eb,r,0,64,SOFT80_RC_NEAREST);
+}
+
+/* FSCALE: a * 2^trunc(b) */
+static FPU_Soft80 Soft80_Scale(const FPU_Soft80 &a,const FPU_Soft80 &b,unsigned int rc) {
+	unsigned int sa, sb;
+	int32_t ea, eb;
+	uint64_t ma, mb;
+	const unsigned int ca = Soft80_Unpack(a,sa,ea,ma);
+	const unsigned int cb = Soft80_Unpack(b,sb,eb,mb);
+
+	if (ca == SOFT80_INVALID || cb == SOFT80_INVALID) return Soft80_Indefinite();
+	if (ca == SOFT80_NAN || cb == SOFT80_NAN) return Soft80_PropagateNaN(a,b);
+	if (cb == SOFT80_INF) {
+		if (!sb) return (ca == SOFT80_ZERO) ? Soft80_Indefinite() : Soft80_Inf(sa);
+		return (ca == SOFT80_INF) ? Soft80_Indefinite() : Soft80_Zero(sa);
+	}
+	if (ca != SOFT80_FINITE) return a;
+
+	unsigned int nsign;
+	uint64_t nmag;
+	int32_t n;
+	if (!Soft80_RoundToInt(b,SOFT80_RC_CHOP,nsign,nmag) || nmag > 100000) n = 100000;
+	else n = (int32_t)nmag;
+	if (nsign) n = -n;
+	return Soft80_RoundPack(sa,ea + n,ma,0,64,rc);
+}
+
+/* x87 register constants (FLDPI etc.) rounded to nearest */
+#define SOFT80_PI	Soft80_Make(0,0x4000,0xC90FDAA22168C235ull)
+#define SOFT80_L2T	Soft80_Make(0,0x4000,0xD49A784BCD1B8AFEull)
+#define SOFT80_L2E	Soft80_Make(0,0x3FFF,0xB8AA3B295C17F0BCull)
+#define SOFT80_LG2	Soft80_Make(0,0x3FFD,0x9A209A84FBCFF799ull)
+#define SOFT80_LN2	Soft80_Make(0,0x3FFE,0xB17217F7D1CF79ACull)
+#define SOFT80_ONE	Soft80_Make(0,SOFT80_BIAS,SOFT80_INT_BIT)
+
+#endif
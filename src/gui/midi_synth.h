@@ -23,7 +23,11 @@
 #endif
 #include <math.h>
 #include <string.h>
+#include <deque>
+#include <vector>
+#include <SDL_thread.h>
 #include "control.h"
+#include "pic.h"
 
 /* Protect against multiple inclusions */
 #ifndef MIXER_BUFSIZE
@@ -58,8 +62,213 @@ static void synth_log(int level,
 	}
 }
 
+static void synth_PlayEvent(const uint8_t *msg, Bitu len) {
+	uint8_t event = msg[0], channel, p1, p2;
+
+	switch (event) {
+	case 0xf0:
+	case 0xf7:
+		LOG(LOG_MISC,LOG_DEBUG)("SYNTH: sysex 0x%02x len %lu", (int)event, (long unsigned)len);
+		fluid_synth_sysex(synth_soft, (const char *)(msg + 1), (int)(len - 1), NULL, NULL, NULL, 0);
+		return;
+	case 0xf9:
+		LOG(LOG_MISC,LOG_DEBUG)("SYNTH: midi tick");
+		return;
+	case 0xff:
+		LOG(LOG_MISC,LOG_DEBUG)("SYNTH: system reset");
+		fluid_synth_system_reset(synth_soft);
+		return;
+	case 0xf1: case 0xf2: case 0xf3: case 0xf4:
+	case 0xf5: case 0xf6: case 0xf8: case 0xfa:
+	case 0xfb: case 0xfc: case 0xfd: case 0xfe:
+		LOG(LOG_MISC,LOG_WARN)("SYNTH: unhandled event 0x%02x", (int)event);
+		return;
+	}
+
+	channel = event & 0xf;
+	p1 = len > 1 ? msg[1] : 0;
+	p2 = len > 2 ? msg[2] : 0;
+
+	LOG(LOG_MISC,LOG_DEBUG)("SYNTH: event 0x%02x channel %d, 0x%02x 0x%02x",
+		(int)event, (int)channel, (int)p1, (int)p2);
+
+	switch (event & 0xf0) {
+	case 0x80:
+		fluid_synth_noteoff(synth_soft, channel, p1);
+		break;
+	case 0x90:
+		fluid_synth_noteon(synth_soft, channel, p1, p2);
+		break;
+	case 0xb0:
+		fluid_synth_cc(synth_soft, channel, p1, p2);
+		break;
+	case 0xc0:
+		fluid_synth_program_change(synth_soft, channel, p1);
+		break;
+	case 0xd0:
+		fluid_synth_channel_pressure(synth_soft, channel, p1);
+		break;
+	case 0xe0:
+		fluid_synth_pitch_bend(synth_soft, channel, (p2 << 7) | p1);
+		break;
+	}
+}
+
+/* Render-ahead thread ("fluid.thread"). The thread keeps up to fluid.prebuffer ms
+ * of audio rendered ahead of the mixer in a ring buffer. MIDI events are not sent
+ * to the synth directly, they are queued with the output frame they are due at
+ * (the play position at the time of the event plus the prebuffer length) and the
+ * thread splits its rendering at those frames. The timing between events and
+ * samples is kept, the output is only delayed by the prebuffer.
+ * Frame counters and the event queue are protected by the lock, the ring buffer
+ * is not: the thread only writes [rendered,played+frames), the mixer only reads
+ * [played,rendered). */
+struct SynthEvent {
+	uint64_t frame;
+	std::vector<uint8_t> msg;
+};
+
+static struct {
+	bool enabled = false;
+	bool stop = false;
+	SDL_Thread *thread = NULL;
+	SDL_mutex *lock = NULL;
+	SDL_cond *changed = NULL;         // rendered or played moved, or an event was queued
+	std::vector<int16_t> buffer;      // ring of stereo frames
+	Bitu frames = 0;                  // ring size in frames, also the event delay
+	Bitu chunk = 0;                   // render at least this many frames at once
+	uint64_t rendered = 0;            // frames rendered since open
+	uint64_t played = 0;              // frames passed to the mixer since open
+	uint64_t stamp = 0;               // frame of the last queued event
+	std::deque<SynthEvent> events;    // in frame order
+} synth_thread;
+
+static int synth_ThreadProc(void *) {
+	SDL_LockMutex(synth_thread.lock);
+	while (!synth_thread.stop) {
+		/* events due at the current render position go to the synth first */
+		while (!synth_thread.events.empty() && synth_thread.events.front().frame <= synth_thread.rendered) {
+			SynthEvent ev = std::move(synth_thread.events.front());
+			synth_thread.events.pop_front();
+			SDL_UnlockMutex(synth_thread.lock);
+			synth_PlayEvent(&ev.msg[0], ev.msg.size());
+			SDL_LockMutex(synth_thread.lock);
+		}
+
+		Bitu space = synth_thread.frames - (Bitu)(synth_thread.rendered - synth_thread.played);
+		if (space < synth_thread.chunk) {
+			SDL_CondWait(synth_thread.changed, synth_thread.lock);
+			continue;
+		}
+
+		/* stop at the next event and at the end of the ring */
+		const Bitu pos = (Bitu)(synth_thread.rendered % synth_thread.frames);
+		if (space > (synth_thread.frames - pos)) space = synth_thread.frames - pos;
+		if (!synth_thread.events.empty() && (synth_thread.events.front().frame - synth_thread.rendered) < space)
+			space = (Bitu)(synth_thread.events.front().frame - synth_thread.rendered);
+
+		SDL_UnlockMutex(synth_thread.lock);
+		int16_t *dst = &synth_thread.buffer[pos * 2];
+		fluid_synth_write_s16(synth_soft, (int)space, dst, 0, 2, dst, 1, 2);
+		SDL_LockMutex(synth_thread.lock);
+
+		synth_thread.rendered += space;
+		SDL_CondSignal(synth_thread.changed);
+	}
+	SDL_UnlockMutex(synth_thread.lock);
+	return 0;
+}
+
+/* mixer side: take len frames from the ring, waiting for the thread if it fell behind */
+static void synth_ThreadPlay(Bitu len) {
+	SDL_LockMutex(synth_thread.lock);
+	while (len != 0 && !synth_thread.stop) {
+		const Bitu ready = (Bitu)(synth_thread.rendered - synth_thread.played);
+		if (ready == 0) {
+			SDL_CondWait(synth_thread.changed, synth_thread.lock);
+			continue;
+		}
+
+		const Bitu pos = (Bitu)(synth_thread.played % synth_thread.frames);
+		Bitu n = len;
+		if (n > ready) n = ready;
+		if (n > (synth_thread.frames - pos)) n = synth_thread.frames - pos;
+
+		synthchan->AddSamples_s16(n, &synth_thread.buffer[pos * 2]);
+		synth_thread.played += n;
+		len -= n;
+		SDL_CondSignal(synth_thread.changed);
+	}
+	SDL_UnlockMutex(synth_thread.lock);
+}
+
+/* emulation side: queue an event for the frame it is due at */
+static void synth_ThreadQueue(const uint8_t *msg, Bitu len) {
+	SDL_LockMutex(synth_thread.lock);
+	/* the mixer renders each millisecond at its end, so add the time into the current one */
+	uint64_t frame = synth_thread.played + synth_thread.frames +
+		(uint64_t)(PIC_TickIndex() * synthsamplerate / 1000.0);
+	if (frame < synth_thread.stamp) frame = synth_thread.stamp;
+	synth_thread.stamp = frame;
+
+	SynthEvent ev;
+	ev.frame = frame;
+	ev.msg.assign(msg, msg + len);
+	synth_thread.events.push_back(std::move(ev));
+	SDL_CondSignal(synth_thread.changed);
+	SDL_UnlockMutex(synth_thread.lock);
+}
+
+static void synth_ThreadStart(void) {
+	Section_prop *section = static_cast<Section_prop *>(control->GetSection("midi"));
+	int chunk = section->Get_int("fluid.chunk");
+	int latency = section->Get_int("fluid.prebuffer");
+	if (latency <= chunk) {
+		latency = 2 * chunk;
+		LOG_MSG("SYNTH: chunk length must be less than prebuffer length, prebuffer length reset to %i ms.", latency);
+	}
+
+	synth_thread.chunk = ((Bitu)chunk * (Bitu)synthsamplerate) / 1000u;
+	synth_thread.frames = ((Bitu)latency * (Bitu)synthsamplerate) / 1000u;
+	synth_thread.buffer.assign(synth_thread.frames * 2, 0);
+	synth_thread.rendered = synth_thread.played = synth_thread.stamp = 0;
+	synth_thread.events.clear();
+	synth_thread.stop = false;
+	synth_thread.lock = SDL_CreateMutex();
+	synth_thread.changed = SDL_CreateCond();
+#if defined(C_SDL2)
+	synth_thread.thread = SDL_CreateThread(synth_ThreadProc, "SYNTH", NULL);
+#else
+	synth_thread.thread = SDL_CreateThread(synth_ThreadProc, NULL);
+#endif
+	synth_thread.enabled = true;
+}
+
+static void synth_ThreadStop(void) {
+	if (!synth_thread.enabled) return;
+
+	SDL_LockMutex(synth_thread.lock);
+	synth_thread.stop = true;
+	SDL_CondSignal(synth_thread.changed);
+	SDL_UnlockMutex(synth_thread.lock);
+	SDL_WaitThread(synth_thread.thread, NULL);
+	synth_thread.thread = NULL;
+	SDL_DestroyCond(synth_thread.changed);
+	synth_thread.changed = NULL;
+	SDL_DestroyMutex(synth_thread.lock);
+	synth_thread.lock = NULL;
+
+	std::deque<SynthEvent>().swap(synth_thread.events);
+	std::vector<int16_t>().swap(synth_thread.buffer);
+	synth_thread.enabled = false;
+}
+
 static void synth_CallBack(Bitu len) {
 	if (synth_soft != NULL) {
+		if (synth_thread.enabled) {
+			synth_ThreadPlay(len);
+			return;
+		}
 		fluid_synth_write_s16(synth_soft, (int)len, MixTemp, 0, 2, MixTemp, 1, 2);
 		synthchan->AddSamples_s16(len,(int16_t *)MixTemp);
 	}
@@ -78,55 +287,10 @@ private:
 	bool isOpen;
 
 	void PlayEvent(uint8_t *msg, Bitu len) {
-		uint8_t event = msg[0], channel, p1, p2;
-
-		switch (event) {
-		case 0xf0:
-		case 0xf7:
-			LOG(LOG_MISC,LOG_DEBUG)("SYNTH: sysex 0x%02x len %lu", (int)event, (long unsigned)len);
-			fluid_synth_sysex(synth_soft, (char *)(msg + 1), (int)(len - 1), NULL, NULL, NULL, 0);
-			return;
-		case 0xf9:
-			LOG(LOG_MISC,LOG_DEBUG)("SYNTH: midi tick");
-			return;
-		case 0xff:
-			LOG(LOG_MISC,LOG_DEBUG)("SYNTH: system reset");
-			fluid_synth_system_reset(synth_soft);
-			return;
-		case 0xf1: case 0xf2: case 0xf3: case 0xf4:
-		case 0xf5: case 0xf6: case 0xf8: case 0xfa:
-		case 0xfb: case 0xfc: case 0xfd: case 0xfe:
-			LOG(LOG_MISC,LOG_WARN)("SYNTH: unhandled event 0x%02x", (int)event);
-			return;
-		}
-
-		channel = event & 0xf;
-		p1 = len > 1 ? msg[1] : 0;
-		p2 = len > 2 ? msg[2] : 0;
-
-		LOG(LOG_MISC,LOG_DEBUG)("SYNTH: event 0x%02x channel %d, 0x%02x 0x%02x",
-			(int)event, (int)channel, (int)p1, (int)p2);
-
-		switch (event & 0xf0) {
-		case 0x80:
-			fluid_synth_noteoff(synth_soft, channel, p1);
-			break;
-		case 0x90:
-			fluid_synth_noteon(synth_soft, channel, p1, p2);
-			break;
-		case 0xb0:
-			fluid_synth_cc(synth_soft, channel, p1, p2);
-			break;
-		case 0xc0:
-			fluid_synth_program_change(synth_soft, channel, p1);
-			break;
-		case 0xd0:
-			fluid_synth_channel_pressure(synth_soft, channel, p1);
-			break;
-		case 0xe0:
-			fluid_synth_pitch_bend(synth_soft, channel, (p2 << 7) | p1);
-			break;
-		}
+		if (synth_thread.enabled)
+			synth_ThreadQueue(msg, len);
+		else
+			synth_PlayEvent(msg, len);
 	};
 
 public:
@@ -194,6 +358,10 @@ public:
 		fluid_settings_setstr(settings, "audio.sample-format", "16bits");
 		fluid_settings_setnum(settings, "synth.sample-rate", (double)synthsamplerate);
 		//fluid_settings_setnum(settings, "synth.gain", 0.5);
+		/* only known to the bundled library, other builds ignore them */
+		Section_prop *section = static_cast<Section_prop *>(control->GetSection("midi"));
+		fluid_settings_setint(settings, "synth.sample-mmap", section->Get_bool("fluid.sample.mmap") ? 1 : 0);
+		fluid_settings_setint(settings, "synth.sample-pin-ms", section->Get_int("fluid.sample.pin"));
 
 		/* Create the synthesizer. */
 		synth_soft = new_fluid_synth(settings);
@@ -221,6 +389,10 @@ public:
 
 		synthchan = MIXER_AddChannel(synth_CallBack, (unsigned int)synthsamplerate, "SYNTH");
 		synthchan->Enable(false);
+		if (static_cast<Section_prop *>(control->GetSection("midi"))->Get_bool("fluid.thread")) {
+			LOG_MSG("SYNTH: Rendering in a separate thread");
+			synth_ThreadStart();
+		}
 		isOpen = true;
 		return true;
 	};
@@ -229,6 +401,7 @@ public:
 		if (!isOpen) return;
 
 		synthchan->Enable(false);
+		synth_ThreadStop();
 		MIXER_DelChannel(synthchan);
 		delete_fluid_synth(synth_soft);
 		delete_fluid_settings(settings);
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #include "dosbox.h"
 #include "video.h"
@@ -34,6 +35,8 @@
 #include "support.h"
 #include "sdlmain.h"
 #include "shell.h"
+#include "frametime.h"
+#include "timer.h"
 
 #include "render_scalers.h"
 #include "render_glsl.h"
@@ -47,6 +50,18 @@ int                                     eurAscii = -1;
 Bitu                                    last_gfx_flags = 0;
 ScalerLineHandler_t                     RENDER_DrawLine;
 
+/* The scaler chain handlers switch themselves through this pointer. It refers to
+ * RENDER_DrawLine normally, or to the render thread's own handler while frames
+ * are scaled on the render thread (RENDER_DrawLine then only copies lines). */
+static ScalerLineHandler_t              *RENDER_ChainLine = &RENDER_DrawLine;
+
+/* A NULL line (RENDER_NULL_INPUT) means "same as in the previous frame", which
+ * only holds if every line of the previous frame made it into the scaler source
+ * cache. render_lines_lost is set when lines of the current frame are dropped,
+ * render_line_skip is decided from it as each frame starts. */
+static bool                             render_lines_lost = true;
+static bool                             render_line_skip = false;
+
 uint32_t                                GFX_palette32bpp[256] = {0};
 
 unsigned int                            GFX_GetBShift();
@@ -245,15 +260,15 @@ static void RENDER_DrawLine_countdown_wait(const void * s) {
     }
     else {
         RENDER_scaler_countdown = RENDER_scaler_countdown_init;
-        RENDER_DrawLine = RENDER_DrawLine_countdown;
-        RENDER_DrawLine( s );
+        *RENDER_ChainLine = RENDER_DrawLine_countdown;
+        (*RENDER_ChainLine)( s );
     }
 }
 
 static void RENDER_DrawLine_countdown(const void * s) {
     render.scale.lineHandler(s);
     if (--RENDER_scaler_countdown == 0)
-        RENDER_DrawLine = RENDER_DrawLine_countdown_wait;
+        *RENDER_ChainLine = RENDER_DrawLine_countdown_wait;
 }
 #endif
 
@@ -265,18 +280,20 @@ static void RENDER_StartLineHandler(const void * s) {
         render.scale.outLine++;
     }
     else {
-        if (!GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch )) {
-            RENDER_DrawLine = RENDER_EmptyLineHandler;
+        /* the render thread already started the output update on the main thread */
+        if (render.scale.outWrite == NULL && !GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch )) {
+            *RENDER_ChainLine = RENDER_EmptyLineHandler;
+            render_lines_lost = true;
             return;
         }
         render.scale.outWrite += render.scale.outPitch * Scaler_ChangedLines[0];
 #if defined(C_SCALER_FULL_LINE)
         RENDER_scaler_countdown = RENDER_scaler_countdown_init;
-        RENDER_DrawLine = RENDER_DrawLine_countdown;
+        *RENDER_ChainLine = RENDER_DrawLine_countdown;
 #else
-        RENDER_DrawLine = render.scale.lineHandler;
+        *RENDER_ChainLine = render.scale.lineHandler;
 #endif
-        RENDER_DrawLine( s );
+        (*RENDER_ChainLine)( s );
     }
 }
 
@@ -333,16 +350,9 @@ void SimpleRenderer(const void *s) {
 	render.cache.pointer += render.cache.width;
 }
 
-bool RENDER_StartUpdate(void) {
-    if (GCC_UNLIKELY(render.updating))
-        return false;
-    if (GCC_UNLIKELY(!render.active))
-        return false;
-    if (GCC_UNLIKELY(render.frameskip.count<render.frameskip.max)) {
-        render.frameskip.count++;
-        return false;
-    }
-    render.frameskip.count=0;
+/* Set up the scaler chain for a new frame. Called on the main thread, with the
+ * render thread (if any) idle. */
+static bool RENDER_BeginFrame(void) {
     if (render.scale.inMode == scalerMode8 && sdl.desktop.want_type != SCREEN_TTF) {
         Check_Palette();
     }
@@ -360,9 +370,9 @@ bool RENDER_StartUpdate(void) {
             render.cache.invalid = true;
             if (!GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch ))
                 return false;
-            RENDER_DrawLine = SimpleRenderer;
+            *RENDER_ChainLine = SimpleRenderer;
         } else
-            RENDER_DrawLine = RENDER_StartLineHandler;
+            *RENDER_ChainLine = RENDER_StartLineHandler;
     /* Clearing the cache will first process the line to make sure it's never the same */
     } else
 #endif
@@ -372,46 +382,30 @@ bool RENDER_StartUpdate(void) {
         if (GCC_UNLIKELY(!GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch )))
             return false;
         render.fullFrame = true;
-        RENDER_DrawLine = RENDER_ClearCacheHandler;
+        *RENDER_ChainLine = RENDER_ClearCacheHandler;
     } else {
         if (render.pal.changed) {
             /* Assume pal changes always do a full screen update anyway */
             if (GCC_UNLIKELY(!GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch )))
                 return false;
-            RENDER_DrawLine = render.scale.linePalHandler;
+            *RENDER_ChainLine = render.scale.linePalHandler;
             render.fullFrame = true;
         } else {
-            RENDER_DrawLine = RENDER_StartLineHandler;
+            *RENDER_ChainLine = RENDER_StartLineHandler;
             if (GCC_UNLIKELY(CaptureState & (CAPTURE_IMAGE|CAPTURE_VIDEO))) 
                 render.fullFrame = true;
             else
                 render.fullFrame = false;
         }
     }
-    render.updating = true;
     return true;
 }
 
-static void RENDER_Halt( void ) {
-    RENDER_DrawLine = RENDER_EmptyLineHandler;
-    GFX_EndUpdate( 0 );
-    render.updating=false;
-    render.active=false;
-}
-
-extern Bitu PIC_Ticks;
-extern bool pause_on_vsync;
-void PauseDOSBox(bool pressed);
-void AspectRatio_mapper_shortcut(bool pressed);
-
-void RENDER_EndUpdate( bool abort ) {
-    if (GCC_UNLIKELY(!render.updating))
-        return;
-
-    if (!abort && render.active && RENDER_DrawLine == RENDER_ClearCacheHandler)
+/* Hand the capture and the output the frame the scaler chain just finished. */
+static void RENDER_FinishFrame(bool clearedCache, bool abort) {
+    if (!abort && render.active && clearedCache)
         render.scale.clearCache = false;
 
-    RENDER_DrawLine = RENDER_EmptyLineHandler;
     if (GCC_UNLIKELY(CaptureState & (CAPTURE_IMAGE|CAPTURE_VIDEO))) {
         Bitu pitch, flags;
         flags = 0;
@@ -446,10 +440,261 @@ void RENDER_EndUpdate( bool abort ) {
         if (RENDER_GetForceUpdate()) GFX_EndUpdate( 0 );
     }
     render.frameskip.index = (render.frameskip.index + 1) & (RENDER_SKIP_CACHE - 1);
+}
+
+/* Render thread ("render thread" option).
+ *
+ * The emulation thread only copies the raw lines from the VGA line handlers into
+ * one of two frame buffers. At the end of the frame the buffer is handed to the
+ * render thread, which runs the usual scaler chain (cache compare, palette lookup,
+ * scaling) into the output buffer while the emulation thread goes on filling the
+ * other buffer with the next frame. The output update is started and ended on the
+ * main thread, since the SDL/OpenGL/Direct3D contexts belong to it: a tick handler
+ * presents the frame within a millisecond of the render thread finishing it, and
+ * it is presented at once whenever the renderer state changes (next frame handed
+ * over, mode change, halt, save state, pause on vsync). */
+struct RenderThreadFrame {
+    std::vector<uint8_t>        data;
+    std::vector<const void*>    line;
+    Bitu                        pitch = 0;
+    Bitu                        lines = 0;
+};
+
+static struct {
+    bool                        enabled = false;
+    bool                        collecting = false;     // emulation thread is copying lines into frame[fill]
+    bool                        pending = false;        // frame handed to the render thread, not presented yet
+    bool                        busy = false;           // render thread is scaling frame[work] (under lock)
+    bool                        quit = false;
+    SDL_Thread*                 thread = NULL;
+    SDL_mutex*                  lock = NULL;
+    SDL_cond*                   workReady = NULL;
+    SDL_cond*                   workDone = NULL;
+    ScalerLineHandler_t         drawLine = NULL;        // scaler chain of the render thread
+    RenderThreadFrame           frame[2];
+    unsigned int                fill = 0;
+    unsigned int                work = 0;
+} render_thread;
+
+static void RENDER_ThreadCopyLineHandler(const void * s) {
+    RenderThreadFrame &f = render_thread.frame[render_thread.fill];
+    if (GCC_UNLIKELY(f.lines >= f.line.size())) {
+        render_lines_lost = true;
+        return;
+    }
+    if (s) {
+        uint8_t *d = &f.data[f.lines * f.pitch];
+        memcpy(d, s, f.pitch);
+        f.line[f.lines] = d;
+    } else {
+        f.line[f.lines] = NULL;
+    }
+    f.lines++;
+}
+
+static int RENDER_ThreadProc(void *) {
+    SDL_LockMutex(render_thread.lock);
+    for (;;) {
+        while (!render_thread.busy && !render_thread.quit)
+            SDL_CondWait(render_thread.workReady, render_thread.lock);
+        if (render_thread.quit)
+            break;
+        SDL_UnlockMutex(render_thread.lock);
+
+        const RenderThreadFrame &f = render_thread.frame[render_thread.work];
+        for (Bitu i=0;i < f.lines;i++)
+            render_thread.drawLine(f.line[i]);
+
+        SDL_LockMutex(render_thread.lock);
+        render_thread.busy = false;
+        SDL_CondSignal(render_thread.workDone);
+    }
+    SDL_UnlockMutex(render_thread.lock);
+    return 0;
+}
+
+static void RENDER_ThreadWait(void) {
+    SDL_LockMutex(render_thread.lock);
+    while (render_thread.busy)
+        SDL_CondWait(render_thread.workDone, render_thread.lock);
+    SDL_UnlockMutex(render_thread.lock);
+}
+
+/* Wait for the render thread and present the frame it scaled, if any. Must be
+ * called before anything the render thread uses (render.scale, render.pal.lut,
+ * the scaler caches, the output buffer) is changed on the main thread. */
+static void RENDER_ThreadSync(void) {
+    if (!render_thread.pending)
+        return;
+    RENDER_ThreadWait();
+    render_thread.pending = false;
+    RENDER_FinishFrame(render_thread.drawLine == RENDER_ClearCacheHandler, false);
+}
+
+/* PIC tick handler: present the frame as soon as the render thread is done with it */
+static void RENDER_ThreadPresent(void) {
+    if (!render_thread.pending)
+        return;
+    SDL_LockMutex(render_thread.lock);
+    const bool busy = render_thread.busy;
+    SDL_UnlockMutex(render_thread.lock);
+    if (!busy)
+        RENDER_ThreadSync();
+}
+
+static void RENDER_ThreadSubmit(void) {
+    RENDER_ThreadSync();
+
+    if (render_thread.thread == NULL) {
+        render_thread.quit = false;
+        render_thread.lock = SDL_CreateMutex();
+        render_thread.workReady = SDL_CreateCond();
+        render_thread.workDone = SDL_CreateCond();
+#if defined(C_SDL2)
+        render_thread.thread = SDL_CreateThread(RENDER_ThreadProc, "Render", NULL);
+#else
+        render_thread.thread = SDL_CreateThread(RENDER_ThreadProc, NULL);
+#endif
+        if (render_thread.thread == NULL) {
+            LOG_MSG("RENDER: Unable to create render thread, scaling on the emulation thread");
+            render_thread.enabled = false;
+            return;
+        }
+        TIMER_AddTickHandler(RENDER_ThreadPresent);
+    }
+
+    RENDER_ChainLine = &render_thread.drawLine;
+    if (!RENDER_BeginFrame()) {
+        render_lines_lost = true;
+        return;
+    }
+    /* start the output update now, the render thread must not call into the output */
+    if (render.scale.outWrite == NULL && !GFX_StartUpdate( render.scale.outWrite, render.scale.outPitch )) {
+        render_lines_lost = true;
+        return;
+    }
+
+    render_thread.work = render_thread.fill;
+    render_thread.fill ^= 1;
+    render_thread.pending = true;
+
+    SDL_LockMutex(render_thread.lock);
+    render_thread.busy = true;
+    SDL_CondSignal(render_thread.workReady);
+    SDL_UnlockMutex(render_thread.lock);
+}
+
+static void RENDER_ThreadShutDown(Section* /*sec*/) {
+    if (render_thread.thread == NULL)
+        return;
+    TIMER_DelTickHandler(RENDER_ThreadPresent);
+    /* don't present: the output may be gone already */
+    RENDER_ThreadWait();
+    render_thread.pending = false;
+    SDL_LockMutex(render_thread.lock);
+    render_thread.quit = true;
+    SDL_CondSignal(render_thread.workReady);
+    SDL_UnlockMutex(render_thread.lock);
+    SDL_WaitThread(render_thread.thread, NULL);
+    render_thread.thread = NULL;
+    SDL_DestroyCond(render_thread.workDone);
+    render_thread.workDone = NULL;
+    SDL_DestroyCond(render_thread.workReady);
+    render_thread.workReady = NULL;
+    SDL_DestroyMutex(render_thread.lock);
+    render_thread.lock = NULL;
+    for (unsigned int i=0;i < 2;i++) {
+        std::vector<uint8_t>().swap(render_thread.frame[i].data);
+        std::vector<const void*>().swap(render_thread.frame[i].line);
+    }
+}
+
+bool RENDER_StartUpdate(void) {
+    if (GCC_UNLIKELY(render.updating))
+        return false;
+    if (GCC_UNLIKELY(!render.active))
+        return false;
+    if (GCC_UNLIKELY(render.frameskip.count<render.frameskip.max)) {
+        render.frameskip.count++;
+        return false;
+    }
+    render.frameskip.count=0;
+    /* output=none: only draw the frames a screenshot or video capture asks for */
+    if (GCC_UNLIKELY(sdl.desktop.headless) && !(CaptureState & (CAPTURE_IMAGE|CAPTURE_VIDEO)))
+        return false;
+    render_line_skip = !render_lines_lost && !render.scale.clearCache && render.scale.inMode != scalerMode8;
+#if defined(USE_TTF)
+    if (ttf.inUse) render_line_skip = false;
+#endif
+    render_lines_lost = false;
+    if (render_thread.enabled && sdl.desktop.want_type != SCREEN_TTF) {
+        /* only collect the raw lines, the scaler chain runs at RENDER_EndUpdate() */
+        RenderThreadFrame &f = render_thread.frame[render_thread.fill];
+        f.pitch = render.scale.cachePitch;
+        f.lines = 0;
+        if (f.data.size() < f.pitch * render.src.height)
+            f.data.resize(f.pitch * render.src.height);
+        f.line.resize(render.src.height);
+        RENDER_DrawLine = RENDER_ThreadCopyLineHandler;
+        render_thread.collecting = true;
+        render.updating = true;
+        return true;
+    }
+    RENDER_ThreadSync();
+    RENDER_ChainLine = &RENDER_DrawLine;
+    if (!RENDER_BeginFrame()) {
+        render_lines_lost = true;
+        return false;
+    }
+    render.updating = true;
+    return true;
+}
+
+/* true if the frame being drawn may pass lines that did not change since the
+ * previous frame as NULL, see render_lines_lost */
+bool RENDER_LineSkipAllowed(void) {
+    return render.updating && render_line_skip;
+}
+
+static void RENDER_Halt( void ) {
+    render_lines_lost = true;
+    RENDER_ThreadSync();
+    render_thread.collecting = false;
+    RENDER_DrawLine = RENDER_EmptyLineHandler;
+    GFX_EndUpdate( 0 );
+    render.updating=false;
+    render.active=false;
+}
+
+extern Bitu PIC_Ticks;
+extern bool pause_on_vsync;
+void PauseDOSBox(bool pressed);
+void AspectRatio_mapper_shortcut(bool pressed);
+
+void RENDER_EndUpdate( bool abort ) {
+    if (GCC_UNLIKELY(!render.updating))
+        return;
+
+    FrameTimeScope timing(FRAMETIME_SCALER);
+
+    if (abort || !render.active)
+        render_lines_lost = true;
+
+    if (render_thread.collecting) {
+        RENDER_DrawLine = RENDER_EmptyLineHandler;
+        render_thread.collecting = false;
+        if (!abort && render.active)
+            RENDER_ThreadSubmit();
+    } else {
+        bool clearedCache = (RENDER_DrawLine == RENDER_ClearCacheHandler);
+        RENDER_DrawLine = RENDER_EmptyLineHandler;
+        RENDER_FinishFrame(clearedCache, abort);
+    }
     render.updating=false;
 
     if (pause_on_vsync) {
         pause_on_vsync = false;
+        RENDER_ThreadSync();
         PauseDOSBox(true);
     }
 }
@@ -477,6 +722,9 @@ static Bitu MakeAspectTable(Bitu skip,Bitu height,double scaley,Bitu miny) {
 }
 
 void RENDER_Reset( void ) {
+    RENDER_ThreadSync();
+    render_lines_lost = true;
+
     Bitu width=render.src.width;
     Bitu height=render.src.height;
     bool dblw=render.src.dblw;
@@ -828,7 +1076,13 @@ forcenormal:
     render.pal.changed = false;
     memset(render.pal.modified, 0, sizeof(render.pal.modified));
     //Finish this frame using a copy only handler
-    RENDER_DrawLine = RENDER_FinishLineHandler;
+    if (render_thread.collecting) {
+        /* lines collected for the render thread are in the old format, drop them */
+        render_thread.collecting = false;
+        RENDER_DrawLine = RENDER_EmptyLineHandler;
+    } else {
+        RENDER_DrawLine = RENDER_FinishLineHandler;
+    }
     render.scale.outWrite = 0;
     /* Signal the next frame to first reinit the cache */
     render.scale.clearCache = true;
@@ -844,6 +1098,7 @@ forcenormal:
 }
 
 void RENDER_CallBack( GFX_CallBackFunctions_t function ) {
+    RENDER_ThreadSync();
     if (function == GFX_CallBackStop) {
         RENDER_Halt( ); 
         return;
@@ -1047,6 +1302,8 @@ void RENDER_OnSectionPropChange(Section *x) {
     vga.draw.doublescan_set=section->Get_bool("doublescan");
     vga.draw.char9_set=section->Get_bool("char9");
 
+    FRAMETIME_Configure(section->Get_bool("frame timing"), section->Get_string("frame timing csv"));
+
     if (render.aspect != p_aspect || vga.draw.doublescan_set != p_doublescan || vga.draw.char9_set != p_char9)
         RENDER_CallBack(GFX_CallBackReset);
     if (vga.draw.doublescan_set != p_doublescan || vga.draw.char9_set != p_char9)
@@ -1284,10 +1541,20 @@ void RENDER_Init() {
     RENDER_UpdateFromScalerSetting();
 
     vga_alt_new_mode = control->opt_alt_vga_render || section->Get_bool("alt render");
+
+    if (!running) {
+        render_thread.enabled = section->Get_bool("render thread");
+        if (render_thread.enabled) {
+            LOG_MSG("RENDER: Scaling frames on a separate render thread");
+            AddExitFunction(AddExitFunctionFuncPair(RENDER_ThreadShutDown));
+        }
+    }
     if (vga_alt_new_mode) LOG_MSG("Alternative VGA render engine not yet fully implemented!");
 
     render.autofit=section->Get_bool("autofit");
 
+    FRAMETIME_Configure(section->Get_bool("frame timing"), section->Get_string("frame timing csv"));
+
 #if C_OPENGL
     std::string ssrc=LoadGLShader(section);
 #endif
@@ -1322,6 +1589,7 @@ public:
 private:
 	virtual void getBytes(std::ostream& stream)
 	{
+		RENDER_ThreadSync();
 		SerializeGlobalPOD::getBytes(stream);
 
 
@@ -1338,6 +1606,8 @@ private:
 
 	virtual void setBytes(std::istream& stream)
 	{
+		RENDER_ThreadSync();
+		render_thread.collecting = false;
 		SerializeGlobalPOD::setBytes(stream);
 
 
@@ -23,6 +23,7 @@
 
 #include "dosbox.h"
 #include "render.h"
+#include "render_simd.h"
 #include <string.h>
 
 uint8_t Scaler_Aspect[SCALER_MAXHEIGHT];
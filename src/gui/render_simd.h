@@ -0,0 +1,322 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* SIMD kernels for the simple scalers (render_simple.h), 32bpp output only.
+ *
+ * A changed block of source pixels is first converted to 32bpp (palette
+ * lookup for 8bpp sources, nothing to do for 32bpp sources), then each
+ * output line of the scaler is written by Scaler_SIMD_Row(), which applies
+ * an optional per-pixel operation (TV darkening, scanline blanking) and
+ * replicates every pixel 1-3 times horizontally, masking each copy with its
+ * own channel mask (RGB scalers). The scalers describe their lines with the
+ * SCALERSIMD macro next to SCALERFUNC in render_templates.h.
+ *
+ * x86 builds choose AVX2 or SSE2 at runtime, ARM builds use NEON. */
+
+#ifndef DOSBOX_RENDER_SIMD_H
+#define DOSBOX_RENDER_SIMD_H
+
+#if defined(__SSE__) && !(defined(_M_AMD64) || defined(__e2k__))
+/* sse2_available/avx2_available are set up by CheckX86ExtensionsSupport() */
+# define RENDER_USE_SIMD_SCALERS 1
+# define RENDER_SIMD_X86 1
+# include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+# define RENDER_USE_SIMD_SCALERS 1
+# define RENDER_SIMD_NEON 1
+# include <arm_neon.h>
+#endif
+
+#if defined(RENDER_USE_SIMD_SCALERS)
+
+/* per-pixel operation applied before replication */
+enum {
+	SCALER_SIMD_COPY = 0,
+	SCALER_SIMD_HALF,		/* each channel * 1/2 (TV2x) */
+	SCALER_SIMD_TV58,		/* each channel * 5/8 (TV3x) */
+	SCALER_SIMD_TV516,		/* each channel * 5/16 (TV3x) */
+	SCALER_SIMD_ZERO		/* black (scanlines) */
+};
+
+/* pixels converted to 32bpp at once, also the largest block render_simple.h uses */
+#define SCALER_SIMD_CHUNK	128
+/* below this the per-pixel loop is cheaper */
+#define SCALER_SIMD_MIN		8
+
+static const uint32_t Scaler_SIMD_NoMask[3] = { 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu };
+
+static inline uint32_t Scaler_SIMD_OpPixel(uint32_t p, unsigned int op, uint32_t rb, uint32_t g) {
+	switch (op) {
+		case SCALER_SIMD_HALF:	return (((p & rb) >> 1u) & rb) | (((p & g) >> 1u) & g);
+		case SCALER_SIMD_TV58:	return ((((p & rb) * 5u) >> 3u) & rb) | ((((p & g) * 5u) >> 3u) & g);
+		case SCALER_SIMD_TV516:	return ((((p & rb) * 5u) >> 4u) & rb) | ((((p & g) * 5u) >> 4u) & g);
+		case SCALER_SIMD_ZERO:	return 0;
+		default:				return p;
+	}
+}
+
+static inline void Scaler_SIMD_RowTail(uint32_t *dst, const uint32_t *px, unsigned int n, unsigned int width, unsigned int op, const uint32_t *mask, uint32_t rb, uint32_t g) {
+	for (unsigned int i=0;i < n;i++) {
+		const uint32_t p = Scaler_SIMD_OpPixel(px[i], op, rb, g);
+		for (unsigned int w=0;w < width;w++)
+			*dst++ = p & mask[w];
+	}
+}
+
+#if defined(RENDER_SIMD_X86)
+
+#ifdef __GNUC__
+__attribute__((__target__("sse2")))
+#endif
+static inline __m128i Scaler_SIMD_Op_SSE2(__m128i v, unsigned int op, __m128i rb, __m128i g) {
+	__m128i a, b;
+	switch (op) {
+		case SCALER_SIMD_HALF:
+			a = _mm_and_si128(_mm_srli_epi32(_mm_and_si128(v, rb), 1), rb);
+			b = _mm_and_si128(_mm_srli_epi32(_mm_and_si128(v, g), 1), g);
+			return _mm_or_si128(a, b);
+		case SCALER_SIMD_TV58:
+		case SCALER_SIMD_TV516:
+			a = _mm_and_si128(v, rb);
+			a = _mm_add_epi32(_mm_slli_epi32(a, 2), a);
+			b = _mm_and_si128(v, g);
+			b = _mm_add_epi32(_mm_slli_epi32(b, 2), b);
+			if (op == SCALER_SIMD_TV58) {
+				a = _mm_srli_epi32(a, 3);
+				b = _mm_srli_epi32(b, 3);
+			} else {
+				a = _mm_srli_epi32(a, 4);
+				b = _mm_srli_epi32(b, 4);
+			}
+			return _mm_or_si128(_mm_and_si128(a, rb), _mm_and_si128(b, g));
+		case SCALER_SIMD_ZERO:
+			return _mm_setzero_si128();
+		default:
+			return v;
+	}
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("sse2")))
+#endif
+static void Scaler_SIMD_Row_SSE2(uint32_t *dst, const uint32_t *px, unsigned int n, unsigned int width, unsigned int op, const uint32_t *mask, uint32_t rb_, uint32_t g_) {
+	const __m128i rb = _mm_set1_epi32((int)rb_);
+	const __m128i g = _mm_set1_epi32((int)g_);
+	/* mask of output pixel k is mask[k % width] */
+	uint32_t mv[3][4];
+	for (unsigned int j=0;j < 3;j++)
+		for (unsigned int l=0;l < 4;l++)
+			mv[j][l] = mask[(j*4u+l) % width];
+	const __m128i m0 = _mm_loadu_si128((const __m128i*)mv[0]);
+	const __m128i m1 = _mm_loadu_si128((const __m128i*)mv[1]);
+	const __m128i m2 = _mm_loadu_si128((const __m128i*)mv[2]);
+
+	unsigned int i = 0;
+	for (;(i+4u) <= n;i += 4u) {
+		const __m128i v = Scaler_SIMD_Op_SSE2(_mm_loadu_si128((const __m128i*)(px+i)), op, rb, g);
+		if (width == 1) {
+			_mm_storeu_si128((__m128i*)dst, _mm_and_si128(v, m0));
+		} else if (width == 2) {
+			_mm_storeu_si128((__m128i*)dst,     _mm_and_si128(_mm_unpacklo_epi32(v, v), m0));
+			_mm_storeu_si128((__m128i*)(dst+4), _mm_and_si128(_mm_unpackhi_epi32(v, v), m1));
+		} else {
+			_mm_storeu_si128((__m128i*)dst,     _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,0,0)), m0));
+			_mm_storeu_si128((__m128i*)(dst+4), _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,1,1)), m1));
+			_mm_storeu_si128((__m128i*)(dst+8), _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,2)), m2));
+		}
+		dst += 4u * width;
+	}
+	Scaler_SIMD_RowTail(dst, px+i, n-i, width, op, mask, rb_, g_);
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static inline __m256i Scaler_SIMD_Op_AVX2(__m256i v, unsigned int op, __m256i rb, __m256i g) {
+	__m256i a, b;
+	switch (op) {
+		case SCALER_SIMD_HALF:
+			a = _mm256_and_si256(_mm256_srli_epi32(_mm256_and_si256(v, rb), 1), rb);
+			b = _mm256_and_si256(_mm256_srli_epi32(_mm256_and_si256(v, g), 1), g);
+			return _mm256_or_si256(a, b);
+		case SCALER_SIMD_TV58:
+		case SCALER_SIMD_TV516:
+			a = _mm256_and_si256(v, rb);
+			a = _mm256_add_epi32(_mm256_slli_epi32(a, 2), a);
+			b = _mm256_and_si256(v, g);
+			b = _mm256_add_epi32(_mm256_slli_epi32(b, 2), b);
+			if (op == SCALER_SIMD_TV58) {
+				a = _mm256_srli_epi32(a, 3);
+				b = _mm256_srli_epi32(b, 3);
+			} else {
+				a = _mm256_srli_epi32(a, 4);
+				b = _mm256_srli_epi32(b, 4);
+			}
+			return _mm256_or_si256(_mm256_and_si256(a, rb), _mm256_and_si256(b, g));
+		case SCALER_SIMD_ZERO:
+			return _mm256_setzero_si256();
+		default:
+			return v;
+	}
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static void Scaler_SIMD_Row_AVX2(uint32_t *dst, const uint32_t *px, unsigned int n, unsigned int width, unsigned int op, const uint32_t *mask, uint32_t rb_, uint32_t g_) {
+	const __m256i rb = _mm256_set1_epi32((int)rb_);
+	const __m256i g = _mm256_set1_epi32((int)g_);
+	uint32_t mv[3][8];
+	for (unsigned int j=0;j < 3;j++)
+		for (unsigned int l=0;l < 8;l++)
+			mv[j][l] = mask[(j*8u+l) % width];
+	const __m256i m0 = _mm256_loadu_si256((const __m256i*)mv[0]);
+	const __m256i m1 = _mm256_loadu_si256((const __m256i*)mv[1]);
+	const __m256i m2 = _mm256_loadu_si256((const __m256i*)mv[2]);
+	/* pixel index of each output lane for 3x replication */
+	const __m256i x3a = _mm256_setr_epi32(0,0,0,1,1,1,2,2);
+	const __m256i x3b = _mm256_setr_epi32(2,3,3,3,4,4,4,5);
+	const __m256i x3c = _mm256_setr_epi32(5,5,6,6,6,7,7,7);
+
+	unsigned int i = 0;
+	for (;(i+8u) <= n;i += 8u) {
+		const __m256i v = Scaler_SIMD_Op_AVX2(_mm256_loadu_si256((const __m256i*)(px+i)), op, rb, g);
+		if (width == 1) {
+			_mm256_storeu_si256((__m256i*)dst, _mm256_and_si256(v, m0));
+		} else if (width == 2) {
+			/* unpack works within 128-bit lanes, put the halves back in order */
+			const __m256i lo = _mm256_unpacklo_epi32(v, v);
+			const __m256i hi = _mm256_unpackhi_epi32(v, v);
+			_mm256_storeu_si256((__m256i*)dst,     _mm256_and_si256(_mm256_permute2x128_si256(lo, hi, 0x20), m0));
+			_mm256_storeu_si256((__m256i*)(dst+8), _mm256_and_si256(_mm256_permute2x128_si256(lo, hi, 0x31), m1));
+		} else {
+			_mm256_storeu_si256((__m256i*)dst,      _mm256_and_si256(_mm256_permutevar8x32_epi32(v, x3a), m0));
+			_mm256_storeu_si256((__m256i*)(dst+8),  _mm256_and_si256(_mm256_permutevar8x32_epi32(v, x3b), m1));
+			_mm256_storeu_si256((__m256i*)(dst+16), _mm256_and_si256(_mm256_permutevar8x32_epi32(v, x3c), m2));
+		}
+		dst += 8u * width;
+	}
+	Scaler_SIMD_RowTail(dst, px+i, n-i, width, op, mask, rb_, g_);
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static void Scaler_SIMD_Lookup_AVX2(uint32_t *dst, const uint8_t *src, unsigned int n, const uint32_t *lut) {
+	unsigned int i = 0;
+	for (;(i+8u) <= n;i += 8u) {
+		const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src+i)));
+		_mm256_storeu_si256((__m256i*)(dst+i), _mm256_i32gather_epi32((const int*)lut, idx, 4));
+	}
+	for (;i < n;i++)
+		dst[i] = lut[src[i]];
+}
+
+#elif defined(RENDER_SIMD_NEON)
+
+static inline uint32x4_t Scaler_SIMD_Op_NEON(uint32x4_t v, unsigned int op, uint32x4_t rb, uint32x4_t g) {
+	uint32x4_t a, b;
+	switch (op) {
+		case SCALER_SIMD_HALF:
+			a = vandq_u32(vshrq_n_u32(vandq_u32(v, rb), 1), rb);
+			b = vandq_u32(vshrq_n_u32(vandq_u32(v, g), 1), g);
+			return vorrq_u32(a, b);
+		case SCALER_SIMD_TV58:
+		case SCALER_SIMD_TV516:
+			a = vandq_u32(v, rb);
+			a = vaddq_u32(vshlq_n_u32(a, 2), a);
+			b = vandq_u32(v, g);
+			b = vaddq_u32(vshlq_n_u32(b, 2), b);
+			if (op == SCALER_SIMD_TV58) {
+				a = vshrq_n_u32(a, 3);
+				b = vshrq_n_u32(b, 3);
+			} else {
+				a = vshrq_n_u32(a, 4);
+				b = vshrq_n_u32(b, 4);
+			}
+			return vorrq_u32(vandq_u32(a, rb), vandq_u32(b, g));
+		case SCALER_SIMD_ZERO:
+			return vdupq_n_u32(0);
+		default:
+			return v;
+	}
+}
+
+static inline void Scaler_SIMD_Row_NEON(uint32_t *dst, const uint32_t *px, unsigned int n, unsigned int width, unsigned int op, const uint32_t *mask, uint32_t rb_, uint32_t g_) {
+	const uint32x4_t rb = vdupq_n_u32(rb_);
+	const uint32x4_t g = vdupq_n_u32(g_);
+	/* the interleaving stores replicate the pixels, so each copy has a fixed mask */
+	const uint32x4_t m0 = vdupq_n_u32(mask[0]);
+	const uint32x4_t m1 = vdupq_n_u32(mask[width > 1 ? 1 : 0]);
+	const uint32x4_t m2 = vdupq_n_u32(mask[width > 2 ? 2 : 0]);
+
+	unsigned int i = 0;
+	for (;(i+4u) <= n;i += 4u) {
+		const uint32x4_t v = Scaler_SIMD_Op_NEON(vld1q_u32(px+i), op, rb, g);
+		if (width == 1) {
+			vst1q_u32(dst, vandq_u32(v, m0));
+		} else if (width == 2) {
+			uint32x4x2_t o;
+			o.val[0] = vandq_u32(v, m0);
+			o.val[1] = vandq_u32(v, m1);
+			vst2q_u32(dst, o);
+		} else {
+			uint32x4x3_t o;
+			o.val[0] = vandq_u32(v, m0);
+			o.val[1] = vandq_u32(v, m1);
+			o.val[2] = vandq_u32(v, m2);
+			vst3q_u32(dst, o);
+		}
+		dst += 4u * width;
+	}
+	Scaler_SIMD_RowTail(dst, px+i, n-i, width, op, mask, rb_, g_);
+}
+
+#endif
+
+/* Write one output line: n pixels from px, each replicated width (1-3) times,
+ * copy w masked with mask[w] (NULL for no masking). */
+static inline void Scaler_SIMD_Row(uint32_t *dst, const uint32_t *px, unsigned int n, unsigned int width, unsigned int op, const uint32_t *mask, uint32_t rb, uint32_t g) {
+	if (mask == NULL) mask = Scaler_SIMD_NoMask;
+#if defined(RENDER_SIMD_X86)
+	if (avx2_available)
+		Scaler_SIMD_Row_AVX2(dst, px, n, width, op, mask, rb, g);
+	else if (sse2_available)
+		Scaler_SIMD_Row_SSE2(dst, px, n, width, op, mask, rb, g);
+	else
+		Scaler_SIMD_RowTail(dst, px, n, width, op, mask, rb, g);
+#else
+	Scaler_SIMD_Row_NEON(dst, px, n, width, op, mask, rb, g);
+#endif
+}
+
+/* Convert n palettized pixels to 32bpp */
+static inline void Scaler_SIMD_Lookup(uint32_t *dst, const uint8_t *src, unsigned int n, const uint32_t *lut) {
+#if defined(RENDER_SIMD_X86)
+	if (avx2_available) {
+		Scaler_SIMD_Lookup_AVX2(dst, src, n, lut);
+		return;
+	}
+#endif
+	for (unsigned int i=0;i < n;i++)
+		dst[i] = lut[src[i]];
+}
+
+#endif //RENDER_USE_SIMD_SCALERS
+
+#endif //DOSBOX_RENDER_SIMD_H
@@ -82,6 +82,42 @@ static inline void conc4d_sub_func(const SRCTYPE* &src, SRCTYPE* &cache, PTYPE*
 #endif
 #endif //defined(SCALERLINEAR)
 			hadChange = 1;
+#if defined(SCALERSIMD) && defined(RENDER_USE_SIMD_SCALERS) && (DBPP == 32) && (SBPP == 8 || SBPP == 9 || SBPP == 32)
+			if (block_proc >= SCALER_SIMD_MIN) {
+				memcpy(cache, src, block_proc * sizeof(SRCTYPE));
+				cache += block_proc;
+				unsigned int left = block_proc;
+				do {
+					const unsigned int n = (left > SCALER_SIMD_CHUNK) ? SCALER_SIMD_CHUNK : left;
+# if (SBPP == 32)
+					const uint32_t *px = src;
+# else
+					uint32_t px[SCALER_SIMD_CHUNK];
+					Scaler_SIMD_Lookup(px, src, n, render.pal.lut.b32);
+# endif
+					SCALERSIMD(px, n);
+					src += n;
+					line0 += n*SCALERWIDTH;
+#if (SCALERHEIGHT > 1) 
+					line1 += n*SCALERWIDTH;
+#endif
+#if (SCALERHEIGHT > 2) 
+					line2 += n*SCALERWIDTH;
+#endif
+#if (SCALERHEIGHT > 3) 
+					line3 += n*SCALERWIDTH;
+#endif
+#if (SCALERHEIGHT > 4) 
+					line4 += n*SCALERWIDTH;
+#endif
+#if (SCALERHEIGHT > 5) 
+					line5 += n*SCALERWIDTH;
+#endif
+					left -= n;
+				} while (left != 0u);
+			} else
+#endif
+			{
             unsigned int i = block_proc; /* WARNING: assume block_proc != 0 */
             do {
 				const SRCTYPE S = *src++;
@@ -105,6 +141,7 @@ static inline void conc4d_sub_func(const SRCTYPE* &src, SRCTYPE* &cache, PTYPE*
 				line5 += SCALERWIDTH;
 #endif
 			} while (--i != 0u);
+			}
 #if defined(SCALERLINEAR)
 #if (SCALERHEIGHT > 1)
 			Bitu copyLen = (Bitu)((uint8_t*)line1 - (uint8_t*)WC[0]);
@@ -244,11 +244,14 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 #define SCALERHEIGHT	1
 #define SCALERFUNC								\
 	line0[0] = P;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,1,SCALER_SIMD_COPY,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Normal2x
 #define SCALERWIDTH		2
@@ -258,11 +261,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line0[1] = P;								\
 	line1[0] = P;								\
 	line1[1] = P;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,2,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,2,SCALER_SIMD_COPY,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Normal3x
 #define SCALERWIDTH		3
@@ -277,11 +284,16 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line2[0] = P;								\
 	line2[1] = P;								\
 	line2[2] = P;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line2,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Normal4x
 #define SCALERWIDTH		4
@@ -396,11 +408,14 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 #define SCALERFUNC								\
 	line0[0] = P;								\
 	line0[1] = P;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,2,SCALER_SIMD_COPY,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		NormalDh
 #define SCALERWIDTH		1
@@ -408,11 +423,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 #define SCALERFUNC								\
 	line0[0] = P;								\
 	line1[0] = P;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,1,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,1,SCALER_SIMD_COPY,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Normal2xDw
 #define SCALERWIDTH		4
@@ -466,11 +485,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line1[0]=halfpixel;						\
 	line1[1]=halfpixel;						\
 }
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,2,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,2,SCALER_SIMD_HALF,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		TVDh
 #define SCALERWIDTH		1
@@ -482,11 +505,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line0[0]=P;							\
 	line1[0]=halfpixel;						\
 }
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,1,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,1,SCALER_SIMD_HALF,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		TV3x
 #define SCALERWIDTH		3
@@ -525,12 +552,17 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line2[1]=halfpixel;						\
 	line2[2]=halfpixel;						\
 }
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,3,SCALER_SIMD_TV58,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line2,_PX,_N,3,SCALER_SIMD_TV516,NULL,redblueMask,greenMask);
 #endif
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		RGB2x
 #define SCALERWIDTH		2
@@ -540,11 +572,19 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line0[1]=P & greenMask;			\
 	line1[0]=P & blueMask;				\
 	line1[1]=P;
+#define SCALERSIMD(_PX,_N)						\
+{								\
+	static const uint32_t m0[2] = { redMask, greenMask };	\
+	static const uint32_t m1[2] = { blueMask, 0xFFFFFFFFu };	\
+	Scaler_SIMD_Row(line0,_PX,_N,2,SCALER_SIMD_COPY,m0,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,2,SCALER_SIMD_COPY,m1,redblueMask,greenMask); \
+}
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		RGB3x
 #define SCALERWIDTH		3
@@ -559,11 +599,21 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line2[0]=P;				\
 	line2[1]=P & blueMask;				\
 	line2[2]=P & redMask;
+#define SCALERSIMD(_PX,_N)						\
+{								\
+	static const uint32_t m0[3] = { 0xFFFFFFFFu, greenMask, blueMask };	\
+	static const uint32_t m1[3] = { greenMask, redMask, 0xFFFFFFFFu };	\
+	static const uint32_t m2[3] = { 0xFFFFFFFFu, blueMask, redMask };	\
+	Scaler_SIMD_Row(line0,_PX,_N,3,SCALER_SIMD_COPY,m0,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,3,SCALER_SIMD_COPY,m1,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line2,_PX,_N,3,SCALER_SIMD_COPY,m2,redblueMask,greenMask); \
+}
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Scan2x
 #define SCALERWIDTH		2
@@ -573,11 +623,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line0[1]=P;							\
 	line1[0]=0;							\
 	line1[1]=0;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,2,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,2,SCALER_SIMD_ZERO,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		ScanDh
 #define SCALERWIDTH		1
@@ -585,11 +639,15 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 #define SCALERFUNC								\
 	line0[0] = P;								\
 	line1[0] = 0;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,1,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,1,SCALER_SIMD_ZERO,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 #define SCALERNAME		Scan3x
 #define SCALERWIDTH		3
@@ -604,11 +662,16 @@ static inline void conc3d(Cache,SBPP,DBPP) (const void * s) {
 	line2[0]=0;				\
 	line2[1]=0;				\
 	line2[2]=0;
+#define SCALERSIMD(_PX,_N)						\
+	Scaler_SIMD_Row(line0,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line1,_PX,_N,3,SCALER_SIMD_COPY,NULL,redblueMask,greenMask); \
+	Scaler_SIMD_Row(line2,_PX,_N,3,SCALER_SIMD_ZERO,NULL,redblueMask,greenMask);
 #include "render_simple.h"
 #undef SCALERNAME
 #undef SCALERWIDTH
 #undef SCALERHEIGHT
 #undef SCALERFUNC
+#undef SCALERSIMD
 
 /* Grayscale scalers */
 #define SCALERNAME		GrayNormal
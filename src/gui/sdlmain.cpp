@@ -99,6 +99,7 @@ void GFX_OpenGLRedrawScreen(void);
 #include "ptrop.h"
 #include "mapper.h"
 #include "sdlmain.h"
+#include "frametime.h"
 #include "zipfile.h"
 #include "shell.h"
 #include "glidedef.h"
@@ -1246,7 +1247,7 @@ void GFX_SetTitle(int32_t cycles, int frameskip, Bits timing, bool paused) {
 //  static Bits internal_frameskip=0;
     static int32_t internal_cycles=0;
 //  static Bits internal_timing=0;
-    char title[200] = {0};
+    char title[256] = {0};
 
     Section_prop *section = static_cast<Section_prop *>(control->GetSection("SDL"));
     assert(section != NULL);
@@ -1289,6 +1290,16 @@ void GFX_SetTitle(int32_t cycles, int frameskip, Bits timing, bool paused) {
         sprintf(p,", %2d%%/RT",(int)floor((rtdelta / 10) + 0.5));
     }
 
+    {
+        const char *timing = FRAMETIME_TitleText();
+
+        if (timing != NULL && *timing != 0) {
+            char *p = title + strlen(title); // append to end of string
+
+            snprintf(p,sizeof(title)-(size_t)(p-title),", %s",timing);
+        }
+    }
+
     if (paused) strcat(title," PAUSED");
 #if C_DEBUG
     if (IsDebuggerActive()) strcat(title," DEBUGGER");
@@ -3932,15 +3943,9 @@ void GFX_OpenGLRedrawScreen(void) {
             glClear(GL_COLOR_BUFFER_BIT);
         }
 
-        if (sdl_opengl.pixel_buffer_object) {
-            glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT);
-            glBindTexture(GL_TEXTURE_2D, sdl_opengl.texture);
-            glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
-            glCallList(sdl_opengl.displaylist);
-        } else {
-            glBindTexture(GL_TEXTURE_2D, sdl_opengl.texture);
-            glCallList(sdl_opengl.displaylist);
-        }
+        /* the texture is always up to date, PBOs included */
+        glBindTexture(GL_TEXTURE_2D, sdl_opengl.texture);
+        glCallList(sdl_opengl.displaylist);
     }
 #endif
 }
@@ -4223,6 +4228,8 @@ void GFX_EndTextLines(bool force=false) {
 
 extern uint8_t rendererCache[];
 void GFX_EndUpdate(const uint16_t *changedLines) {
+    FrameTimeScope timing(FRAMETIME_OUTPUT);
+
 #if C_EMSCRIPTEN
     emscripten_sleep_with_yield(0);
 #endif
@@ -4997,6 +5004,14 @@ static void GUI_StartUp() {
     /* Setup Mouse correctly if fullscreen */
     if(sdl.desktop.fullscreen) GFX_CaptureMouse();
 
+    // "none" keeps the surface output for the bookkeeping (on the dummy SDL video driver),
+    // the renderer skips every frame that is not wanted by a capture
+    if (output == "none")
+    {
+        sdl.desktop.headless = true;
+        output = "surface";
+    }
+
 #if C_XBRZ
     // initialize xBRZ parameters and check output type for compatibility
     xBRZ_Initialize();
@@ -7257,13 +7272,21 @@ void SDL_SetupConfigSection() {
 #if defined(USE_TTF)
         "ttf",
 #endif
+        "none",
         0 };
 
 	Pstring = sdl_sec->Add_string("output", Property::Changeable::Always, "default");
-    Pstring->Set_help("What video system to use for output.");
+    Pstring->Set_help("What video system to use for output.\n"
+                      "  none: Headless operation for batch runs, no window is opened and frames are not drawn, scaled or presented.\n"
+                      "        Screenshots and video capture still work. Can only be set at startup.");
     Pstring->Set_values(outputs);
     Pstring->SetBasic(true);
 
+    Pbool = sdl_sec->Add_bool("opengl_pbo",Property::Changeable::Always, false);
+    Pbool->Set_help("If set, OpenGL output streams frames through pixel buffer objects: the scaler draws straight into\n"
+                    "buffers the GPU can read and only changed lines are uploaded, without stalling. Persistent mapping\n"
+                    "with three buffers is used if the driver supports it. Takes effect when OpenGL output is (re)selected.");
+
     Pbool = sdl_sec->Add_bool("autolock",Property::Changeable::Always, false);
     Pbool->Set_help("Mouse will automatically lock, if you click on the screen. (Press CTRL-F10 to unlock)");
     Pbool->SetBasic(true);
@@ -8328,6 +8351,7 @@ bool DOSBOX_parse_argv() {
             fprintf(stderr,"                                          Make sure to surround the string in quotes to cover spaces.\n");
             fprintf(stderr,"  -time-limit <n>                         Kill the emulator after 'n' seconds\n");
             fprintf(stderr,"  -fastlaunch                             Fast launch mode (skip the BIOS logo and welcome banner)\n");
+            fprintf(stderr,"  -fastforward                            Start in turbo (fast forward) mode, not throttled to realtime\n");
 #if C_DEBUG
             fprintf(stderr,"  -helpdebug                              Show debug-related options\n");
 #endif
@@ -8391,6 +8415,9 @@ bool DOSBOX_parse_argv() {
         else if (optname == "exit") {
             control->opt_exit = true;
         }
+        else if (optname == "fastforward") {
+            control->opt_fastforward = true;
+        }
         else if (optname == "noconfig") {
             control->opt_noconfig = true;
         }
@@ -11253,6 +11280,15 @@ int main(int argc, char* argv[]) SDL_MAIN_NOEXCEPT {
         LOG(LOG_GUI,LOG_DEBUG)("SDL 1.2.14 hack: SDL_DISABLE_LOCK_KEYS=1");
 #endif
 
+        /* output=none: nothing is ever shown, so do not open a window on the host either */
+        {
+            Section_prop *section = static_cast<Section_prop *>(control->GetSection("sdl"));
+            if (section != NULL && !strcmp(section->Get_string("output"),"none") && getenv("SDL_VIDEODRIVER") == NULL) {
+                LOG(LOG_GUI,LOG_DEBUG)("output=none: setting SDL_VIDEODRIVER=dummy");
+                putenv(const_cast<char*>("SDL_VIDEODRIVER=dummy"));
+            }
+        }
+
 #ifdef WIN32
         /* hack: Encourage SDL to use windib if not otherwise specified */
         if (getenv("SDL_VIDEODRIVER") == NULL) {
@@ -12354,6 +12390,12 @@ int main(int argc, char* argv[]) SDL_MAIN_NOEXCEPT {
         Reflect_Menu();
 #endif
 
+        /* -fastforward: start in turbo mode, same as the "speedlock2" mapper event */
+        if (control->opt_fastforward) {
+            void DOSBOX_UnlockSpeed2(bool pressed);
+            DOSBOX_UnlockSpeed2(true);
+        }
+
         bool reboot_dos;
         bool run_machine;
         bool wait_debugger;
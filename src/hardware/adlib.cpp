@@ -739,6 +739,29 @@ uint8_t Chip::Read( ) {
 	return ret;
 }
 
+void Module::ChipWrite( uint32_t reg, uint8_t val ) {
+	if ( !queueWrites ) {
+		handler->WriteReg( reg, val );
+		return;
+	}
+	if ( queue.Full() ) {
+		mixerChan->FillUp();
+		//Whatever the mixer did not render (disabled channel) is applied now
+		queue.Flush( [this]( uint32_t reg, uint32_t val ) { handler->WriteReg( reg, (uint8_t)val ); } );
+	}
+	queue.Add( reg, val );
+}
+
+void Module::Generate( Bitu samples ) {
+	if ( queue.Empty() ) {
+		handler->Generate( mixerChan, samples );
+		return;
+	}
+	queue.Render( samples, sampleRate,
+		[this]( Bitu /*offset*/, Bitu count ) { handler->Generate( mixerChan, count ); },
+		[this]( uint32_t reg, uint32_t val ) { handler->WriteReg( reg, (uint8_t)val ); } );
+}
+
 void Module::CacheWrite( uint32_t reg, uint8_t val ) {
 	//capturing?
 	if ( capture ) {
@@ -767,7 +790,7 @@ void Module::DualWrite( uint8_t index, uint8_t reg, uint8_t val ) {
 		val |= index ? 0xA0 : 0x50;
 	}
 	uint32_t fullReg = reg + (index ? 0x100u : 0u);
-	handler->WriteReg( fullReg, val );
+	ChipWrite( fullReg, val );
 	CacheWrite( fullReg, val );
 }
 
@@ -823,7 +846,7 @@ void Module::PortWrite( Bitu port, Bitu val, Bitu iolen ) {
 		case MODE_OPL2:
 		case MODE_OPL3:
 			if ( !chip[0].Write( reg.normal, (uint8_t)val ) ) {
-				handler->WriteReg( reg.normal, (uint8_t)val );
+				ChipWrite( reg.normal, (uint8_t)val );
 				CacheWrite( reg.normal, (uint8_t)val );
 			}
 			break;
@@ -946,7 +969,7 @@ void Module::Init( Mode m ) {
 static Adlib::Module* module = 0;
 
 static void OPL_CallBack(Bitu len) {
-	module->handler->Generate( module->mixerChan, len );
+	module->Generate( len );
 	//Disable the sound generation after 30 seconds of silence
 	if ((PIC_Ticks - module->lastUsed) > 30000) {
 		Bitu i;
@@ -965,11 +988,9 @@ static Bitu OPL_Read(Bitu port,Bitu iolen) {
 void OPL_Write(Bitu port,Bitu val,Bitu iolen) {
     if (IS_PC98_ARCH) port >>= 8u; // C8D2h -> C8h, C9D2h -> C9h, OPL emulation looks only at bit 0.
 
-	// if writing the data port, assume a change in OPL state that should be reflected immediately.
-	// this is a way to render "sample accurate" without needing "sample accurate" mode in the mixer.
-	// CHGOLF's Adlib digital audio hack works fine with this hack.
-	if (port&1) module->mixerChan->FillUp();
-
+	// data port writes to the chip are queued with their time and applied at that sample by OPL_CallBack,
+	// which keeps the rendering sample accurate without filling up the mixer on every write.
+	// CHGOLF's Adlib digital audio hack depends on this.
 	module->PortWrite( port, val, iolen );
 }
 
@@ -1047,6 +1068,8 @@ Module::Module( Section* configuration ) : Module_base(configuration) {
     mode = MODE_OPL2;
     capture = NULL;
     handler = NULL;
+    queueWrites = false;
+    sampleRate = 0;
 
     SB_Get_Address(sb_addr,sb_irq,sb_dma);
 
@@ -1110,6 +1133,9 @@ Module::Module( Section* configuration ) : Module_base(configuration) {
 	}
 	usedoplemu = oplemu;
 	handler->Init( rate );
+	sampleRate = rate;
+	//Real hardware behind a serial port has to get the writes when they happen
+	queueWrites = ( oplemu != "opl2board" );
 	bool single = false;
 	switch ( oplmode ) {
 	case OPL_opl2:
@@ -1230,6 +1256,7 @@ void Adlib::Module::SaveState( std::ostream& stream )
 	WRITE_POD( &oplmode, oplmode );
 	WRITE_POD( &lastUsed, lastUsed );
 
+	queue.Flush( [this]( uint32_t reg, uint32_t val ) { handler->WriteReg( reg, (uint8_t)val ); } );
 	handler->SaveState(stream);
 
 	WRITE_POD( &cache, cache );
@@ -1245,6 +1272,7 @@ void Adlib::Module::LoadState( std::istream& stream )
 	READ_POD( &oplmode, oplmode );
 	READ_POD( &lastUsed, lastUsed );
 
+	queue.Clear();
 	handler->LoadState(stream);
 
 	READ_POD( &cache, cache );
@@ -22,6 +22,7 @@
 
 #include "dosbox.h"
 #include "mixer.h"
+#include "mixer_queue.h"
 #include "inout.h"
 #include "setup.h"
 #include "pic.h"
@@ -173,6 +174,11 @@ class Module: public Module_base {
 		uint8_t rvol;
 		bool mixer;
     } ctrl = {};
+	//Chip register writes, applied at their sample offset by Generate()
+	MixerRegQueue queue;
+	bool queueWrites;
+	Bitu sampleRate;
+	void ChipWrite( uint32_t reg, uint8_t val );
 	void CacheWrite( uint32_t reg, uint8_t val );
 	void DualWrite( uint8_t index, uint8_t reg, uint8_t val );
 	void CtrlWrite( uint8_t val );
@@ -190,6 +196,7 @@ public:
 	//Handle port writes
 	void PortWrite( Bitu port, Bitu val, Bitu iolen );
 	Bitu PortRead( Bitu port, Bitu iolen );
+	void Generate( Bitu samples );
 	void Init( Mode m );
 
 	// savestate support
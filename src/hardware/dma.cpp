@@ -129,6 +129,27 @@ template <const unsigned int dma_mode> static void DMA_BlockWrite4KB(PhysPt spag
     }
 }
 
+/* host pointer to a block in plain RAM, for the zero-copy read.
+ * NULL if phys_readb() would not read the same bytes through the page handler (MMIO, unmapped, A20 alias,
+ * beyond the end of memory), in which case the caller copies with DMA_BlockRead4KB() instead. */
+static const uint8_t *DMA_BlockHostReadPt4KB(const PhysPt spage,const PhysPt offset,const Bitu size,const uint8_t dma16,const uint32_t DMA16_ADDRMASK) {
+    unsigned int o_size;
+    PhysPt xfer;
+
+    DMA_BlockReadCommonSetup<DMA_INCREMENT>(/*&*/xfer,/*&*/o_size,spage,offset,size,dma16,DMA16_ADDRMASK);
+
+    const Bitu page = xfer >> 12u;
+    if (page >= MEM_TotalPages()) return NULL;
+
+    PageHandler *ph = MEM_GetPageHandler(page);
+    if (ph == NULL || !(ph->getFlags() & PFLAG_READABLE)) return NULL;
+
+    const HostPt host = ph->GetHostReadPt(page);
+    if (host == NULL || host != (MemBase + (page * 4096u))) return NULL;
+
+    return host + (xfer & 0xFFFu);
+}
+
 DmaChannel * GetDMAChannel(uint8_t chan) {
 	if (chan<4) {
 		/* channel on first DMA controller */
@@ -411,6 +432,44 @@ DmaChannel::DmaChannel(uint8_t num, bool dma16) {
 	request = false;
 }
 
+/* bookkeeping after "cando" units were transferred within one 4KB page (Read, Write, ReadHostPt).
+ * returns false if the channel reached terminal count without autoinit and masked itself */
+bool DmaChannel::TransferDone(Bitu cando) {
+    if (increment) curraddr += (uint32_t)cando;
+    else curraddr -= (uint32_t)cando;
+
+    curraddr &= dma_wrapping;
+    currcnt -= (uint16_t)cando;
+
+    if (IS_PC98_ARCH) {
+        /* check wraparound, to emulate auto bank increment.
+         * do not check DMA16 because PC-98 does not have 16-bit DMA channels.
+         *
+         * The PC-98 port of Sim City 2000 needs this to properly play digitized speech,
+         * especially "reticulating splines". */
+        if ((( increment) && (curraddr & 0xFFFFu) == 0u) ||
+            ((!increment) && (curraddr & 0xFFFFu) == 0xFFFFu)) {
+            page_bank_increment();
+        }
+    }
+
+    if (currcnt == 0xFFFF) {
+        ReachedTC();
+        if (autoinit) {
+            currcnt = basecnt;
+            curraddr = baseaddr;
+            UpdateEMSMapping();
+        } else {
+            masked = true;
+            UpdateEMSMapping();
+            DoCallBack(DMA_MASKED);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 Bitu DmaChannel::Read(Bitu want, uint8_t * buffer) {
 	Bitu done=0;
 	curraddr &= dma_wrapping;
@@ -457,50 +516,48 @@ Bitu DmaChannel::Read(Bitu want, uint8_t * buffer) {
         if (increment) {
             assert((curraddr & (~addrmask)) == ((curraddr + ((uint32_t)cando - 1u)) & (~addrmask)));//check our work, must not cross a 4KB boundary
             DMA_BlockRead4KB<DMA_INCREMENT>(pagebase,curraddr,buffer,cando,DMA16,DMA16_ADDRMASK);
-            curraddr += (uint32_t)cando;
         }
         else {
             assert((curraddr & (~addrmask)) == ((curraddr - ((uint32_t)cando - 1u)) & (~addrmask)));//check our work, must not cross a 4KB boundary
             DMA_BlockRead4KB<DMA_DECREMENT>(pagebase,curraddr,buffer,cando,DMA16,DMA16_ADDRMASK);
-            curraddr -= (uint32_t)cando;
         }
 
-        curraddr &= dma_wrapping;
         buffer += cando << DMA16;
-        currcnt -= (uint16_t)cando;
         want -= cando;
         done += cando;
 
-        if (IS_PC98_ARCH) {
-            /* check wraparound, to emulate auto bank increment.
-             * do not check DMA16 because PC-98 does not have 16-bit DMA channels.
-             *
-             * The PC-98 port of Sim City 2000 needs this to properly play digitized speech,
-             * especially "reticulating splines". */
-            if ((( increment) && (curraddr & 0xFFFFu) == 0u) ||
-                ((!increment) && (curraddr & 0xFFFFu) == 0xFFFFu)) {
-                page_bank_increment();
-            }
-        }
-
-        if (currcnt == 0xFFFF) {
-            ReachedTC();
-            if (autoinit) {
-                currcnt = basecnt;
-                curraddr = baseaddr;
-                UpdateEMSMapping();
-            } else {
-                masked = true;
-                UpdateEMSMapping();
-                DoCallBack(DMA_MASKED);
-                break;
-            }
-        }
+        if (!TransferDone(cando))
+            break;
     }
 
 	return done;
 }
 
+/* Zero-copy alternative to Read() for devices that consume the data at once: returns a pointer to the
+ * next run of at most "want" transfer units in guest RAM (up to the end of the 4KB page or terminal count),
+ * advances the channel past it and stores the run length in "got". The pointer is only valid until the
+ * guest runs again. Returns NULL and transfers nothing if the run is not in plain RAM, the channel counts
+ * down, or Read() would refuse the transfer; the caller then falls back to Read(). */
+const uint8_t *DmaChannel::ReadHostPt(Bitu want, Bitu &got) {
+    got = 0;
+    curraddr &= dma_wrapping;
+
+    if (want == 0 || masked || transfer_mode != DMAT_READ || !increment)
+        return NULL;
+
+    const uint32_t addrmask = 0xFFFu >> DMA16;
+    const Bitu cando =
+        MIN(MIN(want,Bitu(currcnt+1u)),Bitu((addrmask + 1u) - (curraddr & addrmask)));
+
+    const uint8_t *ptr = DMA_BlockHostReadPt4KB(pagebase,curraddr,cando,DMA16,DMA16_ADDRMASK);
+    if (ptr == NULL)
+        return NULL;
+
+    got = cando;
+    TransferDone(cando);
+    return ptr;
+}
+
 Bitu DmaChannel::Write(Bitu want, uint8_t * buffer) {
 	Bitu done=0;
 	curraddr &= dma_wrapping;
@@ -543,45 +600,18 @@ Bitu DmaChannel::Write(Bitu want, uint8_t * buffer) {
         if (increment) {
             assert((curraddr & (~addrmask)) == ((curraddr + ((uint32_t)cando - 1u)) & (~addrmask)));//check our work, must not cross a 4KB boundary
             DMA_BlockWrite4KB<DMA_INCREMENT>(pagebase,curraddr,buffer,cando,DMA16,DMA16_ADDRMASK);
-            curraddr += (uint32_t)cando;
         }
         else {
             assert((curraddr & (~addrmask)) == ((curraddr - ((uint32_t)cando - 1u)) & (~addrmask)));//check our work, must not cross a 4KB boundary
             DMA_BlockWrite4KB<DMA_DECREMENT>(pagebase,curraddr,buffer,cando,DMA16,DMA16_ADDRMASK);
-            curraddr -= (uint32_t)cando;
         }
 
-        curraddr &= dma_wrapping;
         buffer += cando << DMA16;
-        currcnt -= (uint16_t)cando;
         want -= cando;
         done += cando;
 
-        if (IS_PC98_ARCH) {
-            /* check wraparound, to emulate auto bank increment.
-             * do not check DMA16 because PC-98 does not have 16-bit DMA channels.
-             *
-             * The PC-98 port of Sim City 2000 needs this to properly play digitized speech,
-             * especially "reticulating splines". */
-            if ((( increment) && (curraddr & 0xFFFFu) == 0u) ||
-                ((!increment) && (curraddr & 0xFFFFu) == 0xFFFFu)) {
-                page_bank_increment();
-            }
-        }
-
-        if (currcnt == 0xFFFF) {
-            ReachedTC();
-            if (autoinit) {
-                currcnt = basecnt;
-                curraddr = baseaddr;
-                UpdateEMSMapping();
-            } else {
-                masked = true;
-                UpdateEMSMapping();
-                DoCallBack(DMA_MASKED);
-                break;
-            }
-        }
+        if (!TransferDone(cando))
+            break;
     }
 
 	return done;
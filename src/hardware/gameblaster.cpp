@@ -19,6 +19,7 @@
 #include "dosbox.h"
 #include "inout.h"
 #include "mixer.h"
+#include "mixer_queue.h"
 #include "mem.h"
 #include "hardware.h"
 #include "setup.h"
@@ -38,11 +39,12 @@ static MixerChannel * cms_chan;
 static uint32_t lastWriteTicks;
 static uint32_t cmsBase;
 static saa1099_device* device[2];
+//Writes to the chips, applied at their sample offset by CMS_CallBack
+static MixerRegQueue cms_queue;
+static Bitu cms_rate;
 
-static void write_cms(Bitu port, Bitu val, Bitu /* iolen */) {
-	if(cms_chan && (!cms_chan->enabled)) cms_chan->Enable(true);
-	lastWriteTicks = (uint32_t)PIC_Ticks;
-	switch ( port - cmsBase ) {
+static void cms_apply(uint32_t port, uint32_t val) {
+	switch ( port ) {
 	case 1:
 		device[0]->control_w(0, 0, (u8)val);
 		break;
@@ -58,13 +60,29 @@ static void write_cms(Bitu port, Bitu val, Bitu /* iolen */) {
 	}
 }
 
+static void write_cms(Bitu port, Bitu val, Bitu /* iolen */) {
+	if(cms_chan && (!cms_chan->enabled)) cms_chan->Enable(true);
+	lastWriteTicks = (uint32_t)PIC_Ticks;
+	if ( !cms_chan ) {
+		cms_apply( (uint32_t)(port - cmsBase), (uint32_t)val );
+		return;
+	}
+	if ( cms_queue.Full() ) {
+		cms_chan->FillUp();
+		cms_queue.Flush( cms_apply );
+	}
+	cms_queue.Add( (uint32_t)(port - cmsBase), (uint32_t)val );
+}
+
 static void CMS_CallBack(Bitu len) {
 	enum {
 		BUFFER_SIZE = 2048
 	};
 
-	if ( len > BUFFER_SIZE )
+	if ( len > BUFFER_SIZE ) {
+		cms_queue.Flush( cms_apply );
 		return;
+	}
 
 	if ( cms_chan ) {
 
@@ -77,16 +95,20 @@ static void CMS_CallBack(Bitu len) {
 		int16_t work[2][BUFFER_SIZE];
 		int16_t* buffers[2] = { work[0], work[1] };
 		device_sound_interface::sound_stream stream;
-		device[0]->sound_stream_update(stream, 0, buffers, (int)len);
-		for (Bitu i = 0; i < len; i++) {
-			result[i][0] = work[0][i];
-			result[i][1] = work[1][i];
-		}
-		device[1]->sound_stream_update(stream, 0, buffers, (int)len);
-		for (Bitu i = 0; i < len; i++) {
-			result[i][0] += work[0][i];
-			result[i][1] += work[1][i];
-		}
+		cms_queue.Render( len, cms_rate,
+			[&]( Bitu offset, Bitu count ) {
+				device[0]->sound_stream_update(stream, 0, buffers, (int)count);
+				for (Bitu i = 0; i < count; i++) {
+					result[offset+i][0] = work[0][i];
+					result[offset+i][1] = work[1][i];
+				}
+				device[1]->sound_stream_update(stream, 0, buffers, (int)count);
+				for (Bitu i = 0; i < count; i++) {
+					result[offset+i][0] += work[0][i];
+					result[offset+i][1] += work[1][i];
+				}
+			},
+			cms_apply );
 		cms_chan->AddSamples_s32( len, result[0] );
 	}
 }
@@ -129,6 +151,8 @@ public:
 	CMS(Section* configuration):Module_base(configuration) {
 		Section_prop * section = static_cast<Section_prop *>(configuration);
 		Bitu sampleRate = (Bitu)section->Get_int( "oplrate" );
+		cms_rate = sampleRate;
+		cms_queue.Clear();
 		cmsBase = (uint32_t)section->Get_hex("sbbase");
 		WriteHandler.Install( cmsBase, write_cms, IO_MB, 4 );
 
@@ -203,6 +227,7 @@ void POD_Save_Gameblaster( std::ostream& stream )
     //************************************************
     //************************************************
 
+    cms_queue.Flush( cms_apply );
     for (int i=0; i<2; i++) {
         device[i]->SaveState(stream);
     }
@@ -240,6 +265,7 @@ void POD_Load_Gameblaster( std::istream& stream )
 	//************************************************
 	//************************************************
 
+    cms_queue.Clear();
     for (int i=0; i<2; i++) {
         device[i]->LoadState(stream);
    }
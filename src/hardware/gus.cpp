@@ -23,6 +23,7 @@
 #include "dosbox.h"
 #include "inout.h"
 #include "mixer.h"
+#include "mixer_queue.h"
 #include "dma.h"
 #include "pic.h"
 #include "control.h"
@@ -30,6 +31,7 @@
 #include "shell.h"
 #include "math.h"
 #include "regs.h"
+#include "gus_simd.h"
 using namespace std;
 
 #if defined(_MSC_VER)
@@ -439,10 +441,118 @@ public:
 		UpdateVolumes();
 	}
 
-    void generateSamples(int32_t* stream, uint32_t len) {
-        int32_t tmpsamp;
-        int i;
+    /* output volumes of a frame. The ICS mixer routing is folded into them:
+     * Lc/Rc bit 0 sends the voice's left/right volume to the left output,
+     * bit 1 to the right output. Lc=1 Rc=2 is the normal stereo output. */
+    static INLINE void MapVolumes(int16_t *v, const int32_t vl, const int32_t vr, const unsigned char Lc, const unsigned char Rc) {
+        v[0] = (int16_t)(((Lc & 1) ? vl : 0) + ((Rc & 1) ? vr : 0));
+        v[1] = (int16_t)(((Lc & 2) ? vl : 0) + ((Rc & 2) ? vr : 0));
+    }
+
+    static INLINE int32_t RampVolume(int32_t vol) {
+        vol&=~(vol >> 31); /* clamp negative values to zero, see UpdateVolumes() */
+        return vol16bit[vol >> RAMP_FRACT];
+    }
+
+    /* one frame with the full wave and ramp logic, used where a run ends */
+    INLINE void RenderFrame(int32_t *sp, const unsigned char Lc, const unsigned char Rc) {
+        const int32_t tmpsamp = (WaveCtrl & WCTRL_16BIT) ? GetSample16() : GetSample8();
+        int16_t v[2];
 
+        MapVolumes(v, VolLeft, VolRight, Lc, Rc);
+        sp[0] += tmpsamp * v[0];
+        sp[1] += tmpsamp * v[1];
+
+        WaveUpdate();
+        RampUpdate();
+    }
+
+    /* Number of frames, up to limit, from the current position on in which
+     * WaveUpdate() and RampUpdate() only step the position and the volume:
+     * no end address or ramp end is reached, so nothing loops, stops, changes
+     * direction or raises an IRQ. A stopped voice or ramp never ends. */
+    uint32_t QuietFrames(uint32_t limit) const {
+        uint32_t n = limit;
+
+        if ((WaveCtrl & (WCTRL_STOP | WCTRL_STOPPED)) == 0/*voice is running*/) {
+            if (WaveAddr >= (1u << (WAVE_FRACT + 20u/*1MB*/))) return 0;
+            if (WaveCtrl & WCTRL_DECREASING) {
+                if (WaveAddr < WaveStart) return 0;
+                if (WaveAdd != 0 && n > (WaveAddr - WaveStart) / WaveAdd) n = (WaveAddr - WaveStart) / WaveAdd;
+            }
+            else {
+                if (WaveAddr > WaveEnd) return 0;
+                if (WaveAdd != 0 && n > (WaveEnd - WaveAddr) / WaveAdd) n = (WaveEnd - WaveAddr) / WaveAdd;
+            }
+        }
+
+        if ((RampCtrl & 0x3) == 0/*ramp is running*/) {
+            /* ramp start and end are below the 4095 clamp, the volume does not reach it in a quiet run */
+            if (RampCtrl & 0x40) {
+                if ((int32_t)RampVol <= (int32_t)RampStart) return 0;
+                if (RampAdd != 0 && n > (RampVol - RampStart - 1u) / RampAdd) n = (RampVol - RampStart - 1u) / RampAdd;
+            }
+            else {
+                if ((int32_t)RampVol >= (int32_t)RampEnd) return 0;
+                if (RampAdd != 0 && n > (RampEnd - RampVol - 1u) / RampAdd) n = (RampEnd - RampVol - 1u) / RampAdd;
+            }
+        }
+
+        return n;
+    }
+
+    /* render count quiet frames (see QuietFrames()) in blocks: gather the sample points,
+     * weights and volumes of up to GUS_BLOCK_FRAMES frames, then let GUS_MixBlock()
+     * interpolate and mix them */
+    template <const bool is16bit> void RenderRun(int32_t *stream, uint32_t count, const unsigned char Lc, const unsigned char Rc) {
+        const bool running = (WaveCtrl & (WCTRL_STOP | WCTRL_STOPPED)) == 0;
+        const bool ramping = (RampCtrl & 0x3) == 0;
+        const bool decreasing = (WaveCtrl & WCTRL_DECREASING) != 0;
+        const uint32_t waveadd = running ? WaveAdd : 0;
+        const int32_t rampadd = ramping ? ((RampCtrl & 0x40) ? -(int32_t)RampAdd : (int32_t)RampAdd) : 0;
+        uint32_t addr = WaveAddr;
+        int32_t vol = (int32_t)RampVol;
+        int32_t vl = VolLeft, vr = VolRight;
+        GUSBlock b;
+
+        /* a stopped voice does not move, WaveUpdate() can only raise its IRQ */
+        if (!running) WaveUpdate();
+
+        while (count != 0) {
+            const unsigned int n = (count < GUS_BLOCK_FRAMES) ? (unsigned int)count : GUS_BLOCK_FRAMES;
+
+            for (unsigned int i = 0; i < n; i++) {
+                const uint32_t useAddr = addr >> WAVE_FRACT;
+                const int16_t frac = (int16_t)(addr & WAVE_FRACT_MASK);
+
+                b.point[i*2u]    = (int16_t)(is16bit ? LoadSample16(useAddr) : LoadSample8(useAddr));
+                b.point[i*2u+1u] = (int16_t)(is16bit ? LoadSample16(useAddr + 1u) : LoadSample8(useAddr + 1u));
+                b.weight[i*2u]    = (int16_t)((1 << WAVE_FRACT) - frac);
+                b.weight[i*2u+1u] = frac;
+                MapVolumes(b.vol + i*2u, vl, vr, Lc, Rc);
+
+                addr = decreasing ? (addr - waveadd) : (addr + waveadd);
+                if (ramping) {
+                    vol += rampadd;
+                    vl = RampVolume(vol - (int32_t)PanLeft);
+                    vr = RampVolume(vol - (int32_t)PanRight);
+                }
+            }
+
+            GUS_MixBlock(stream, b, n);
+            stream += n * 2u;
+            count -= n;
+        }
+
+        WaveAddr = addr;
+        if (ramping) {
+            RampVol = (uint32_t)vol;
+            VolLeft = vl;
+            VolRight = vr;
+        }
+    }
+
+    void generateSamples(int32_t* stream, uint32_t len) {
         /* NTS: The GUS is *always* rendering the audio sample at the current position,
          *      even if the voice is stopped. This can be confirmed using DOSLIB, loading
          *      the Ultrasound test program, loading a WAV file into memory, then using
@@ -451,50 +561,33 @@ public:
          *      is stopped. You will hear "popping" noises come out the GUS audio output
          *      as the current position changes and the piece of the sample rendered
          *      abruptly changes as well. */
-        if (gus_ics_mixer) {
-            const unsigned char Lc = read_GF1_mapping_control(0);
-            const unsigned char Rc = read_GF1_mapping_control(1);
+        if ((GUS_reset_reg & 0x02/*DAC enable*/) == 0)
+            return; /* nothing is output and the voice does not advance */
 
+        unsigned char Lc = 1, Rc = 2;
+        if (gus_ics_mixer) {
             // output mapped through ICS mixer including channel remapping
-            for (i = 0; i < (int)len; i++) {
-                // Get sample
-                if (WaveCtrl & WCTRL_16BIT)
-                    tmpsamp = GetSample16();
-                else
-                    tmpsamp = GetSample8();
-                // Output stereo sample if DAC enable on
-                if ((GUS_reset_reg & 0x02/*DAC enable*/) == 0x02) {
-                    int32_t* const sp = stream + (i << 1);
-                    const int32_t L = tmpsamp * VolLeft;
-                    const int32_t R = tmpsamp * VolRight;
-
-                    if (Lc & 1) sp[0] += L;
-                    if (Lc & 2) sp[1] += L;
-                    if (Rc & 1) sp[0] += R;
-                    if (Rc & 2) sp[1] += R;
-
-                    WaveUpdate();
-                    RampUpdate();
-                }
-            }
+            Lc = read_GF1_mapping_control(0);
+            Rc = read_GF1_mapping_control(1);
         }
-        else {
-            // normal output
-            for (i = 0; i < (int)len; i++) {
-                // Get sample
-                if (WaveCtrl & WCTRL_16BIT)
-                    tmpsamp = GetSample16();
-                else
-                    tmpsamp = GetSample8();
 
-                // Output stereo sample if DAC enable on
-                if ((GUS_reset_reg & 0x02/*DAC enable*/) == 0x02) {
-                    stream[i << 1] += tmpsamp * VolLeft;
-                    stream[(i << 1) + 1] += tmpsamp * VolRight;
+        /* The voice is rendered in runs between the frames where the position or
+         * the volume ramp reaches its end, those frames take the full path. */
+        while (len != 0) {
+            const uint32_t n = QuietFrames(len);
 
-                    WaveUpdate();
-                    RampUpdate();
-                }
+            if (n == 0) {
+                RenderFrame(stream, Lc, Rc);
+                stream += 2;
+                len--;
+            }
+            else {
+                if (WaveCtrl & WCTRL_16BIT)
+                    RenderRun<true>(stream, n, Lc, Rc);
+                else
+                    RenderRun<false>(stream, n, Lc, Rc);
+                stream += n * 2u;
+                len -= n;
             }
         }
     }
@@ -513,9 +606,117 @@ void GUS_StopDMA();
 void GUS_StartDMA();
 void GUS_Update_DMA_Event_transfer();
 
+/* Voice registers 00h-0Dh. Writes are queued with their time and applied by
+ * GUS_CallBack at that sample, instead of filling up the mixer on every write.
+ * Anything that reads or resets the voice state applies the queue first. */
+static MixerRegQueue gus_queue;
+
+static void GUS_WriteVoiceRegister(uint32_t reg,uint32_t val) {
+	GUSChannels *chan = guschan[(reg >> 8) & 31];
+	const uint16_t data = (uint16_t)val;
+
+	switch(reg & 0xFF) {
+	case 0x0:  // Channel voice control register
+		if(chan) chan->WriteWaveCtrl((uint16_t)data>>8);
+		break;
+	case 0x1:  // Channel frequency control register
+		if(chan) chan->WriteWaveFreq(data);
+		break;
+	case 0x2:  // Channel MSW start address register
+		if (chan) {
+			uint32_t tmpaddr = (uint32_t)(data & 0x1fff) << 16; /* upper 13 bits of integer portion */
+			chan->WaveStart = (chan->WaveStart & WAVE_MSWMASK) | tmpaddr;
+		}
+		break;
+	case 0x3:  // Channel LSW start address register
+		if(chan != NULL) {
+			uint32_t tmpaddr = (uint32_t)(data & 0xffe0); /* lower 7 bits of integer portion, and all 4 bits of fractional portion. bits 4-0 of the incoming 16-bit WORD are not used */
+			chan->WaveStart = (chan->WaveStart & WAVE_LSWMASK) | tmpaddr;
+		}
+		break;
+	case 0x4:  // Channel MSW end address register
+		if(chan != NULL) {
+			uint32_t tmpaddr = (uint32_t)(data & 0x1fff) << 16; /* upper 13 bits of integer portion */
+			chan->WaveEnd = (chan->WaveEnd & WAVE_MSWMASK) | tmpaddr;
+		}
+		break;
+	case 0x5:  // Channel LSW end address register
+		if(chan != NULL) {
+			uint32_t tmpaddr = (uint32_t)(data & 0xffe0); /* lower 7 bits of integer portion, and all 4 bits of fractional portion. bits 4-0 of the incoming 16-bit WORD are not used */
+			chan->WaveEnd = (chan->WaveEnd & WAVE_LSWMASK) | tmpaddr;
+		}
+		break;
+	case 0x6:  // Channel volume ramp rate register
+		if(chan != NULL) {
+			uint8_t tmpdata = (uint16_t)data>>8;
+			chan->WriteRampRate(tmpdata);
+		}
+		break;
+	case 0x7:  // Channel volume ramp start register  EEEEMMMM
+		if(chan != NULL) {
+			uint8_t tmpdata = (uint16_t)data >> 8;
+			chan->RampStart = (uint32_t)(tmpdata << (4+RAMP_FRACT));
+		}
+		break;
+	case 0x8:  // Channel volume ramp end register  EEEEMMMM
+		if(chan != NULL) {
+			uint8_t tmpdata = (uint16_t)data >> 8;
+			chan->RampEnd = (uint32_t)(tmpdata << (4+RAMP_FRACT));
+		}
+		break;
+	case 0x9:  // Channel current volume register
+		if(chan != NULL) {
+			uint16_t tmpdata = (uint16_t)data >> 4;
+			chan->RampVol = (uint32_t)(tmpdata << RAMP_FRACT);
+			chan->UpdateVolumes();
+		}
+		break;
+	case 0xA:  // Channel MSW current address register
+		if(chan != NULL) {
+			uint32_t tmpaddr = (uint32_t)(data & 0x1fff) << 16; /* upper 13 bits of integer portion */
+			chan->WaveAddr = (chan->WaveAddr & WAVE_MSWMASK) | tmpaddr;
+		}
+		break;
+	case 0xB:  // Channel LSW current address register
+		if(chan != NULL) {
+			uint32_t tmpaddr = (uint32_t)(data & 0xffff); /* lower 7 bits of integer portion, and all 9 bits of fractional portion */
+			chan->WaveAddr = (chan->WaveAddr & WAVE_LSWMASK) | tmpaddr;
+		}
+		break;
+	case 0xC:  // Channel pan pot register
+		if(chan) chan->WritePanPot((uint16_t)data>>8);
+		break;
+	case 0xD:  // Channel volume control register
+		if(chan) chan->WriteRampCtrl((uint16_t)data>>8);
+		break;
+	}
+}
+
+static void GUS_ApplyQueuedWrites(void) {
+	if (gus_queue.Empty()) return;
+
+	/* renders and applies up to now, the rest happened within the current sample */
+	gus_chan->FillUp();
+	gus_queue.Flush(GUS_WriteVoiceRegister);
+}
+
+/* voice control writes that raise or acknowledge a voice IRQ must reach the PIC at once */
+static bool GUS_VoiceIRQWrite(void) {
+	uint32_t pending;
+
+	if (curchan == NULL) return false;
+	if (myGUS.gRegSelect == 0x0) pending = myGUS.WaveIRQ;
+	else if (myGUS.gRegSelect == 0xD) pending = myGUS.RampIRQ;
+	else return false;
+
+	return (((myGUS.gRegData >> 8) & 0xa0) == 0xa0) != ((pending & curchan->irqmask) != 0);
+}
+
 static void GUSReset(void) {
 	unsigned char p_GUS_reset_reg = GUS_reset_reg;
 
+	GUS_ApplyQueuedWrites();
+
 	/* NTS: From the Ultrasound SDK:
 	 *
 	 *      Global Data Low (3X4) is either a 16-bit transfer, or the low half of a 16-bit transfer with 8-bit I/O.
@@ -694,6 +895,8 @@ static void CheckVoiceIrq(void) {
 
 static uint16_t ExecuteReadRegister(void) {
 	uint8_t tmpreg;
+
+	GUS_ApplyQueuedWrites();
 //	LOG_MSG("Read global reg %x",myGUS.gRegSelect);
 	switch (myGUS.gRegSelect) {
 	case 0x8E:  // read active channel register
@@ -796,85 +999,26 @@ static void ExecuteGlobRegister(void) {
 //	if (myGUS.gRegSelect|1!=0x44) LOG_MSG("write global register %x with %x", myGUS.gRegSelect, myGUS.gRegData);
 	switch(myGUS.gRegSelect) {
 	case 0x0:  // Channel voice control register
-		gus_chan->FillUp();
-		if(curchan) curchan->WriteWaveCtrl((uint16_t)myGUS.gRegData>>8);
-		break;
 	case 0x1:  // Channel frequency control register
-		gus_chan->FillUp();
-		if(curchan) curchan->WriteWaveFreq(myGUS.gRegData);
-		break;
 	case 0x2:  // Channel MSW start address register
-		if (curchan) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0x1fff) << 16; /* upper 13 bits of integer portion */
-			curchan->WaveStart = (curchan->WaveStart & WAVE_MSWMASK) | tmpaddr;
-		}
-		break;
 	case 0x3:  // Channel LSW start address register
-		if(curchan != NULL) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0xffe0); /* lower 7 bits of integer portion, and all 4 bits of fractional portion. bits 4-0 of the incoming 16-bit WORD are not used */
-			curchan->WaveStart = (curchan->WaveStart & WAVE_LSWMASK) | tmpaddr;
-		}
-		break;
 	case 0x4:  // Channel MSW end address register
-		if(curchan != NULL) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0x1fff) << 16; /* upper 13 bits of integer portion */
-			curchan->WaveEnd = (curchan->WaveEnd & WAVE_MSWMASK) | tmpaddr;
-		}
-		break;
-	case 0x5:  // Channel MSW end address register
-		if(curchan != NULL) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0xffe0); /* lower 7 bits of integer portion, and all 4 bits of fractional portion. bits 4-0 of the incoming 16-bit WORD are not used */
-			curchan->WaveEnd = (curchan->WaveEnd & WAVE_LSWMASK) | tmpaddr;
-		}
-		break;
+	case 0x5:  // Channel LSW end address register
 	case 0x6:  // Channel volume ramp rate register
-		gus_chan->FillUp();
-		if(curchan != NULL) {
-			uint8_t tmpdata = (uint16_t)myGUS.gRegData>>8;
-			curchan->WriteRampRate(tmpdata);
-		}
-		break;
-	case 0x7:  // Channel volume ramp start register  EEEEMMMM
-		if(curchan != NULL) {
-			uint8_t tmpdata = (uint16_t)myGUS.gRegData >> 8;
-			curchan->RampStart = (uint32_t)(tmpdata << (4+RAMP_FRACT));
-		}
-		break;
-	case 0x8:  // Channel volume ramp end register  EEEEMMMM
-		if(curchan != NULL) {
-			uint8_t tmpdata = (uint16_t)myGUS.gRegData >> 8;
-			curchan->RampEnd = (uint32_t)(tmpdata << (4+RAMP_FRACT));
-		}
-		break;
+	case 0x7:  // Channel volume ramp start register
+	case 0x8:  // Channel volume ramp end register
 	case 0x9:  // Channel current volume register
-		gus_chan->FillUp();
-		if(curchan != NULL) {
-			uint16_t tmpdata = (uint16_t)myGUS.gRegData >> 4;
-			curchan->RampVol = (uint32_t)(tmpdata << RAMP_FRACT);
-			curchan->UpdateVolumes();
-		}
-		break;
 	case 0xA:  // Channel MSW current address register
-		gus_chan->FillUp();
-		if(curchan != NULL) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0x1fff) << 16; /* upper 13 bits of integer portion */
-			curchan->WaveAddr = (curchan->WaveAddr & WAVE_MSWMASK) | tmpaddr;
-		}
-		break;
 	case 0xB:  // Channel LSW current address register
-		gus_chan->FillUp();
-		if(curchan != NULL) {
-			uint32_t tmpaddr = (uint32_t)(myGUS.gRegData & 0xffff); /* lower 7 bits of integer portion, and all 9 bits of fractional portion */
-			curchan->WaveAddr = (curchan->WaveAddr & WAVE_LSWMASK) | tmpaddr;
-		}
-		break;
 	case 0xC:  // Channel pan pot register
-		gus_chan->FillUp();
-		if(curchan) curchan->WritePanPot((uint16_t)myGUS.gRegData>>8);
-		break;
 	case 0xD:  // Channel volume control register
-		gus_chan->FillUp();
-		if(curchan) curchan->WriteRampCtrl((uint16_t)myGUS.gRegData>>8);
+		if (gus_queue.Full() || GUS_VoiceIRQWrite()) {
+			gus_chan->FillUp();
+			gus_queue.Flush(GUS_WriteVoiceRegister);
+			GUS_WriteVoiceRegister(((uint32_t)myGUS.gCurChannel << 8) | myGUS.gRegSelect,myGUS.gRegData);
+			break;
+		}
+		gus_queue.Add(((uint32_t)myGUS.gCurChannel << 8) | myGUS.gRegSelect,myGUS.gRegData);
 		break;
 	case 0xE:  // Set active channel register
         /* Hack for "Ice Fever" demoscene production:
@@ -891,6 +1035,7 @@ static void ExecuteGlobRegister(void) {
         }
 
 		gus_chan->FillUp();
+		gus_queue.Flush(GUS_WriteVoiceRegister);
 		myGUS.gRegSelect = myGUS.gRegData>>8;		//JAZZ Jackrabbit seems to assume this?
 		myGUS.ActiveChannelsUser = 1+((myGUS.gRegData>>8) & 31); // NTS: The GUS SDK documents this field as bits 5-0, which is wrong, it's bits 4-0. 5-0 would imply 64 channels.
 
@@ -1366,6 +1511,8 @@ static Bitu read_gus(Bitu port,Bitu iolen) {
 
 	switch(port - GUS_BASE) {
 	case 0x206:
+		GUS_ApplyQueuedWrites();
+
 		if (myGUS.clearTCIfPollingIRQStatus) {
 			double t = PIC_FullIndex();
 
@@ -1926,11 +2073,15 @@ static void GUS_CallBack(Bitu len) {
     int32_t buffer[MIXER_BUFSIZE][2];
     memset(buffer, 0, len * sizeof(buffer[0]));
 
-    if ((GUS_reset_reg & 0x01/*!master reset*/) == 0x01) {
-        for (Bitu i = 0; i < myGUS.ActiveChannels; i++) {
-            guschan[i]->generateSamples(buffer[0], len);
-        }
-    }
+    gus_queue.Render(len, myGUS.fixed_sample_rate_output ? GUS_RATE : myGUS.basefreq,
+        [&](Bitu offset, Bitu count) {
+            if ((GUS_reset_reg & 0x01/*!master reset*/) == 0x01) {
+                for (Bitu i = 0; i < myGUS.ActiveChannels; i++) {
+                    guschan[i]->generateSamples(buffer[offset], count);
+                }
+            }
+        },
+        GUS_WriteVoiceRegister);
 
     // FIXME: I wonder if the GF1 chip DAC had more than 16 bits precision
     //        to render louder than 100% volume without clipping, and if so,
@@ -2332,6 +2483,7 @@ public:
 			guschan[chan_ct] = new GUSChannels(chan_ct);
 		}
 		// Register the Mixer CallBack 
+		gus_queue.Clear();
 		gus_chan=MixerChan.Install(GUS_CallBack,GUS_RATE,"GUS");
 
 		// FIXME: Could we leave the card in reset state until a fake ULTRINIT runs?
@@ -2492,6 +2644,7 @@ const char pod_name[32] = "GUS";
 	if( !test ) return;
 	if( !gus_chan ) return;
 
+	gus_queue.Flush(GUS_WriteVoiceRegister);
 
 	WRITE_POD( &pod_name, pod_name );
 
@@ -2556,6 +2709,8 @@ void POD_Load_GUS( std::istream& stream )
 		return;
 	}
 
+	gus_queue.Clear();
+
 	//************************************************
 	//************************************************
 	//************************************************
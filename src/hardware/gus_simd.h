@@ -0,0 +1,128 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Interpolation and volume stage of the GUS block voice renderer in gus.cpp.
+ *
+ * The voice renderer gathers a block of frames between wave and ramp events,
+ * per frame the two sample points around the current position, their weights
+ * and the output volumes. GUS_MixBlock() then interpolates and adds the
+ * scaled samples to the stereo stream:
+ *
+ *   s = (w1 * (512 - frac) + w2 * frac) >> 9     (== w1 + ((w2 - w1) * frac) >> 9)
+ *   stream[0] += s * vol[0], stream[1] += s * vol[1]
+ *
+ * which gives the same result as GetSample8/16() and the sample at a time
+ * mixing. All inputs fit in 16 bits: sample points are sign extended 8 or
+ * 16-bit values, weights are at most 512 and volumes (including the ICS mixer
+ * sum of both channels) at most 16384.
+ *
+ * x86 builds use SSE2 (pmaddwd) when available, AArch64 builds use NEON. */
+
+#ifndef DOSBOX_GUS_SIMD_H
+#define DOSBOX_GUS_SIMD_H
+
+/* frames gathered per call, generateSamples() loops for longer runs */
+#define GUS_BLOCK_FRAMES		64
+
+#if defined(__SSE__) && !(defined(_M_AMD64) || defined(__e2k__))
+/* sse2_available is set up by CheckX86ExtensionsSupport() */
+# define GUS_MIX_SIMD_X86 1
+# include <immintrin.h>
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+# define GUS_MIX_SIMD_NEON 1
+# include <arm_neon.h>
+#endif
+
+struct GUSBlock {
+	int16_t		point[GUS_BLOCK_FRAMES*2];	/* w1, w2 per frame */
+	int16_t		weight[GUS_BLOCK_FRAMES*2];	/* 512 - frac, frac per frame */
+	int16_t		vol[GUS_BLOCK_FRAMES*2];	/* left, right output volume per frame */
+};
+
+static inline void GUS_MixBlock_C(int32_t *stream, const GUSBlock &b, unsigned int i, const unsigned int count) {
+	for (;i < count;i++) {
+		const int32_t s = ((int32_t)b.point[i*2u] * b.weight[i*2u] + (int32_t)b.point[i*2u+1u] * b.weight[i*2u+1u]) >> 9;
+		stream[i*2u]    += s * b.vol[i*2u];
+		stream[i*2u+1u] += s * b.vol[i*2u+1u];
+	}
+}
+
+#if defined(GUS_MIX_SIMD_X86)
+#ifdef __GNUC__
+__attribute__((__target__("sse2")))
+#endif
+static inline void GUS_MixBlock_SSE2(int32_t *stream, const GUSBlock &b, const unsigned int count) {
+	unsigned int i = 0;
+
+	for (;(i+4u) <= count;i += 4u) {
+		/* four frames: interpolate, then duplicate each sample for left and right */
+		const __m128i p = _mm_loadu_si128((const __m128i*)(b.point+i*2u));
+		const __m128i w = _mm_loadu_si128((const __m128i*)(b.weight+i*2u));
+		const __m128i s32 = _mm_srai_epi32(_mm_madd_epi16(p, w), 9);
+		const __m128i s16 = _mm_packs_epi32(s32, s32);
+		const __m128i s = _mm_unpacklo_epi16(s16, s16);
+
+		/* 16x16 -> 32-bit products, frames 0-1 and 2-3 */
+		const __m128i v = _mm_loadu_si128((const __m128i*)(b.vol+i*2u));
+		const __m128i lo = _mm_mullo_epi16(s, v);
+		const __m128i hi = _mm_mulhi_epi16(s, v);
+		__m128i *d = (__m128i*)(stream+i*2u);
+		_mm_storeu_si128(d,    _mm_add_epi32(_mm_loadu_si128(d),    _mm_unpacklo_epi16(lo, hi)));
+		_mm_storeu_si128(d+1u, _mm_add_epi32(_mm_loadu_si128(d+1u), _mm_unpackhi_epi16(lo, hi)));
+	}
+
+	GUS_MixBlock_C(stream, b, i, count);
+}
+#endif
+
+#if defined(GUS_MIX_SIMD_NEON)
+static inline void GUS_MixBlock_NEON(int32_t *stream, const GUSBlock &b, const unsigned int count) {
+	unsigned int i = 0;
+
+	for (;(i+4u) <= count;i += 4u) {
+		const int16x8_t p = vld1q_s16(b.point+i*2u);
+		const int16x8_t w = vld1q_s16(b.weight+i*2u);
+		const int32x4_t s32 = vshrq_n_s32(vpaddq_s32(vmull_s16(vget_low_s16(p), vget_low_s16(w)), vmull_high_s16(p, w)), 9);
+		const int16x4_t s16 = vmovn_s32(s32);
+		const int16x8_t s = vcombine_s16(vzip1_s16(s16, s16), vzip2_s16(s16, s16));
+
+		const int16x8_t v = vld1q_s16(b.vol+i*2u);
+		int32_t *d = stream+i*2u;
+		vst1q_s32(d,    vaddq_s32(vld1q_s32(d),    vmull_s16(vget_low_s16(s), vget_low_s16(v))));
+		vst1q_s32(d+4u, vaddq_s32(vld1q_s32(d+4u), vmull_high_s16(s, v)));
+	}
+
+	GUS_MixBlock_C(stream, b, i, count);
+}
+#endif
+
+static inline void GUS_MixBlock(int32_t *stream, const GUSBlock &b, const unsigned int count) {
+#if defined(GUS_MIX_SIMD_X86)
+	if (sse2_available) {
+		GUS_MixBlock_SSE2(stream, b, count);
+		return;
+	}
+	GUS_MixBlock_C(stream, b, 0, count);
+#elif defined(GUS_MIX_SIMD_NEON)
+	GUS_MixBlock_NEON(stream, b, count);
+#else
+	GUS_MixBlock_C(stream, b, 0, count);
+#endif
+}
+
+#endif /*DOSBOX_GUS_SIMD_H*/
@@ -31,6 +31,7 @@
 #include "mixer.h"
 #include "render.h"
 #include "cross.h"
+#include "SDL.h"
 
 #if (C_SSHOT)
 #include <zlib.h>
@@ -40,9 +41,13 @@
 
 #include "riff_wav_writer.h"
 #include "avi_writer.h"
+#include "avi_rw_iobuf.h"
 #include "rawint.h"
 
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <atomic>
 
 #if (C_AVCODEC)
 extern "C" {
@@ -320,6 +325,22 @@ Bitu CaptureState = 0;
 
 #define WAVE_BUF 16*1024
 #define MIDI_BUF 4*1024
+#define MT_WAVE_RING (64*1024)	/* frames staged per multitrack stream */
+#define MT_WAVE_CHUNK (8*1024)	/* frames per AVI chunk written by the multitrack writer */
+
+/* Single producer (emulation thread), single consumer (multitrack writer) ring
+ * of stereo frames, one per multitrack AVI stream. head is only written by the
+ * producer, tail only by the consumer. */
+struct MTWaveRing {
+	int16_t buf[MT_WAVE_RING][2];
+	std::atomic<size_t> head;
+	std::atomic<size_t> tail;
+
+	MTWaveRing() : head(0), tail(0) { }
+	size_t Used(void) const {
+		return (head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire)) % MT_WAVE_RING;
+	}
+};
 
 static struct {
 	struct {
@@ -333,6 +354,13 @@ static struct {
         avi_writer  *writer;
 		Bitu		audiorate;
         std::map<std::string,size_t> name_to_stream_index;
+        std::vector<MTWaveRing*> rings;		/* by AVI stream index */
+        SDL_Thread  *thread;			/* owns writer while running, NULL = drained on the emulation thread */
+        SDL_mutex   *lock;
+        SDL_cond    *wake;
+        bool        stop;
+        /* write-combining statistics */
+        uint64_t    frames,calls,writes,stalls;
     } multitrack_wave = {};
 	struct {
 		FILE * handle;
@@ -1519,6 +1547,150 @@ void CAPTURE_ScreenShotEvent(bool pressed) {
 
 MixerChannel * MIXER_FirstChannel(void);
 
+/* Multitrack wave capture gets a short block from every mixer channel every
+ * millisecond. Writing each one as its own AVI chunk means thousands of small
+ * writes (and index entries) per second with many channels, on the emulation
+ * thread. Instead the blocks are staged per stream and a writer thread writes
+ * MT_WAVE_CHUNK frames or more per stream as one chunk. If the thread cannot
+ * be started the emulation thread does the same batching itself. */
+
+/* write out staged frames, streams with at least MT_WAVE_CHUNK frames or all of them.
+ * Called by whoever owns the writer: the writer thread, or the emulation thread. */
+static bool CAPTURE_MultiTrackDrain(bool all) {
+    static int16_t tmp[MT_WAVE_RING][2];
+    bool wrote = false;
+
+    for (size_t index=0;index < capture.multitrack_wave.rings.size();index++) {
+        MTWaveRing *r = capture.multitrack_wave.rings[index];
+        if (r == NULL) continue;
+
+        const size_t used = r->Used();
+        if (used == 0 || (!all && used < MT_WAVE_CHUNK)) continue;
+
+        const size_t tail = r->tail.load(std::memory_order_relaxed);
+        const size_t first = std::min(used,(size_t)MT_WAVE_RING - tail);
+        memcpy(tmp,r->buf[tail],first*sizeof(tmp[0]));
+        if (first < used) memcpy(tmp[first],r->buf[0],(used-first)*sizeof(tmp[0]));
+        r->tail.store((tail + used) % MT_WAVE_RING,std::memory_order_release);
+
+        avi_writer_stream *os = capture.multitrack_wave.writer->avi_stream + index;
+        avi_writer_stream_write(capture.multitrack_wave.writer,os,tmp,used * 2 * 2,/*keyframe*/0x10);
+        capture.multitrack_wave.writes++;
+        wrote = true;
+    }
+
+    return wrote;
+}
+
+static int CAPTURE_MultiTrackThreadProc(void *data) {
+    (void)data;//UNUSED
+
+    SDL_LockMutex(capture.multitrack_wave.lock);
+    while (!capture.multitrack_wave.stop) {
+        SDL_UnlockMutex(capture.multitrack_wave.lock);
+        const bool wrote = CAPTURE_MultiTrackDrain(false);
+        SDL_LockMutex(capture.multitrack_wave.lock);
+
+        /* the producer signals under the lock after adding frames, so this cannot miss a wakeup */
+        if (!wrote && !capture.multitrack_wave.stop)
+            SDL_CondWaitTimeout(capture.multitrack_wave.wake,capture.multitrack_wave.lock,100);
+    }
+    SDL_UnlockMutex(capture.multitrack_wave.lock);
+
+    CAPTURE_MultiTrackDrain(true);
+    avi_io_buffer_free();
+    return 0;
+}
+
+static void CAPTURE_MultiTrackWake(void) {
+    SDL_LockMutex(capture.multitrack_wave.lock);
+    SDL_CondSignal(capture.multitrack_wave.wake);
+    SDL_UnlockMutex(capture.multitrack_wave.lock);
+}
+
+static void CAPTURE_MultiTrackStartThread(void) {
+    capture.multitrack_wave.frames = capture.multitrack_wave.calls = 0;
+    capture.multitrack_wave.writes = capture.multitrack_wave.stalls = 0;
+    capture.multitrack_wave.stop = false;
+    capture.multitrack_wave.lock = SDL_CreateMutex();
+    capture.multitrack_wave.wake = SDL_CreateCond();
+#if defined(C_SDL2)
+    capture.multitrack_wave.thread = SDL_CreateThread(CAPTURE_MultiTrackThreadProc,"mtwave",NULL);
+#else
+    capture.multitrack_wave.thread = SDL_CreateThread(CAPTURE_MultiTrackThreadProc,NULL);
+#endif
+    if (capture.multitrack_wave.thread == NULL)
+        LOG_MSG("Multitrack: Unable to start the writer thread, writing on the emulation thread");
+}
+
+/* stop the writer thread (or drain on this thread), after this the emulation thread owns the writer again */
+static void CAPTURE_MultiTrackStopThread(void) {
+    if (capture.multitrack_wave.thread != NULL) {
+        SDL_LockMutex(capture.multitrack_wave.lock);
+        capture.multitrack_wave.stop = true;
+        SDL_CondSignal(capture.multitrack_wave.wake);
+        SDL_UnlockMutex(capture.multitrack_wave.lock);
+        SDL_WaitThread(capture.multitrack_wave.thread,NULL);
+        capture.multitrack_wave.thread = NULL;
+    }
+    else if (capture.multitrack_wave.writer != NULL) {
+        CAPTURE_MultiTrackDrain(true);
+    }
+
+    if (capture.multitrack_wave.wake != NULL) {
+        SDL_DestroyCond(capture.multitrack_wave.wake);
+        capture.multitrack_wave.wake = NULL;
+    }
+    if (capture.multitrack_wave.lock != NULL) {
+        SDL_DestroyMutex(capture.multitrack_wave.lock);
+        capture.multitrack_wave.lock = NULL;
+    }
+
+    for (size_t i=0;i < capture.multitrack_wave.rings.size();i++)
+        delete capture.multitrack_wave.rings[i];
+    capture.multitrack_wave.rings.clear();
+}
+
+static void CAPTURE_MultiTrackStage(size_t index,uint32_t len,const int16_t *data) {
+    MTWaveRing *r = capture.multitrack_wave.rings[index];
+
+    capture.multitrack_wave.calls++;
+    capture.multitrack_wave.frames += len;
+
+    while (len > 0) {
+        size_t avail = (MT_WAVE_RING - 1) - r->Used();
+
+        if (avail == 0) {
+            /* the writer fell behind, wait for it rather than drop audio */
+            capture.multitrack_wave.stalls++;
+            if (capture.multitrack_wave.thread != NULL) {
+                CAPTURE_MultiTrackWake();
+                SDL_Delay(1);
+            }
+            else {
+                CAPTURE_MultiTrackDrain(true);
+            }
+            continue;
+        }
+
+        const size_t head = r->head.load(std::memory_order_relaxed);
+        size_t todo = std::min(avail,(size_t)len);
+        if (todo > (size_t)MT_WAVE_RING - head) todo = (size_t)MT_WAVE_RING - head;
+
+        memcpy(r->buf[head],data,todo*sizeof(r->buf[0]));
+        r->head.store((head + todo) % MT_WAVE_RING,std::memory_order_release);
+        data += todo * 2;
+        len -= (uint32_t)todo;
+    }
+
+    if (r->Used() >= MT_WAVE_CHUNK) {
+        if (capture.multitrack_wave.thread != NULL)
+            CAPTURE_MultiTrackWake();
+        else
+            CAPTURE_MultiTrackDrain(false);
+    }
+}
+
 void CAPTURE_MultiTrackAddWave(uint32_t freq, uint32_t len, int16_t * data,const char *name) {
 #if !defined(C_EMSCRIPTEN)
     if (CaptureState & CAPTURE_MULTITRACK_WAVE) {
@@ -1630,6 +1802,13 @@ void CAPTURE_MultiTrackAddWave(uint32_t freq, uint32_t len, int16_t * data,const
 			if (!avi_writer_begin_header(capture.multitrack_wave.writer) || !avi_writer_begin_data(capture.multitrack_wave.writer))
 				goto skip_mt_wav;
 
+            capture.multitrack_wave.rings.resize((size_t)capture.multitrack_wave.writer->avi_stream_alloc,NULL);
+            for (std::map<std::string,size_t>::iterator ni=capture.multitrack_wave.name_to_stream_index.begin();ni!=capture.multitrack_wave.name_to_stream_index.end();ni++) {
+                if (ni->second < capture.multitrack_wave.rings.size() && capture.multitrack_wave.rings[ni->second] == NULL)
+                    capture.multitrack_wave.rings[ni->second] = new MTWaveRing();
+            }
+            CAPTURE_MultiTrackStartThread();
+
 			LOG_MSG("Started capturing multitrack audio (%u channels).",streams);
 		}
 
@@ -1638,9 +1817,8 @@ void CAPTURE_MultiTrackAddWave(uint32_t freq, uint32_t len, int16_t * data,const
             if (ni != capture.multitrack_wave.name_to_stream_index.end()) {
                 size_t index = ni->second;
 
-                if (index < (size_t)capture.multitrack_wave.writer->avi_stream_alloc) {
-                    avi_writer_stream *os = capture.multitrack_wave.writer->avi_stream + index;
-			        avi_writer_stream_write(capture.multitrack_wave.writer,os,data,len * 2 * 2,/*keyframe*/0x10);
+                if (index < capture.multitrack_wave.rings.size() && capture.multitrack_wave.rings[index] != NULL) {
+                    CAPTURE_MultiTrackStage(index,len,data);
                 }
                 else {
                     LOG_MSG("Multitrack: Ignoring unknown track '%s', out of range\n",name);
@@ -1654,6 +1832,7 @@ void CAPTURE_MultiTrackAddWave(uint32_t freq, uint32_t len, int16_t * data,const
 
     return;
 skip_mt_wav:
+    CAPTURE_MultiTrackStopThread();
 	capture.multitrack_wave.writer = avi_writer_destroy(capture.multitrack_wave.writer);
 #endif
 }
@@ -1740,7 +1919,11 @@ void CAPTURE_MTWaveEvent(bool pressed) {
 #if !defined(C_EMSCRIPTEN)
     if (CaptureState & CAPTURE_MULTITRACK_WAVE) {
         if (capture.multitrack_wave.writer != NULL) {
+            CAPTURE_MultiTrackStopThread();
             LOG_MSG("Stopped capturing multitrack wave output.");
+            LOG_MSG("Multitrack: %llu frames, %llu blocks from the mixer written as %llu AVI chunks, %llu stalls",
+                (unsigned long long)capture.multitrack_wave.frames,(unsigned long long)capture.multitrack_wave.calls,
+                (unsigned long long)capture.multitrack_wave.writes,(unsigned long long)capture.multitrack_wave.stalls);
             capture.multitrack_wave.name_to_stream_index.clear();
             avi_writer_end_data(capture.multitrack_wave.writer);
             avi_writer_finish(capture.multitrack_wave.writer);
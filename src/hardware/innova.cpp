@@ -23,6 +23,7 @@
 #include "pic.h"
 #include "setup.h"
 #include "control.h"
+#include "mixer_queue.h"
 
 #include "reSID/sid.h"
 
@@ -33,9 +34,17 @@ static struct {
 	Bitu rate;
 	Bitu basePort;
 	Bitu last_used;
+	Bitu cycle_frac;	/* SID_FREQ*samples remainder, in 1/rate cycles */
+	cycle_count cycles_left;	/* cycles not clocked yet */
 	MixerChannel * chan;
+	//Writes to the chip, applied at their sample offset by INNOVA_CallBack
+	MixerRegQueue queue;
 } innova;
 
+static void innova_apply(uint32_t reg, uint32_t val) {
+	innova.sid->write((reg8)reg, (reg8)val);
+}
+
 static void innova_write(Bitu port,Bitu val,Bitu iolen) {
     (void)iolen;//UNUSED
 	if (!innova.last_used) {
@@ -44,12 +53,22 @@ static void innova_write(Bitu port,Bitu val,Bitu iolen) {
 	innova.last_used=PIC_Ticks;
 
 	Bitu sidPort = port-innova.basePort;
-	innova.sid->write((reg8)sidPort, (reg8)val);
+	if (innova.queue.Full()) {
+		innova.chan->FillUp();
+		innova.queue.Flush(innova_apply);	/* left over if the mixer had nothing to render */
+	}
+	innova.queue.Add((uint32_t)sidPort, (uint32_t)val);
 }
 
 static Bitu innova_read(Bitu port,Bitu iolen) {
     (void)iolen;//UNUSED
 	Bitu sidPort = port-innova.basePort;
+	/* OSC3/ENV3 depend on the writes still queued, render up to now */
+	if (!innova.queue.Empty()) {
+		innova.chan->FillUp();
+		/* FillUp renders nothing inside the current sample, apply what is left now */
+		innova.queue.Flush(innova_apply);
+	}
 	return innova.sid->read((reg8)sidPort);
 }
 
@@ -57,13 +76,29 @@ static Bitu innova_read(Bitu port,Bitu iolen) {
 static void INNOVA_CallBack(Bitu len) {
 	if (!len) return;
 
-	cycle_count delta_t = (cycle_count)(SID_FREQ*len/innova.rate);
-	short* buffer = (short*)MixTemp;
-	Bitu bufindex = 0;
-
-	while(delta_t && bufindex != len) {
-		bufindex += (Bitu)innova.sid->clock(delta_t, buffer+bufindex, (int)(len-bufindex));
+	if (len > MIXER_BUFSIZE/sizeof(short)) {
+		innova.queue.Flush(innova_apply);
+		return;
 	}
+
+	short* buffer = (short*)MixTemp;
+	innova.queue.Render(len, innova.rate,
+		[&](Bitu offset, Bitu count) {
+			/* cycles for count samples, the fraction carries over to the next run */
+			innova.cycle_frac += SID_FREQ*count;
+			cycle_count delta_t = innova.cycles_left + (cycle_count)(innova.cycle_frac/innova.rate);
+			innova.cycle_frac %= innova.rate;
+
+			Bitu bufindex = 0;
+			while (delta_t && bufindex != count)
+				bufindex += (Bitu)innova.sid->clock(delta_t, buffer+offset+bufindex, (int)(count-bufindex));
+			innova.cycles_left = delta_t;
+
+			/* sample clock ran short by a cycle, repeat the last sample */
+			for (;bufindex < count;bufindex++)
+				buffer[offset+bufindex] = (offset+bufindex) ? buffer[offset+bufindex-1] : 0;
+		},
+		innova_apply);
 	innova.chan->AddSamples_m16(len, buffer);
 
 	if (innova.last_used+5000<PIC_Ticks) {
@@ -103,8 +138,12 @@ public:
 		innova.sid->enable_filter(true);
 		innova.sid->enable_external_filter(true);
 		innova.sid->set_sampling_parameters(SID_FREQ, method, (double)innova.rate, -1, 0.97);
+		innova.sid->enable_block_clocking(true);
 
 		innova.last_used=0;
+		innova.cycle_frac=0;
+		innova.cycles_left=0;
+		innova.queue.Clear();
 
 		LOG_MSG("INNOVA:... finished.");
 	}
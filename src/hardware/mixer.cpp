@@ -23,7 +23,10 @@
 */
 
 #include <string.h>
+#include <stdio.h>
+#include <signal.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #define _USE_MATH_DEFINES // needed for M_PI in Visual Studio as documented [https://msdn.microsoft.com/en-us/library/4hwaceh6.aspx]
 #include <math.h>
 
@@ -38,12 +41,18 @@
 #endif
 #include <windows.h>
 #include <mmsystem.h>
+#include <io.h>
+#include <fcntl.h>
 #endif
 
 #if !defined(M_PI)
 # define M_PI (3.141592654)
 #endif
 
+#if !defined(S_ISREG)
+# define S_ISREG(x) ((x & S_IFREG) == S_IFREG)
+#endif
+
 #include "SDL.h"
 #include "mem.h"
 #include "pic.h"
@@ -53,11 +62,16 @@
 #include "setup.h"
 #include "cross.h"
 #include "support.h"
+#include "frametime.h"
 #include "control.h"
 #include "mapper.h"
 #include "hardware.h"
 #include "programs.h"
 #include "midi.h"
+#include "mixer_sinc.h"
+#include "riff_wav_writer.h"
+#include "wave_mmreg.h"
+#include "rawint.h"
 
 #define MIXER_SSIZE 4
 #define MIXER_VOLSHIFT 13
@@ -96,6 +110,10 @@ static struct {
     bool            prebuffer_wait;
     Bitu            prebuffer_samples;
     bool            mute;
+    unsigned int    sinc_taps;          // 0 = linear interpolation
+    unsigned int    sinc_phases;
+    double          sinc_cutoff;        // passband, fraction of the lower Nyquist frequency
+    double          sinc_beta;          // Kaiser window
 } mixer;
 
 uint32_t Mixer_MIXQ(void) {
@@ -107,6 +125,155 @@ uint32_t Mixer_MIXQ(void) {
 }
 
 PhysPt mixer_capture_write = 0;
+
+/* [mixer] stream: send the mixed output to a file, FIFO or stdout instead of
+ * the sound device. Mixing runs off the emulated clock (MIXER_Mix is a timer
+ * tick handler either way), so nothing paces the emulator to the host audio
+ * device and an unthrottled guest renders faster than real time.
+ *
+ * Regular files are written with the RIFF WAV writer, which fills in the chunk
+ * sizes when the stream is closed. Pipes and stdout cannot seek back, they get
+ * a WAV header with "unknown" (0xFFFFFFFF) sizes that most tools accept for
+ * streaming, followed by the samples as they are mixed. */
+static struct {
+    riff_wav_writer*    wav;            // regular file
+    FILE*               fp;             // pipe, FIFO or stdout
+    std::vector<int16_t> buf;
+    size_t              buf_frames;     // flush threshold
+} mixer_stream = { NULL, NULL, std::vector<int16_t>(), 0 };
+
+static bool MIXER_StreamActive(void) {
+    return mixer_stream.wav != NULL || mixer_stream.fp != NULL;
+}
+
+static void MIXER_StreamClose(void) {
+    if (mixer_stream.wav != NULL) {
+        riff_wav_writer_end_data(mixer_stream.wav);
+        mixer_stream.wav = riff_wav_writer_destroy(mixer_stream.wav);
+    }
+    if (mixer_stream.fp != NULL) {
+        if (mixer_stream.fp != stdout) fclose(mixer_stream.fp);
+        else fflush(mixer_stream.fp);
+        mixer_stream.fp = NULL;
+    }
+    mixer_stream.buf.clear();
+}
+
+static void MIXER_StreamFlush(void) {
+    const size_t bytes = mixer_stream.buf.size() * sizeof(int16_t);
+    bool ok = true;
+
+    if (bytes == 0) return;
+
+    if (mixer_stream.wav != NULL)
+        ok = riff_wav_writer_data_write(mixer_stream.wav,&mixer_stream.buf[0],bytes) > 0;
+    else if (mixer_stream.fp != NULL)
+        ok = fwrite(&mixer_stream.buf[0],bytes,1,mixer_stream.fp) == 1;
+
+    mixer_stream.buf.clear();
+
+    if (!ok) {
+        LOG_MSG("MIXER: Write to the output stream failed, stopping it");
+        MIXER_StreamClose();
+    }
+}
+
+static bool MIXER_StreamOpen(const std::string &path) {
+    windows_WAVEFORMAT fmt;
+
+    memset(&fmt,0,sizeof(fmt));
+    __w_le_u16(&fmt.wFormatTag,windows_WAVE_FORMAT_PCM);
+    __w_le_u16(&fmt.nChannels,2);			/* stereo */
+    __w_le_u32(&fmt.nSamplesPerSec,(uint32_t)mixer.freq);
+    __w_le_u16(&fmt.wBitsPerSample,16);		/* 16-bit/sample */
+    __w_le_u16(&fmt.nBlockAlign,2*2);
+    __w_le_u32(&fmt.nAvgBytesPerSec,(uint32_t)(mixer.freq*2*2));
+
+    struct stat st;
+
+    if (path == "-" || (stat(path.c_str(),&st) == 0 && !S_ISREG(st.st_mode))) {
+        if (path == "-") {
+#if defined(WIN32)
+            _setmode(_fileno(stdout),_O_BINARY);
+#endif
+            mixer_stream.fp = stdout;
+        }
+        else {
+            mixer_stream.fp = fopen(path.c_str(),"wb");
+            if (mixer_stream.fp == NULL) return false;
+        }
+#if !defined(WIN32)
+        /* a reader going away must not kill the emulator, fwrite() fails instead */
+        signal(SIGPIPE,SIG_IGN);
+#endif
+
+        unsigned char hdr[12+8+sizeof(fmt)+8];
+
+        memcpy(hdr+0,"RIFF",4);
+        __w_le_u32(hdr+4,0xFFFFFFFFu);
+        memcpy(hdr+8,"WAVE",4);
+        memcpy(hdr+12,"fmt ",4);
+        __w_le_u32(hdr+16,(uint32_t)sizeof(fmt));
+        memcpy(hdr+20,&fmt,sizeof(fmt));
+        memcpy(hdr+20+sizeof(fmt),"data",4);
+        __w_le_u32(hdr+24+sizeof(fmt),0xFFFFFFFFu);
+
+        if (fwrite(hdr,sizeof(hdr),1,mixer_stream.fp) != 1) {
+            MIXER_StreamClose();
+            return false;
+        }
+    }
+    else {
+        mixer_stream.wav = riff_wav_writer_create();
+        if (mixer_stream.wav == NULL) return false;
+
+        if (!riff_wav_writer_open_file(mixer_stream.wav,path.c_str()) ||
+            !riff_wav_writer_set_format(mixer_stream.wav,&fmt) ||
+            !riff_wav_writer_begin_header(mixer_stream.wav) ||
+            !riff_wav_writer_begin_data(mixer_stream.wav)) {
+            mixer_stream.wav = riff_wav_writer_destroy(mixer_stream.wav);
+            return false;
+        }
+    }
+
+    /* write in blocksize chunks, like the sound device would pull them */
+    mixer_stream.buf_frames = mixer.blocksize;
+    mixer_stream.buf.reserve(((size_t)mixer.blocksize + MIXER_BUFSIZE) * 2u);
+    return true;
+}
+
+static void MIXER_StreamPut(Bitu from,const Bitu to) {
+    const int32_t volscale1 = (int32_t)(mixer.mastervol[0] * (1 << MIXER_VOLSHIFT));
+    const int32_t volscale2 = (int32_t)(mixer.mastervol[1] * (1 << MIXER_VOLSHIFT));
+
+    for (;from < to;from++) {
+        const int32_t *in = &mixer.work[from][0];
+
+        if (mixer.mute) {
+            mixer_stream.buf.push_back(0);
+            mixer_stream.buf.push_back(0);
+        }
+        else {
+            mixer_stream.buf.push_back((int16_t)MIXER_CLIP((((int64_t)in[0]) * (int64_t)volscale1) >> (MIXER_VOLSHIFT + MIXER_VOLSHIFT)));
+            mixer_stream.buf.push_back((int16_t)MIXER_CLIP((((int64_t)in[1]) * (int64_t)volscale2) >> (MIXER_VOLSHIFT + MIXER_VOLSHIFT)));
+        }
+    }
+}
+
+/* consume everything mixed so far, called from MIXER_Mix() in place of the SDL audio callback.
+ * work_wrap is only meaningful while work_out is still in the previous pass of the buffer. */
+static void MIXER_StreamOut(void) {
+    if (mixer.work_out > mixer.work_in) {
+        MIXER_StreamPut(mixer.work_out,mixer.work_wrap);
+        mixer.work_out = 0;
+    }
+    MIXER_StreamPut(mixer.work_out,mixer.work_in);
+    mixer.work_out = mixer.work_in;
+
+    if ((mixer_stream.buf.size() / 2u) >= mixer_stream.buf_frames)
+        MIXER_StreamFlush();
+}
+
 PhysPt mixer_capture_write_begin = 0;
 PhysPt mixer_capture_write_end = 0;
 uint32_t mixer_control = 0;
@@ -223,6 +390,99 @@ inline void MixerChannel::updateSlew(void) {
         max_change = 0x7FFFFFFFUL;
 }
 
+static std::vector<MixerSincTable*> mixer_sinc_tables;
+
+/* modified Bessel function of the first kind, order 0, for the Kaiser window */
+static double MIXER_SincBesselI0(const double x) {
+    double sum = 1.0,term = 1.0;
+
+    for (unsigned int k=1;k < 64;k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < (sum * 1e-12)) break;
+    }
+
+    return sum;
+}
+
+/* coefficients for resampling freq_n to freq_d, NULL if linear interpolation is selected or the rates match */
+static const MixerSincTable *MIXER_GetSincTable(const unsigned int freq_n,const unsigned int freq_d) {
+    if (mixer.sinc_taps == 0 || freq_n == freq_d)
+        return NULL;
+
+    double cutoff = mixer.sinc_cutoff;
+    unsigned int taps = mixer.sinc_taps;
+
+    if (freq_n > freq_d) {
+        /* downsampling: cut at the mixer's Nyquist frequency, which takes a proportionally longer filter */
+        const double ratio = (double)freq_d / freq_n;
+
+        cutoff *= ratio;
+        taps = ((unsigned int)ceil(taps / ratio) + 3u) & (~3u);
+        if (taps > MIXER_SINC_MAX_TAPS) taps = MIXER_SINC_MAX_TAPS;
+    }
+
+    const unsigned int key = (unsigned int)((cutoff * 1000000.0) + 0.5);
+    for (size_t i=0;i < mixer_sinc_tables.size();i++) {
+        const MixerSincTable *t = mixer_sinc_tables[i];
+        if (t->taps == taps && t->phases == mixer.sinc_phases && t->cutoff == key)
+            return t;
+    }
+
+    MixerSincTable *t = new MixerSincTable;
+    const double half = taps / 2.0;
+    const double i0beta = MIXER_SincBesselI0(mixer.sinc_beta);
+
+    t->taps = taps;
+    t->phases = mixer.sinc_phases;
+    t->cutoff = key;
+    t->coef.resize((size_t)(t->phases + 1u) * taps);
+
+    for (unsigned int p=0;p <= t->phases;p++) {
+        /* tap k is the input sample (k + 1 - taps/2 - frac) samples away from the output */
+        const double frac = (double)p / t->phases;
+        float *row = &t->coef[(size_t)p * taps];
+        double sum = 0;
+
+        for (unsigned int k=0;k < taps;k++) {
+            const double d = (double)k + 1.0 - half - frac;
+            const double u = d / half;
+            const double x = M_PI * cutoff * d;
+            double h = (fabs(x) < 1e-9) ? 1.0 : (sin(x) / x);
+
+            h *= (u > -1.0 && u < 1.0) ? (MIXER_SincBesselI0(mixer.sinc_beta * sqrt(1.0 - (u * u))) / i0beta) : 0.0;
+            row[k] = (float)h;
+            sum += h;
+        }
+
+        for (unsigned int k=0;k < taps;k++)
+            row[k] = (float)(row[k] / sum);
+    }
+
+    LOG(LOG_MISC,LOG_DEBUG)("Mixer: resampler table %u taps, %u phases, cutoff %.3f",taps,t->phases,cutoff);
+    mixer_sinc_tables.push_back(t);
+    return t;
+}
+
+/* pick the resampler table for the current rates. Slew rate limiting (SetSlewFreq() below the source
+ * rate) emulates the hardware, channels using it keep interpolating linearly. */
+void MixerChannel::sincUpdate(void) {
+    if (freq_nslew_want > 0 && freq_nslew_want < freq_n)
+        sinc = NULL;
+    else
+        sinc = MIXER_GetSincTable(freq_n,freq_d);
+
+    if (sinc != NULL) /* freq_f < freq_d, so the nearest row is at most phases */
+        sinc_phase_mul = ((uint64_t)sinc->phases << (uint64_t)32u) / (uint64_t)freq_d;
+}
+
+/* input history for the resampler, kept while the linear path is in use so switching over is seamless */
+inline void MixerChannel::sincPush(void) {
+    if (++sinc_pos >= MIXER_SINC_MAX_TAPS) sinc_pos = 0;
+    sinc_hist[0][sinc_pos] = sinc_hist[0][sinc_pos+MIXER_SINC_MAX_TAPS] = (float)current[0];
+    sinc_hist[1][sinc_pos] = sinc_hist[1][sinc_pos+MIXER_SINC_MAX_TAPS] = (float)current[1];
+}
+
 MixerChannel * MIXER_AddChannel(MIXER_Handler handler,Bitu freq,const char * name) {
     MixerChannel * chan=new MixerChannel();
     chan->freq_fslew = 0;
@@ -247,6 +507,10 @@ MixerChannel * MIXER_AddChannel(MIXER_Handler handler,Bitu freq,const char * nam
     chan->lowpass_on_out = false;
     chan->freq_d_orig = 1;
     chan->freq_f = 0;
+    chan->sinc = NULL;
+    chan->sinc_phase_mul = 0;
+    chan->sinc_pos = 0;
+    memset(chan->sinc_hist,0,sizeof(chan->sinc_hist));
     chan->SetFreq(freq);
     chan->next=mixer.channels;
     chan->SetScale(1.0);
@@ -378,6 +642,7 @@ void MixerChannel::SetLowpassFreq(Bitu _freq,unsigned int order) {
 void MixerChannel::SetSlewFreq(Bitu _freq) {
     freq_nslew_want = _freq;
     updateSlew();
+    sincUpdate();
 }
 
 void MixerChannel::SetFreq(Bitu _freq,Bitu _den) {
@@ -394,6 +659,7 @@ void MixerChannel::SetFreq(Bitu _freq,Bitu _den) {
     freq_d_orig = _den;
     updateSlew();
     lowpassUpdate();
+    sincUpdate();
 }
 
 void CAPTURE_MultiTrackAddWave(uint32_t freq, uint32_t len, int16_t * data,const char *name);
@@ -570,6 +836,9 @@ inline void MixerChannel::loadCurrentSample(Bitu &len, const Type* &data) {
     if (T_lowpass && lowpass_on_load)
         lowpassProc(current);
 
+    if (mixer.sinc_taps != 0)
+        sincPush();
+
     if (stereo) {
         delta[0] = current[0] - last[0];
         delta[1] = current[1] - last[1];
@@ -617,10 +886,37 @@ double MixerChannel::timeSinceLastSample(void) {
     return ((double)delta) / mixer.freq;
 }
 
+/* The resampler produces the sample at (taps/2 - 1 + freq_f/freq_d) input samples before the newest one,
+ * so its output is delayed by that much relative to linear interpolation. */
+inline bool MixerChannel::runSincInterpolation(const Bitu upto) {
+    const unsigned int taps = sinc->taps;
+    const unsigned int start = sinc_pos + 1u + MIXER_SINC_MAX_TAPS - taps;
+    const float *x0 = &sinc_hist[0][start];
+    const float *x1 = &sinc_hist[1][start];
+    int32_t l,r;
+
+    while (freq_f < freq_d) {
+        const unsigned int phase = (unsigned int)((((uint64_t)freq_f * sinc_phase_mul) + 0x80000000ull) >> (uint64_t)32u);
+
+        MIXER_SincDot(x0,x1,&sinc->coef[(size_t)phase * taps],taps,l,r);
+        msbuffer[msbuffer_o][0] = l * volmul[0];
+        msbuffer[msbuffer_o][1] = r * volmul[1];
+
+        freq_f += freq_n;
+        if ((++msbuffer_o) >= upto)
+            return false;
+    }
+
+    return true;
+}
+
 inline bool MixerChannel::runSampleInterpolation(const Bitu upto) {
     if (msbuffer_o >= upto)
         return false;
 
+    if (sinc != NULL)
+        return runSincInterpolation(upto);
+
     while (freq_fslew < freq_d) {
         int sample = last[0] + (int)(((int64_t)delta[0] * (int64_t)freq_fslew) / (int64_t)freq_d);
         msbuffer[msbuffer_o][0] = sample * volmul[0];
@@ -847,6 +1143,7 @@ void MIXER_MixSingle(Bitu /*val*/) {
 }
 
 static void MIXER_Mix(void) {
+    FrameTimeScope timing(FRAMETIME_MIXER);
     Bitu thr;
 
     SDL_LockAudio();
@@ -855,6 +1152,7 @@ static void MIXER_Mix(void) {
     assert((mixer.work_in+mixer.samples_per_ms.w) <= MIXER_BUFSIZE);
     MIXER_MixData((Bitu)mixer.samples_this_ms.w * (Bitu)mixer.samples_this_ms.fd);
     mixer.work_in += mixer.samples_this_ms.w;
+    if (MIXER_StreamActive()) MIXER_StreamOut();
 
     /* how many samples for the next ms? */
     mixer.samples_this_ms.w = mixer.samples_per_ms.w;
@@ -975,6 +1273,11 @@ std::string mixerinfo() {
 
 static void MIXER_Stop(Section* sec) {
     (void)sec;//UNUSED
+
+    if (MIXER_StreamActive()) {
+        MIXER_StreamFlush();
+        MIXER_StreamClose();
+    }
 }
 
 class MIXER : public Program {
@@ -1159,6 +1462,24 @@ void MIXER_Init() {
     mixer.sampleaccurate=section->Get_bool("sample accurate");
     mixer.mute=false;
 
+    {
+        std::string resampler = section->Get_string("resampler");
+
+        mixer.sinc_taps = 0;
+        if (resampler == "sinc-low") {
+            mixer.sinc_taps = 16;
+            mixer.sinc_phases = 256;
+            mixer.sinc_cutoff = 0.85;
+            mixer.sinc_beta = 6.0;
+        }
+        else if (resampler == "sinc-high") {
+            mixer.sinc_taps = 32;
+            mixer.sinc_phases = 1024;
+            mixer.sinc_cutoff = 0.92;
+            mixer.sinc_beta = 9.0;
+        }
+    }
+
     /* Initialize the internal stuff */
     mixer.prebuffer_samples=0;
     mixer.prebuffer_wait=true;
@@ -1182,7 +1503,20 @@ void MIXER_Init() {
     spec.userdata=NULL;
     spec.samples=(Uint16)mixer.blocksize;
 
-    if (mixer.nosound) {
+    std::string stream = section->Get_string("stream");
+    bool streaming = false;
+
+    if (!stream.empty()) {
+        streaming = MIXER_StreamOpen(stream);
+        if (!streaming)
+            LOG_MSG("MIXER: Can't open output stream %s, %s",stream.c_str(),mixer.nosound ? "no sound output" : "using the sound device");
+    }
+
+    if (streaming) {
+        LOG_MSG("MIXER: Sending output to %s instead of the sound device",stream == "-" ? "stdout" : stream.c_str());
+        TIMER_AddTickHandler(MIXER_Mix);
+        if (mixer.sampleaccurate) PIC_AddEvent(MIXER_MixSingle,1000.0 / mixer.freq);
+    } else if (mixer.nosound) {
         LOG(LOG_MISC,LOG_DEBUG)("MIXER:No Sound Mode Selected.");
         TIMER_AddTickHandler(MIXER_Mix);
     } else if (SDL_OpenAudio(&spec, &obtained) <0 ) {
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Polyphase windowed-sinc resampler used by the mixer channels in mixer.cpp.
+ *
+ * A table holds one row of "taps" coefficients per phase, the fractional
+ * position of the output sample between two input samples. The output is
+ * the dot product of a row with the last "taps" input samples, so every
+ * output sample costs one table lookup and two dot products (left, right).
+ * Rows are normalized for unity gain at DC. Tables depend only on the number
+ * of taps and the cutoff, channels with the same source to mixer rate ratio
+ * share them.
+ *
+ * The number of taps is always a multiple of 4, the sums are rounded to the
+ * nearest integer. x86 builds use SSE2 when available, AArch64 builds use
+ * NEON. */
+
+#ifndef DOSBOX_MIXER_SINC_H
+#define DOSBOX_MIXER_SINC_H
+
+#include <vector>
+
+#if defined(__SSE__) && !(defined(_M_AMD64) || defined(__e2k__))
+/* sse2_available is set up by CheckX86ExtensionsSupport() */
+# define MIXER_SINC_SIMD_X86 1
+# include <immintrin.h>
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+# define MIXER_SINC_SIMD_NEON 1
+# include <arm_neon.h>
+#endif
+
+struct MixerSincTable {
+	unsigned int		taps;		/* multiple of 4, at most MIXER_SINC_MAX_TAPS */
+	unsigned int		phases;
+	unsigned int		cutoff;		/* passband, millionths of the source Nyquist frequency */
+	std::vector<float>	coef;		/* phases + 1 rows of taps coefficients, row p for the position p / phases */
+};
+
+static inline void MIXER_SincDot_C(const float *x0, const float *x1, const float *h, const unsigned int taps, int32_t &l, int32_t &r) {
+	float a0 = 0, a1 = 0;
+
+	for (unsigned int i=0;i < taps;i++) {
+		a0 += x0[i] * h[i];
+		a1 += x1[i] * h[i];
+	}
+
+	l = (int32_t)(a0 + ((a0 >= 0) ? 0.5f : -0.5f));
+	r = (int32_t)(a1 + ((a1 >= 0) ? 0.5f : -0.5f));
+}
+
+#if defined(MIXER_SINC_SIMD_X86)
+#ifdef __GNUC__
+__attribute__((__target__("sse2")))
+#endif
+static inline void MIXER_SincDot_SSE2(const float *x0, const float *x1, const float *h, const unsigned int taps, int32_t &l, int32_t &r) {
+	__m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+
+	for (unsigned int i=0;i < taps;i += 4u) {
+		const __m128 c = _mm_loadu_ps(h+i);
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(x0+i), c));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(x1+i), c));
+	}
+
+	/* horizontal sums: (a0.0+a0.2, a0.1+a0.3, a1.0+a1.2, a1.1+a1.3), then the pairs */
+	const __m128 s = _mm_add_ps(_mm_movelh_ps(a0, a1), _mm_movehl_ps(a1, a0));
+	const __m128i t = _mm_cvtps_epi32(_mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2,3,0,1))));
+	l = _mm_cvtsi128_si32(t);
+	r = _mm_cvtsi128_si32(_mm_srli_si128(t, 8));
+}
+#endif
+
+#if defined(MIXER_SINC_SIMD_NEON)
+static inline void MIXER_SincDot_NEON(const float *x0, const float *x1, const float *h, const unsigned int taps, int32_t &l, int32_t &r) {
+	float32x4_t a0 = vdupq_n_f32(0), a1 = vdupq_n_f32(0);
+
+	for (unsigned int i=0;i < taps;i += 4u) {
+		const float32x4_t c = vld1q_f32(h+i);
+		a0 = vmlaq_f32(a0, vld1q_f32(x0+i), c);
+		a1 = vmlaq_f32(a1, vld1q_f32(x1+i), c);
+	}
+
+	const int32x2_t t = vcvtn_s32_f32(vpadd_f32(vpadd_f32(vget_low_f32(a0), vget_high_f32(a0)), vpadd_f32(vget_low_f32(a1), vget_high_f32(a1))));
+	l = vget_lane_s32(t, 0);
+	r = vget_lane_s32(t, 1);
+}
+#endif
+
+static inline void MIXER_SincDot(const float *x0, const float *x1, const float *h, const unsigned int taps, int32_t &l, int32_t &r) {
+#if defined(MIXER_SINC_SIMD_X86)
+	if (sse2_available) {
+		MIXER_SincDot_SSE2(x0, x1, h, taps, l, r);
+		return;
+	}
+	MIXER_SincDot_C(x0, x1, h, taps, l, r);
+#elif defined(MIXER_SINC_SIMD_NEON)
+	MIXER_SincDot_NEON(x0, x1, h, taps, l, r);
+#else
+	MIXER_SincDot_C(x0, x1, h, taps, l, r);
+#endif
+}
+
+#endif /*DOSBOX_MIXER_SINC_H*/
@@ -78,3 +78,42 @@ void ExternalFilter::reset()
   Vo = 0;
 }
 
+
+
+// ----------------------------------------------------------------------------
+// SID clocking - n cycles, one output per cycle.
+// Same result as n calls of clock(Vi[i]) each followed by output().
+// ----------------------------------------------------------------------------
+void ExternalFilter::clock_block(int n, const sound_sample* Vi,
+				 sound_sample* out)
+{
+  if (n <= 0) {
+    return;
+  }
+
+  // This is handy for testing.
+  if (!enabled) {
+    // Remove maximum DC level since there is no filter to do it.
+    for (int i = 0; i < n; i++) {
+      out[i] = Vi[i] - mixer_DC;
+    }
+    Vlp = Vhp = 0;
+    Vo = out[n - 1];
+    return;
+  }
+
+  const sound_sample w0lp_8 = w0lp >> 8;
+  sound_sample lp = Vlp, hp = Vhp;
+
+  for (int i = 0; i < n; i++) {
+    sound_sample dVlp = w0lp_8*(Vi[i] - lp) >> 12;
+    sound_sample dVhp = w0hp*(lp - hp) >> 20;
+    out[i] = lp - hp;
+    lp += dVlp;
+    hp += dVhp;
+  }
+
+  Vlp = lp;
+  Vhp = hp;
+  Vo = out[n - 1];
+}
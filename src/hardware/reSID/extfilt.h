@@ -46,6 +46,8 @@ public:
 
   RESID_INLINE void clock(sound_sample Vi);
   RESID_INLINE void clock(cycle_count delta_t, sound_sample Vi);
+  // n cycles at once, out[i] = output() after cycle i.
+  void clock_block(int n, const sound_sample* Vi, sound_sample* out);
   void reset();
 
   // Audio output (20 bits).
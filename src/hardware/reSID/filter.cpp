@@ -20,6 +20,12 @@
 #define __FILTER_CC__
 #include "filter.h"
 
+#if RESID_SIMD_SSE2
+#include <emmintrin.h>
+#elif RESID_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 // Maximum cutoff frequency is specified as
 // FCmax = 2.6e-5/C = 2.6e-5/2200e-12 = 11818.
 //
@@ -304,3 +310,151 @@ PointPlotter<sound_sample> Filter::fc_plotter()
   return PointPlotter<sound_sample>(f0);
 }
 
+
+
+// ----------------------------------------------------------------------------
+// SID clocking - n cycles, one output per cycle.
+//
+// Same result as n calls of clock(voice1[i], voice2[i], voice3[i], ext_in)
+// each followed by output(). The registers can not change within the run, so
+// the routing and mode switches are resolved once into masks. Routing the
+// voices into Vi/Vnf and the final mix are independent per cycle and use
+// SIMD; the integrators are a recurrence over cycles and stay scalar.
+// ----------------------------------------------------------------------------
+void Filter::clock_block(int n, const sound_sample* voice1,
+			 const sound_sample* voice2, const sound_sample* voice3,
+			 sound_sample ext_in, sound_sample* out)
+{
+  // Route masks, -1 routes the input into the filter, 0 around it.
+  // NB! Voice 3 is not silenced by voice3off if it is routed through
+  // the filter.
+  const sound_sample m1 = (filt & 0x01) ? -1 : 0;
+  const sound_sample m2 = (filt & 0x02) ? -1 : 0;
+  const sound_sample m3 = (filt & 0x04) ? -1 : 0;
+  const sound_sample v3on = (voice3off && !(filt & 0x04)) ? 0 : -1;
+  const sound_sample ext = ext_in >> 7;
+  const sound_sample ext_Vi = (filt & 0x08) ? ext : 0;
+  const sound_sample ext_Vnf = (filt & 0x08) ? 0 : ext;
+  const sound_sample vol_ = static_cast<sound_sample>(vol);
+
+  // With the filter disabled everything goes around it.
+  const sound_sample f1 = enabled ? m1 : 0;
+  const sound_sample f2 = enabled ? m2 : 0;
+  const sound_sample f3 = enabled ? m3 : 0;
+  const sound_sample e_Vi = enabled ? ext_Vi : 0;
+  const sound_sample e_Vnf = enabled ? ext_Vnf : ext;
+
+  // Vi is kept in out[] until the integrators replace it with Vf.
+  sound_sample Vnf_[256];
+  sound_sample* Vi_ = out;
+  int i = 0;
+
+  while (n > 0) {
+    const int run = n < 256 ? n : 256;
+
+    i = 0;
+#if RESID_SIMD_SSE2
+    {
+      const __m128i f1v = _mm_set1_epi32(f1), f2v = _mm_set1_epi32(f2);
+      const __m128i f3v = _mm_set1_epi32(f3), v3v = _mm_set1_epi32(v3on);
+      const __m128i eVi = _mm_set1_epi32(e_Vi), eVnf = _mm_set1_epi32(e_Vnf);
+      for (; i + 4 <= run; i += 4) {
+	const __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(voice1 + i)), 7);
+	const __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(voice2 + i)), 7);
+	const __m128i c = _mm_and_si128(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(voice3 + i)), 7), v3v);
+	const __m128i vi = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(a, f1v), _mm_and_si128(b, f2v)),
+					 _mm_add_epi32(_mm_and_si128(c, f3v), eVi));
+	const __m128i vnf = _mm_add_epi32(_mm_add_epi32(_mm_andnot_si128(f1v, a), _mm_andnot_si128(f2v, b)),
+					  _mm_add_epi32(_mm_andnot_si128(f3v, c), eVnf));
+	_mm_storeu_si128((__m128i*)(Vi_ + i), vi);
+	_mm_storeu_si128((__m128i*)(Vnf_ + i), vnf);
+      }
+    }
+#elif RESID_SIMD_NEON
+    {
+      const int32x4_t f1v = vdupq_n_s32(f1), f2v = vdupq_n_s32(f2);
+      const int32x4_t f3v = vdupq_n_s32(f3), v3v = vdupq_n_s32(v3on);
+      const int32x4_t eVi = vdupq_n_s32(e_Vi), eVnf = vdupq_n_s32(e_Vnf);
+      for (; i + 4 <= run; i += 4) {
+	const int32x4_t a = vshrq_n_s32(vld1q_s32(voice1 + i), 7);
+	const int32x4_t b = vshrq_n_s32(vld1q_s32(voice2 + i), 7);
+	const int32x4_t c = vandq_s32(vshrq_n_s32(vld1q_s32(voice3 + i), 7), v3v);
+	vst1q_s32(Vi_ + i, vaddq_s32(vaddq_s32(vandq_s32(a, f1v), vandq_s32(b, f2v)),
+				   vaddq_s32(vandq_s32(c, f3v), eVi)));
+	vst1q_s32(Vnf_ + i, vaddq_s32(vaddq_s32(vbicq_s32(a, f1v), vbicq_s32(b, f2v)),
+				    vaddq_s32(vbicq_s32(c, f3v), eVnf)));
+      }
+    }
+#endif
+    for (; i < run; i++) {
+      const sound_sample a = voice1[i] >> 7;
+      const sound_sample b = voice2[i] >> 7;
+      const sound_sample c = (voice3[i] >> 7) & v3on;
+      Vi_[i] = (a & f1) + (b & f2) + (c & f3) + e_Vi;
+      Vnf_[i] = (a & ~f1) + (b & ~f2) + (c & ~f3) + e_Vnf;
+    }
+
+    // Integrators, then the selected outputs summed into Vf (in place of Vi).
+    if (enabled) {
+      const sound_sample mlp = (hp_bp_lp & 0x1) ? -1 : 0;
+      const sound_sample mbp = (hp_bp_lp & 0x2) ? -1 : 0;
+      const sound_sample mhp = (hp_bp_lp & 0x4) ? -1 : 0;
+      sound_sample hp = Vhp, bp = Vbp, lp = Vlp;
+
+      for (i = 0; i < run; i++) {
+	sound_sample dVbp = (w0_ceil_1*hp >> 20);
+	sound_sample dVlp = (w0_ceil_1*bp >> 20);
+	bp -= dVbp;
+	lp -= dVlp;
+	hp = (bp*_1024_div_Q >> 10) - lp - Vi_[i];
+	Vi_[i] = (lp & mlp) + (bp & mbp) + (hp & mhp);
+      }
+      Vhp = hp;
+      Vbp = bp;
+      Vlp = lp;
+    }
+    else {
+      Vhp = Vbp = Vlp = 0;
+      for (i = 0; i < run; i++) {
+	Vi_[i] = 0;
+      }
+    }
+
+    // Sum non-filtered and filtered output, multiply with volume.
+    i = 0;
+#if RESID_SIMD_SSE2
+    {
+      // 32x32 -> low 32 bit multiply, pmulld is SSE4.1.
+      const __m128i dc = _mm_set1_epi32(mixer_DC), v = _mm_set1_epi32(vol_);
+      for (; i + 4 <= run; i += 4) {
+	const __m128i x = _mm_add_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)(Vnf_ + i)),
+						      _mm_loadu_si128((const __m128i*)(Vi_ + i))), dc);
+	const __m128i even = _mm_mul_epu32(x, v);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), v);
+	_mm_storeu_si128((__m128i*)(out + i),
+			 _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+					    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0))));
+      }
+    }
+#elif RESID_SIMD_NEON
+    {
+      const int32x4_t dc = vdupq_n_s32(mixer_DC);
+      for (; i + 4 <= run; i += 4) {
+	const int32x4_t x = vaddq_s32(vaddq_s32(vld1q_s32(Vnf_ + i), vld1q_s32(Vi_ + i)), dc);
+	vst1q_s32(out + i, vmulq_n_s32(x, vol_));
+      }
+    }
+#endif
+    for (; i < run; i++) {
+      out[i] = (Vnf_[i] + Vi_[i] + mixer_DC)*vol_;
+    }
+
+    Vnf = Vnf_[run - 1];
+    voice1 += run;
+    voice2 += run;
+    voice3 += run;
+    out += run;
+    Vi_ = out;
+    n -= run;
+  }
+}
@@ -134,6 +134,10 @@ public:
   void clock(cycle_count delta_t,
   	     sound_sample voice1, sound_sample voice2, sound_sample voice3,
 	     sound_sample ext_in);
+  // n cycles at once, out[i] = output() after cycle i.
+  void clock_block(int n, const sound_sample* voice1,
+		   const sound_sample* voice2, const sound_sample* voice3,
+		   sound_sample ext_in, sound_sample* out);
   void reset();
 
   // Write registers.
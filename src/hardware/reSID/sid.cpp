@@ -20,6 +20,12 @@
 #include "sid.h"
 #include <math.h>
 
+#if RESID_SIMD_SSE2
+#include <emmintrin.h>
+#elif RESID_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
@@ -28,6 +34,9 @@ SID2::SID2()
   // Initialize pointers.
   sample = 0;
   fir = 0;
+  cycle_out = 0;
+  cycle_out_size = 0;
+  block_clocking = false;
 
   voice[0].set_sync_source(&voice[2]);
   voice[1].set_sync_source(&voice[0]);
@@ -49,6 +58,7 @@ SID2::~SID2()
 {
   delete[] sample;
   delete[] fir;
+  delete[] cycle_out;
 }
 
 
@@ -386,6 +396,18 @@ void SID2::enable_external_filter(bool enable)
 }
 
 
+// ----------------------------------------------------------------------------
+// Enable block clocking.
+// The cycle based sampling methods (SAMPLE_INTERPOLATE and the resampling
+// methods) then clock the chip a sample period at a time with clock_block()
+// instead of calling clock() for every cycle. The output is the same.
+// ----------------------------------------------------------------------------
+void SID2::enable_block_clocking(bool enable)
+{
+  block_clocking = enable;
+}
+
+
 // ----------------------------------------------------------------------------
 // I0() computes the 0th order modified Bessel function of the first kind.
 // This function is originally from resample-1.5/filterkit.c by J. O. Smith.
@@ -471,6 +493,13 @@ bool SID2::set_sampling_parameters(double clock_freq, sampling_method method,
   cycles_per_sample =
     cycle_count(clock_freq/sample_freq*(1 << FIXP_SHIFT) + 0.5);
 
+  // Block clocking runs at most one sample period at a time.
+  if (cycle_out_size < (cycles_per_sample >> FIXP_SHIFT) + 2) {
+    delete[] cycle_out;
+    cycle_out_size = (cycles_per_sample >> FIXP_SHIFT) + 2;
+    cycle_out = new short[cycle_out_size];
+  }
+
   sample_offset = 0;
   sample_prev = 0;
 
@@ -713,6 +742,139 @@ void SID2::clock(cycle_count delta_t)
 }
 
 
+// ----------------------------------------------------------------------------
+// SID clocking - n cycles, out[i] is the 16-bit output after cycle i.
+//
+// Same result as n times clock() followed by output(). Envelopes,
+// oscillators and voice outputs are stepped per cycle into buffers, then the
+// filter and the external filter run over the whole buffer with the
+// register dependent decisions taken once (see Filter::clock_block()).
+// ----------------------------------------------------------------------------
+void SID2::clock_block(cycle_count n, short* out)
+{
+  sound_sample v1[BLOCK_CYCLES];
+  sound_sample v2[BLOCK_CYCLES];
+  sound_sample v3[BLOCK_CYCLES];
+  sound_sample vo[BLOCK_CYCLES];
+
+  if (n <= 0) {
+    return;
+  }
+
+  // Age bus value.
+  bus_value_ttl -= n;
+  if (bus_value_ttl <= 0) {
+    bus_value = 0;
+    bus_value_ttl = 0;
+  }
+
+  while (n > 0) {
+    const int run = n < BLOCK_CYCLES ? n : BLOCK_CYCLES;
+    int i;
+
+    for (i = 0; i < run; i++) {
+      voice[0].envelope.clock();
+      voice[1].envelope.clock();
+      voice[2].envelope.clock();
+
+      voice[0].wave.clock();
+      voice[1].wave.clock();
+      voice[2].wave.clock();
+
+      voice[0].wave.synchronize();
+      voice[1].wave.synchronize();
+      voice[2].wave.synchronize();
+
+      v1[i] = voice[0].output();
+      v2[i] = voice[1].output();
+      v3[i] = voice[2].output();
+    }
+
+    filter.clock_block(run, v1, v2, v3, ext_in, vo);
+    extfilt.clock_block(run, vo, vo);
+
+    // Same scaling and clipping as output().
+    const int half = 1 << 15;
+    for (i = 0; i < run; i++) {
+      int sample = vo[i]/((4095*255 >> 7)*3*15*2/(1 << 16));
+      if (sample >= half) {
+	sample = half - 1;
+      }
+      else if (sample < -half) {
+	sample = -half;
+      }
+      out[i] = short(sample);
+    }
+
+    out += run;
+    n -= run;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// Clock n cycles into the resampling ring buffer.
+// ----------------------------------------------------------------------------
+RESID_INLINE
+void SID2::clock_ring(cycle_count n)
+{
+  if (!block_clocking) {
+    for (int i = 0; i < n; i++) {
+      clock();
+      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
+      ++sample_index;
+      sample_index &= 0x3fff;
+    }
+    return;
+  }
+
+  while (n > 0) {
+    const int run = n < cycle_out_size ? n : cycle_out_size;
+    clock_block(run, cycle_out);
+    for (int i = 0; i < run; i++) {
+      sample[sample_index] = sample[sample_index + RINGSIZE] = cycle_out[i];
+      ++sample_index;
+      sample_index &= 0x3fff;
+    }
+    n -= run;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// FIR convolution, sum of a[j]*b[j].
+// ----------------------------------------------------------------------------
+static RESID_INLINE int fir_convolve(const short* a, const short* b, int n)
+{
+  int v = 0;
+  int j = 0;
+
+#if RESID_SIMD_SSE2
+  __m128i acc = _mm_setzero_si128();
+  for (; j + 8 <= n; j += 8) {
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + j)),
+					    _mm_loadu_si128((const __m128i*)(b + j))));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1,0,3,2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2,3,0,1)));
+  v = _mm_cvtsi128_si32(acc);
+#elif RESID_SIMD_NEON
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; j + 8 <= n; j += 8) {
+    const int16x8_t x = vld1q_s16(a + j), y = vld1q_s16(b + j);
+    acc = vmlal_s16(acc, vget_low_s16(x), vget_low_s16(y));
+    acc = vmlal_s16(acc, vget_high_s16(x), vget_high_s16(y));
+  }
+  v = vaddvq_s32(acc);
+#endif
+
+  for (; j < n; j++) {
+    v += a[j]*b[j];
+  }
+  return v;
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling.
 // Fixpoint arithmetics is used.
@@ -798,12 +960,21 @@ int SID2::clock_interpolate(cycle_count& delta_t, short* buf, int n,
     if (s >= n) {
       return s;
     }
-    for (i = 0; i < delta_t_sample - 1; i++) {
-      clock();
+    if (block_clocking) {
+      if (delta_t_sample > 0) {
+	short before = output();
+	clock_block(delta_t_sample, cycle_out);
+	sample_prev = delta_t_sample >= 2 ? cycle_out[delta_t_sample - 2] : before;
+      }
     }
-    if (i < delta_t_sample) {
-      sample_prev = output();
-      clock();
+    else {
+      for (i = 0; i < delta_t_sample - 1; i++) {
+	clock();
+      }
+      if (i < delta_t_sample) {
+	sample_prev = output();
+	clock();
+      }
     }
 
     delta_t -= delta_t_sample;
@@ -815,12 +986,21 @@ int SID2::clock_interpolate(cycle_count& delta_t, short* buf, int n,
     sample_prev = sample_now;
   }
 
-  for (i = 0; i < delta_t - 1; i++) {
-    clock();
+  if (block_clocking) {
+    if (delta_t > 0) {
+      short before = output();
+      clock_block(delta_t, cycle_out);
+      sample_prev = delta_t >= 2 ? cycle_out[delta_t - 2] : before;
+    }
   }
-  if (i < delta_t) {
-    sample_prev = output();
-    clock();
+  else {
+    for (i = 0; i < delta_t - 1; i++) {
+      clock();
+    }
+    if (i < delta_t) {
+      sample_prev = output();
+      clock();
+    }
   }
   sample_offset -= delta_t << FIXP_SHIFT;
   delta_t = 0;
@@ -879,12 +1059,7 @@ int SID2::clock_resample_interpolate(cycle_count& delta_t, short* buf, int n,
     if (s >= n) {
       return s;
     }
-    for (int i = 0; i < delta_t_sample; i++) {
-      clock();
-      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-      ++sample_index;
-      sample_index &= 0x3fff;
-    }
+    clock_ring(delta_t_sample);
     delta_t -= delta_t_sample;
     sample_offset = next_sample_offset & FIXP_MASK;
 
@@ -894,10 +1069,7 @@ int SID2::clock_resample_interpolate(cycle_count& delta_t, short* buf, int n,
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+    int v1 = fir_convolve(sample_start, fir_start, fir_N);
 
     // Use next FIR table, wrap around to first FIR table using
     // previous sample.
@@ -908,10 +1080,7 @@ int SID2::clock_resample_interpolate(cycle_count& delta_t, short* buf, int n,
     fir_start = fir + fir_offset*fir_N;
 
     // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v2 += sample_start[j]*fir_start[j];
-    }
+    int v2 = fir_convolve(sample_start, fir_start, fir_N);
 
     // Linear interpolation.
     // fir_offset_rmd is equal for all samples, it can thus be factorized out:
@@ -932,12 +1101,7 @@ int SID2::clock_resample_interpolate(cycle_count& delta_t, short* buf, int n,
     buf[s++*interleave] = v;
   }
 
-  for (int i = 0; i < delta_t; i++) {
-    clock();
-    sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-    ++sample_index;
-    sample_index &= 0x3fff;
-  }
+  clock_ring(delta_t);
   sample_offset -= delta_t << FIXP_SHIFT;
   delta_t = 0;
   return s;
@@ -962,12 +1126,7 @@ int SID2::clock_resample_fast(cycle_count& delta_t, short* buf, int n,
     if (s >= n) {
       return s;
     }
-    for (int i = 0; i < delta_t_sample; i++) {
-      clock();
-      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-      ++sample_index;
-      sample_index &= 0x3fff;
-    }
+    clock_ring(delta_t_sample);
     delta_t -= delta_t_sample;
     sample_offset = next_sample_offset & FIXP_MASK;
 
@@ -976,10 +1135,7 @@ int SID2::clock_resample_fast(cycle_count& delta_t, short* buf, int n,
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
-    }
+    int v = fir_convolve(sample_start, fir_start, fir_N);
 
     v >>= FIR_SHIFT;
 
@@ -995,12 +1151,7 @@ int SID2::clock_resample_fast(cycle_count& delta_t, short* buf, int n,
     buf[s++*interleave] = v;
   }
 
-  for (int i = 0; i < delta_t; i++) {
-    clock();
-    sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-    ++sample_index;
-    sample_index &= 0x3fff;
-  }
+  clock_ring(delta_t);
   sample_offset -= delta_t << FIXP_SHIFT;
   delta_t = 0;
   return s;
@@ -35,6 +35,7 @@ public:
   void set_chip_model(chip_model model);
   void enable_filter(bool enable);
   void enable_external_filter(bool enable);
+  void enable_block_clocking(bool enable);
   bool set_sampling_parameters(double clock_freq, sampling_method method,
 			       double sample_freq, double pass_freq /*= -1*/,
 			       double filter_scale /*= 0.97*/);
@@ -99,6 +100,10 @@ protected:
   RESID_INLINE int clock_resample_fast(cycle_count& delta_t, short* buf,
 				       int n, int interleave);
 
+  // Block clocking, see clock_block().
+  void clock_block(cycle_count n, short* out);
+  RESID_INLINE void clock_ring(cycle_count n);
+
   Voice voice[3];
   Filter filter;
   ExternalFilter extfilt;
@@ -149,6 +154,13 @@ protected:
 
   // FIR_RES filter tables (FIR_N*FIR_RES).
   short* fir;
+
+  // Block clocking: the cycle based sampling methods clock the chip in
+  // runs of cycles instead of one cycle at a time, same output.
+  static const int BLOCK_CYCLES = 256;
+  bool block_clocking;
+  short* cycle_out; // one sample period of cycle outputs
+  int cycle_out_size;
 };
 
 #endif // not __SID_H__
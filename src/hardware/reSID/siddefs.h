@@ -64,4 +64,13 @@ const char* resid_version_string = "0.16";//VERSION;
 #define RESID_INLINING 1
 #define RESID_INLINE inline
 
+// SIMD for the block clocking stages that work on a run of cycles at once.
+// Only where the instruction set is always there, reSID has no runtime
+// CPU detection.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define RESID_SIMD_SSE2 1
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#define RESID_SIMD_NEON 1
+#endif
+
 #endif // not __SIDDEFS_H__
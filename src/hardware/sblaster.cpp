@@ -591,6 +591,67 @@ void SB_OnEndOfDMA(void) {
     }
 }
 
+/* Plain 8-bit and 16-bit PCM is fed to the mixer straight from guest RAM, one run up to the next 4KB
+ * page or terminal count at a time, instead of copying it into sb.dma.buf first. Returns the transfer
+ * units played. Whatever is left (MMIO or unmapped pages, decrement mode, a stereo frame split across
+ * runs) goes through the DMA read and copy below. */
+static Bitu GenerateDMASound_HostPt(Bitu size) {
+    Bitu done = 0;
+
+    if (sb.dma.remain_size != 0) return 0;
+    if (sb.dma.mode == DSP_DMA_16 && !sb.dma.chan->DMA16) return 0;
+
+    while (done < size && !sb.dma.chan->masked) {
+        Bitu got;
+        const uint8_t *data = sb.dma.chan->ReadHostPt(size - done, got);
+        if (data == NULL) break;
+
+        if (sb.dma.mode == DSP_DMA_8) {
+            if (sb.dma.stereo) {
+                if (!sb.dma.sign) sb.chan->AddSamples_s8(got>>1,data);
+                else sb.chan->AddSamples_s8s(got>>1,(const int8_t*)data);
+                if (got&1) {
+                    sb.dma.remain_size=1;
+                    sb.dma.buf.b8[0]=data[got-1];
+                }
+            } else {
+                if (!sb.dma.sign) sb.chan->AddSamples_m8(got,data);
+                else sb.chan->AddSamples_m8s(got,(const int8_t*)data);
+            }
+        }
+        else {
+            /* 16-bit DMA channel: units are WORDs at an even address */
+            const int16_t *data16 = (const int16_t*)data;
+            if (sb.dma.stereo) {
+#if defined(WORDS_BIGENDIAN)
+                if (sb.dma.sign) sb.chan->AddSamples_s16_nonnative(got>>1,data16);
+                else sb.chan->AddSamples_s16u_nonnative(got>>1,(const uint16_t*)data16);
+#else
+                if (sb.dma.sign) sb.chan->AddSamples_s16(got>>1,data16);
+                else sb.chan->AddSamples_s16u(got>>1,(const uint16_t*)data16);
+#endif
+                if (got&1) {
+                    sb.dma.remain_size=1;
+                    sb.dma.buf.b16[0]=data16[got-1];
+                }
+            } else {
+#if defined(WORDS_BIGENDIAN)
+                if (sb.dma.sign) sb.chan->AddSamples_m16_nonnative(got,data16);
+                else sb.chan->AddSamples_m16u_nonnative(got,(const uint16_t*)data16);
+#else
+                if (sb.dma.sign) sb.chan->AddSamples_m16(got,data16);
+                else sb.chan->AddSamples_m16u(got,(const uint16_t*)data16);
+#endif
+            }
+        }
+
+        done += got;
+        if (sb.dma.remain_size != 0) break;
+    }
+
+    return done;
+}
+
 static void GenerateDMASound(Bitu size) {
     Bitu read=0;Bitu done=0;Bitu i=0;
 
@@ -612,6 +673,18 @@ static void GenerateDMASound(Bitu size) {
         size = DMA_BUFSIZE;
     }
 
+    /* 16-bit data over an 8-bit channel (aliased) is not WORD aligned, always copy that */
+    Bitu hostpt=0;
+    if (sb.dma.mode == DSP_DMA_8 || sb.dma.mode == DSP_DMA_16) {
+        hostpt=GenerateDMASound_HostPt(size);
+        size-=hostpt;
+        if (size == 0 || sb.dma.chan->masked) {
+            sb.dma.left-=hostpt;
+            if (!sb.dma.left) SB_OnEndOfDMA();
+            return;
+        }
+    }
+
     switch (sb.dma.mode) {
     case DSP_DMA_2:
         read=sb.dma.chan->Read(size,sb.dma.buf.b8);
@@ -713,6 +786,7 @@ static void GenerateDMASound(Bitu size) {
         sb.mode=MODE_NONE;
         return;
     }
+    read+=hostpt;
     sb.dma.left-=read;
     if (!sb.dma.left) SB_OnEndOfDMA();
 }
@@ -23,6 +23,7 @@
 #include "dosbox.h"
 #include "inout.h"
 #include "mixer.h"
+#include "mixer_queue.h"
 #include "mem.h"
 #include "setup.h"
 #include "pic.h"
@@ -70,6 +71,14 @@ static ncr8496_device device_ncr8496(machine_config(), 0, 0, SOUND_CLOCK);
 static sn76496_base_device* activeDevice = &device_ncr8496;
 #define device (*activeDevice)
 
+//Writes to the chip, applied at their sample offset by SN76496Update
+static MixerRegQueue tandy_queue;
+static Bitu tandy_rate;
+
+static void SN76496Apply(uint32_t /*reg*/,uint32_t val) {
+	device.write((uint8_t)val);
+}
+
 static void SN76496Write(Bitu /*port*/,Bitu data,Bitu /*iolen*/) {
 	tandy.last_write=PIC_Ticks;
 	if (!tandy.enabled) {
@@ -78,10 +87,12 @@ static void SN76496Write(Bitu /*port*/,Bitu data,Bitu /*iolen*/) {
 	}
 
 	// assume state change, always.
-	// this hack allows sample accurate rendering without enabling sample accurate mode in the mixer.
-	tandy.chan->FillUp();
-
-	device.write((uint8_t)data);
+	// queued with the time of the write, to render sample accurate without filling up the mixer every time.
+	if (tandy_queue.Full()) {
+		tandy.chan->FillUp();
+		tandy_queue.Flush(SN76496Apply);
+	}
+	tandy_queue.Add(0,(uint32_t)data);
 
 //	LOG_MSG("3voice write %X at time %7.3f",data,PIC_FullIndex());
 }
@@ -94,13 +105,19 @@ static void SN76496Update(Bitu length) {
 		return;
 	}
 	const Bitu MAX_SAMPLES = 2048;
-	if (length > MAX_SAMPLES)
+	if (length > MAX_SAMPLES) {
+		tandy_queue.Flush(SN76496Apply);
 		return;
+	}
 	int16_t buffer[MAX_SAMPLES];
-	int16_t* outputs = buffer;
 
 	device_sound_interface::sound_stream stream;
-	static_cast<device_sound_interface&>(device).sound_stream_update(stream, 0, &outputs, (int)length);
+	tandy_queue.Render(length, tandy_rate,
+		[&](Bitu offset, Bitu count) {
+			int16_t* outputs = buffer + offset;
+			static_cast<device_sound_interface&>(device).sound_stream_update(stream, 0, &outputs, (int)count);
+		},
+		SN76496Apply);
 	tandy.chan->AddSamples_m16(length, buffer);
 }
 
@@ -336,6 +353,8 @@ public:
 		CloseSecondDMAController();
 
 		uint32_t sample_rate = section->Get_int("tandyrate");
+		tandy_rate = sample_rate;
+		tandy_queue.Clear();
 		tandy.chan=MixerChan.Install(&SN76496Update,sample_rate,"TANDY");
 
 		WriteHandler[0].Install(0xc0,SN76496Write,IO_MB,2);
@@ -444,6 +463,7 @@ void POD_Save_Tandy_Sound( std::ostream& stream )
 	// *******************************************
 	// *******************************************
 
+    tandy_queue.Flush(SN76496Apply);
     activeDevice->SaveState(stream);
 
 	tandy.chan->SaveState(stream);
@@ -500,6 +520,7 @@ void POD_Load_Tandy_Sound( std::istream& stream )
 	// - restore static ptrs
 	tandy.chan = chan_old;
 	tandy.dac.chan = dac_chan_old;
+    tandy_queue.Clear();
     activeDevice->LoadState(stream);
 
 	tandy.chan->LoadState(stream);
@@ -241,6 +241,7 @@ bool non_cga_ignore_oddeven_engage = false;
 bool vga_ignore_extended_memory_bit = false;
 bool vga_palette_update_on_full_load = true;
 bool vga_double_buffered_line_compare = false;
+unsigned int vga_scanline_batch = 0;
 bool pc98_allow_scanline_effect = true;
 bool pc98_allow_4_display_partitions = false;
 bool pc98_graphics_hide_odd_raster_200line = false;
@@ -822,6 +823,9 @@ void VGA_Reset(Section*) {
     vga_ignore_extended_memory_bit = section->Get_bool("ignore extended memory bit");
     enable_vretrace_poll_debugging_marker = section->Get_bool("vertical retrace poll debug line");
     vga_double_buffered_line_compare = section->Get_bool("double-buffered line compare");
+    vga_scanline_batch = (unsigned int)section->Get_int("scanline batch size");
+    vga.dirty.track = section->Get_bool("lfb dirty page tracking");
+    vga.dirty.all = true;
     hack_lfb_yadjust = section->Get_int("vesa lfb base scanline adjust");
     allow_vesa_lowres_modes = section->Get_bool("allow low resolution vesa modes");
     vesa12_modes_32bpp = section->Get_bool("vesa vbe 1.2 modes are 32bpp");
@@ -71,6 +71,10 @@ void vga_write_p3d5(Bitu port,Bitu val,Bitu iolen) {
     (void)port;//UNUSED
 //	if((crtc(index)!=0xe)&&(crtc(index)!=0xf)) 
 //		LOG_MSG("CRTC w #%2x val %2x",crtc(index),val);
+	/* the cursor registers (0Ah, 0Bh, 0Eh, 0Fh) are updated all the time by text mode programs
+	 * and are applied per character cell anyway, they do not need per scanline rendering */
+	if (crtc(index) != 0x0a && crtc(index) != 0x0b && crtc(index) != 0x0e && crtc(index) != 0x0f)
+		VGA_NoteRasterWrite();
 	switch(crtc(index)) {
 	case 0x00:	/* Horizontal Total Register */
 		if (crtc(read_only)) break;
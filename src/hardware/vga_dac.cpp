@@ -87,6 +87,9 @@ static void VGA_DAC_SendColor( Bitu index, Bitu src ) {
     }
 
     RENDER_SetPal( (uint8_t)index, red, green, blue );
+
+    /* the 256-color linear modes translate through xlat32 before the renderer */
+    vga.dirty.all = true;
 }
 
 void VGA_DAC_UpdateColor( Bitu index ) {
@@ -143,6 +146,7 @@ void VGA_DAC_UpdateColorPalette() {
 void write_p3c6(Bitu port,Bitu val,Bitu iolen) {
     (void)iolen;//UNUSED
     (void)port;//UNUSED
+    VGA_NoteRasterWrite();
     if((IS_VGA_ARCH) && (vga.dac.hidac_counter>3)) {
         vga.dac.reg02=(uint8_t)val;
         vga.dac.hidac_counter=0;
@@ -257,6 +261,8 @@ void write_p3c9(Bitu port,Bitu val,Bitu iolen) {
     }
 
     if (update) {
+        VGA_NoteRasterWrite();
+
         // As seen on real hardware: 640x480 2-color is the ONLY video mode
         // where the MCGA hardware appears to latch foreground and background
         // colors from the DAC at retrace, instead of always reading through
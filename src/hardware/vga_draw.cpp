@@ -30,7 +30,9 @@
 #include "support.h"
 #include "video.h"
 #include "render.h"
+#include "frametime.h"
 #include "../gui/render_scalers.h"
+#include "vga_draw_simd.h"
 #include "vga.h"
 #include "pic.h"
 #include "menu.h"
@@ -97,6 +99,7 @@ extern unsigned int vga_display_start_hretrace;
 extern float hretrace_fx_avg_weight;
 extern bool ignore_vblank_wraparound;
 extern bool vga_double_buffered_line_compare;
+extern unsigned int vga_scanline_batch;
 extern bool pc98_crt_mode;      // see port 6Ah command 40h/41h.
 
 extern bool pc98_31khz_mode;
@@ -841,11 +844,40 @@ template <const unsigned int card,typename templine_type_t> static inline void A
     temps += 8;
 }
 
+#if defined(VGA_USE_SIMD_PLANAR)
+/* the 16 colors a planar pixel can translate to, for VGA_Planar_Xlat() */
+template <const unsigned int card,typename templine_type_t> static inline void EGA_Planar_Common_Palette(templine_type_t * const pal) {
+    for (unsigned int c=0;c < 16u;c++)
+        pal[c] = EGA_Planar_Common_Block_xlat<card,templine_type_t>((uint8_t)c);
+}
+#endif
+
 template <const unsigned int card,typename templine_type_t> static uint8_t * EGA_Planar_Common_Line(Bitu vidstart, Bitu /*line*/) {
     templine_type_t* temps = (templine_type_t*)TempLine;
     Bitu count = vga.draw.blocks + ((vga.draw.panning + 7u) >> 3u);
     Bitu i = 0;
 
+#if defined(VGA_USE_SIMD_PLANAR)
+    if (VGA_Planar_SIMD_Available()) {
+        uint32_t latches[VGA_PLANAR_SIMD_LATCHES];
+        templine_type_t pal[16];
+
+        EGA_Planar_Common_Palette<card,templine_type_t>(pal);
+        while (count > 0u) {
+            const unsigned int n = (unsigned int)((count > VGA_PLANAR_SIMD_LATCHES) ? VGA_PLANAR_SIMD_LATCHES : count);
+            for (unsigned int j=0;j < n;j++) {
+                latches[j] = *((uint32_t*)(&vga.draw.linear_base[ vidstart & vga.draw.linear_mask ]));
+                vidstart += (uintptr_t)4 << (uintptr_t)vga.config.addr_shift;
+            }
+            VGA_Planar_Xlat(temps+i,latches,n,pal);
+            count -= n;
+            i += n * 8u;
+        }
+
+        return TempLine + (vga.draw.panning*sizeof(templine_type_t));
+    }
+#endif
+
     while (count > 0u) {
         uint32_t t1,t2;
         t1 = t2 = *((uint32_t*)(&vga.draw.linear_base[ vidstart & vga.draw.linear_mask ]));
@@ -872,6 +904,27 @@ template <const unsigned int card,typename templine_type_t> static uint8_t * Alt
     templine_type_t* temps = (templine_type_t*)TempLine;
     Bitu count = vga.draw.blocks + ((vga.draw.panning + 7u) >> 3u);
 
+#if defined(VGA_USE_SIMD_PLANAR)
+    if (VGA_Planar_SIMD_Available()) {
+        uint32_t latches[VGA_PLANAR_SIMD_LATCHES];
+        templine_type_t pal[16];
+
+        EGA_Planar_Common_Palette<card,templine_type_t>(pal);
+        while (count > 0u) {
+            const unsigned int n = (unsigned int)((count > VGA_PLANAR_SIMD_LATCHES) ? VGA_PLANAR_SIMD_LATCHES : count);
+            for (unsigned int j=0;j < n;j++) {
+                const unsigned int addr = vga.draw_2[0].crtc_addr_fetch_and_advance();
+                latches[j] = *vga.draw_2[0].drawptr<uint32_t>(addr << vga.config.addr_shift);
+            }
+            VGA_Planar_Xlat(temps,latches,n,pal);
+            count -= n;
+            temps += n * 8u;
+        }
+
+        return TempLine + (vga.draw.panning*sizeof(templine_type_t));
+    }
+#endif
+
     while (count > 0u) {
         const unsigned int addr = vga.draw_2[0].crtc_addr_fetch_and_advance();
         VGA_Latch pixels(*vga.draw_2[0].drawptr<uint32_t>(addr << vga.config.addr_shift));
@@ -2361,8 +2414,169 @@ void VGA_Alt_NextScanLine(void) {
     }
 }
 
+/* Batched scanline rendering: a frame is drawn several scanlines per PIC event,
+ * behind the beam. Each scanline step still has the time its own event would
+ * have had, and an event only draws the steps whose time has come, so the last
+ * one is drawn on time and none ahead of the beam. When a register that affects
+ * the picture is written (VGA_NoteRasterWrite), VGA_BatchCatchUp() first draws
+ * the steps the beam has passed with the old value, which gives the same picture
+ * as one event per scanline. */
+bool vga_batch_frame = false;
+static pic_tickindex_t vga_batch_start = 0;     /* time of the frame's first step */
+static unsigned int vga_batch_step = 0;         /* steps drawn so far in this frame */
+static PIC_EventHandler vga_batch_handler = NULL;
+unsigned long vga_batch_frames = 0;     /* frames drawn in batched mode */
+unsigned long vga_batch_catchups = 0;   /* register writes that drew the scanlines up to the beam */
+
+static void VGA_BatchStartFrame(PIC_EventHandler handler,pic_tickindex_t delay) {
+    vga_batch_frame = vga_scanline_batch > 1 && IS_EGAVGA_ARCH;
+    if (!vga_batch_frame) return;
+
+    vga_batch_start = PIC_FullIndex() + delay;
+    vga_batch_step = 0;
+    vga_batch_handler = handler;
+    vga_batch_frames++;
+}
+
+static inline pic_tickindex_t VGA_BatchStepTime(unsigned int step) {
+    return vga_batch_start + (pic_tickindex_t)vga.draw.delay.singleline_delay * (pic_tickindex_t)step;
+}
+
+/* a step drawn, true if the next one is due as well and should be drawn in this event */
+static inline bool VGA_BatchNextLine(void) {
+    if (!vga_batch_frame) return false;
+    vga_batch_step++;
+    /* PIC events fire on whole CPU cycles, allow for that */
+    return VGA_BatchStepTime(vga_batch_step) <= PIC_FullIndex() + (pic_tickindex_t)vga.draw.delay.singleline_delay / 16;
+}
+
+/* delay of the next draw event: when the last step of the next batch is due, the
+ * batch limited so that the frame's last step is not drawn late */
+static inline pic_tickindex_t VGA_BatchNextDelay(void) {
+    if (!vga_batch_frame) return (pic_tickindex_t)vga.draw.delay.singleline_delay;
+
+    /* at most one step per scanline left (two with MCGA double scan) */
+    Bitu left = (vga.draw.lines_total - vga.draw.lines_done + 1u) / 2u;
+    if (left > vga_scanline_batch) left = vga_scanline_batch;
+    if (left == 0) left = 1;
+
+    const pic_tickindex_t delay = VGA_BatchStepTime(vga_batch_step + (unsigned int)left - 1u) - PIC_FullIndex();
+    return delay > 0 ? delay : 0;
+}
+
+void VGA_BatchCatchUp(void) {
+    if (vga.draw.lines_done >= vga.draw.lines_total) return;
+    /* the pending event is for a later step than the one in progress, nothing to draw yet */
+    if (VGA_BatchStepTime(vga_batch_step) > PIC_FullIndex()) return;
+
+    vga_batch_catchups++;
+    PIC_RemoveEvents(vga_batch_handler);
+    vga_batch_handler(0);
+}
+
+/* Dirty page tracking: in the linear SVGA modes, a scanline whose video memory
+ * pages were not written since the previous frame is passed to the renderer as
+ * NULL (unchanged, see RENDER_NULL_INPUT) without running the line handler. This
+ * is only done if the previous frame was set up the same way and the renderer
+ * has all of its lines, anything else affecting the picture sets vga.dirty.all. */
+static bool vga_dirty_frame = false;
+unsigned long vga_dirty_lines_skipped = 0;  /* scanlines not redrawn */
+unsigned long vga_dirty_lines_drawn = 0;    /* scanlines drawn in frames that could skip */
+
+static struct {
+    VGA_Line_Handler handler;
+    Bitu address,address_add,address_line_total;
+    Bitu line_length,linear_mask;
+    Bitu width,lines_total,split_line;
+} vga_dirty_last = {};
+
+static void VGA_DirtyStartFrame(void) {
+    const bool same =
+        vga_dirty_last.handler == VGA_DrawLine &&
+        vga_dirty_last.address == vga.draw.address &&
+        vga_dirty_last.address_add == vga.draw.address_add &&
+        vga_dirty_last.address_line_total == vga.draw.address_line_total &&
+        vga_dirty_last.line_length == vga.draw.line_length &&
+        vga_dirty_last.linear_mask == vga.draw.linear_mask &&
+        vga_dirty_last.width == vga.draw.width &&
+        vga_dirty_last.lines_total == vga.draw.lines_total &&
+        vga_dirty_last.split_line == vga.draw.split_line;
+
+    vga_dirty_last.handler = VGA_DrawLine;
+    vga_dirty_last.address = vga.draw.address;
+    vga_dirty_last.address_add = vga.draw.address_add;
+    vga_dirty_last.address_line_total = vga.draw.address_line_total;
+    vga_dirty_last.line_length = vga.draw.line_length;
+    vga_dirty_last.linear_mask = vga.draw.linear_mask;
+    vga_dirty_last.width = vga.draw.width;
+    vga_dirty_last.lines_total = vga.draw.lines_total;
+    vga_dirty_last.split_line = vga.draw.split_line;
+
+    vga_dirty_frame = false;
+    if (!vga.dirty.track || vga.dirty.map == NULL)
+        return;
+
+    switch (vga.mode) {
+        case M_LIN8:
+        case M_LIN15:
+        case M_LIN16:
+        case M_LIN24:
+        case M_LIN32:
+            vga_dirty_frame = same && vga.dirty.complete && !vga.dirty.all &&
+                vga.draw.mode == DRAWLINE && vga.draw.bpp != 8 && !vga_alt_new_mode &&
+                !vga_enable_hretrace_effects && !VGA_IsCaptureEnabled() && RENDER_LineSkipAllowed();
+            break;
+        default:
+            break;
+    }
+
+    /* the pages written since the last frame start, new writes go to a clear map */
+    const Bitu pages = (vga.mem.memsize >> VGA_DIRTY_SHIFT) + 1u;
+    uint8_t *t = vga.dirty.prev;
+    vga.dirty.prev = vga.dirty.map;
+    vga.dirty.map = t;
+    memset(vga.dirty.map,0,pages);
+    vga.dirty.all = false;
+}
+
+/* true if the current scanline can be skipped, see VGA_DirtyStartFrame */
+static inline bool VGA_DirtyLineUnchanged(void) {
+    /* register write during this frame, or the debug markers want to draw on the line */
+    if (vga.dirty.all || vga_page_flip_occurred || vga_3da_polled)
+        return false;
+
+    /* the line handlers read at most line_length bytes (less for 8/16/24bpp, 24bpp reads one extra byte) */
+    const Bitu start = vga.draw.address & vga.draw.linear_mask;
+    const Bitu end = start + vga.draw.line_length + 4u;
+    if (end > vga.draw.linear_mask + 1u || end > vga.mem.memsize)
+        return false;
+
+    for (Bitu p=start >> VGA_DIRTY_SHIFT;p <= ((end - 1u) >> VGA_DIRTY_SHIFT);p++) {
+        if (vga.dirty.map[p] | vga.dirty.prev[p])
+            return false;
+    }
+
+    /* lines under the hardware cursor are always drawn, the cursor pattern lives elsewhere */
+    if (svga.hardware_cursor_active && svga.hardware_cursor_active()) {
+        const unsigned int shift = (vga.mode == M_LIN32) ? 2u : ((vga.mode == M_LIN15 || vga.mode == M_LIN16) ? 1u : 0u);
+        const Bitu lineat = ((vga.draw.address-(vga.config.real_start<<2)) >> shift) / vga.draw.width;
+        if (lineat >= vga.s3.hgc.originy && lineat <= (vga.s3.hgc.originy + 63u))
+            return false;
+    }
+
+    return true;
+}
+
+/* hand a scanline to the renderer, timed as scaler work */
+static inline void VGA_RenderLine(const void *s) {
+    FrameTimeScope timing(FRAMETIME_SCALER);
+    RENDER_DrawLine(s);
+}
+
 static void VGA_DrawSingleLine(Bitu /*blah*/) {
+    FrameTimeScope timing(FRAMETIME_VGA);
     unsigned int lines = 0;
+    bool next_line = false;
     bool skiprender;
 
 again:
@@ -2441,9 +2655,13 @@ again:
                     memxor_greendotted_16bpp((uint16_t*)TempLine,(vga.draw.width>>1)*(vga.draw.bpp>>3),vga.draw.lines_done);
                 vga_3da_polled = false;
             }
-            RENDER_DrawLine(TempLine);
+            VGA_RenderLine(TempLine);
+        } else if (vga_dirty_frame && VGA_DirtyLineUnchanged()) {
+            vga_dirty_lines_skipped++;
+            VGA_RenderLine(NULL);
         } else {
             uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
+            if (vga_dirty_frame) vga_dirty_lines_drawn++;
             if (vga_page_flip_occurred) {
                 memxor(data,0xFF,vga.draw.width*(vga.draw.bpp>>3));
                 vga_page_flip_occurred = false;
@@ -2459,7 +2677,7 @@ again:
             if (VGA_IsCaptureEnabled())
                 VGA_ProcessScanline(data);
 
-            RENDER_DrawLine(data);
+            VGA_RenderLine(data);
         }
     }
 
@@ -2486,8 +2704,12 @@ again:
     }
 
     if (vga.draw.lines_done < vga.draw.lines_total) {
-        PIC_AddEvent(VGA_DrawSingleLine,(float)vga.draw.delay.singleline_delay);
+        if (VGA_BatchNextLine())
+            next_line = true;
+        else
+            PIC_AddEvent(VGA_DrawSingleLine,VGA_BatchNextDelay());
     } else {
+        vga_batch_frame = false;
         vga_mode_frames_since_time_base++;
 
         if (VGA_IsCaptureEnabled())
@@ -2520,11 +2742,20 @@ again:
     }
 
     if (IS_EGAVGA_ARCH && !vga_double_buffered_line_compare) VGA_Update_SplitLineCompare();
+
+    if (next_line) {
+        next_line = false;
+        lines = 0;
+        goto again;
+    }
 }
 
 static void VGA_DrawEGASingleLine(Bitu /*blah*/) {
+    FrameTimeScope timing(FRAMETIME_VGA);
+    bool next_line = false;
     bool skiprender;
 
+again:
     if (vga.draw.render_step == 0)
         skiprender = false;
     else
@@ -2536,7 +2767,7 @@ static void VGA_DrawEGASingleLine(Bitu /*blah*/) {
     if (!skiprender) {
         if (GCC_UNLIKELY(vga.attr.disabled)) {
             memset(TempLine, 0, sizeof(TempLine));
-            RENDER_DrawLine(TempLine);
+            VGA_RenderLine(TempLine);
         } else {
             Bitu address = vga.draw.address;
             if (machine != MCH_EGA) {
@@ -2558,7 +2789,7 @@ static void VGA_DrawEGASingleLine(Bitu /*blah*/) {
             if (VGA_IsCaptureEnabled())
                 VGA_ProcessScanline(data);
 
-            RENDER_DrawLine(data);
+            VGA_RenderLine(data);
         }
     }
 
@@ -2578,8 +2809,12 @@ static void VGA_DrawEGASingleLine(Bitu /*blah*/) {
     }
 
     if (vga.draw.lines_done < vga.draw.lines_total) {
-        PIC_AddEvent(VGA_DrawEGASingleLine,(float)vga.draw.delay.singleline_delay);
+        if (VGA_BatchNextLine())
+            next_line = true;
+        else
+            PIC_AddEvent(VGA_DrawEGASingleLine,VGA_BatchNextDelay());
     } else {
+        vga_batch_frame = false;
         vga_mode_frames_since_time_base++;
 
         if (VGA_IsCaptureEnabled())
@@ -2605,6 +2840,11 @@ static void VGA_DrawEGASingleLine(Bitu /*blah*/) {
     }
 
     if (IS_EGAVGA_ARCH && !vga_double_buffered_line_compare) VGA_Update_SplitLineCompare();
+
+    if (next_line) {
+        next_line = false;
+        goto again;
+    }
 }
 
 void VGA_SetBlinking(Bitu enabled) {
@@ -2787,6 +3027,7 @@ void VGA_CaptureWriteScanline(const uint8_t *raw) {
 bool CodePageGuestToHostUint16(uint16_t *d/*CROSS_LEN*/,const char *s/*CROSS_LEN*/);
 
 static void VGA_VerticalTimer(Bitu /*val*/) {
+    FRAMETIME_EndFrame();
     double current_time = PIC_GetCurrentEventTime();
 
     if (IS_PC98_ARCH) {
@@ -3387,9 +3628,13 @@ static void VGA_VerticalTimer(Bitu /*val*/) {
             RENDER_EndUpdate(true);
         }
         vga.draw.lines_done = 0;
-        if (vga.draw.mode==EGALINE)
-            PIC_AddEvent(VGA_DrawEGASingleLine,(float)(vga.draw.delay.htotal/4.0 + draw_skip));
-        else PIC_AddEvent(VGA_DrawSingleLine,(float)(vga.draw.delay.htotal/4.0 + draw_skip));
+        VGA_DirtyStartFrame();
+        {
+            const PIC_EventHandler handler = (vga.draw.mode==EGALINE) ? VGA_DrawEGASingleLine : VGA_DrawSingleLine;
+            const pic_tickindex_t delay = (float)(vga.draw.delay.htotal/4.0 + draw_skip);
+            VGA_BatchStartFrame(handler,delay);
+            PIC_AddEvent(handler,delay);
+        }
         break;
     }
 }
@@ -3548,6 +3793,18 @@ void VGA_ActivateHardwareCursor(void) {
 }
 
 void VGA_SetupDrawing(Bitu /*val*/) {
+    if (vga_batch_frames != 0) {
+        LOG(LOG_VGAMISC,LOG_NORMAL)("Scanline batching since last mode setup: %lu frames batched, %lu register writes drew up to the beam",
+            vga_batch_frames,vga_batch_catchups);
+        vga_batch_frames = vga_batch_catchups = 0;
+    }
+    if (vga_dirty_lines_skipped != 0 || vga_dirty_lines_drawn != 0) {
+        LOG(LOG_VGAMISC,LOG_NORMAL)("Dirty page tracking since last mode setup: %lu scanlines unchanged, %lu drawn",
+            vga_dirty_lines_skipped,vga_dirty_lines_drawn);
+        vga_dirty_lines_skipped = vga_dirty_lines_drawn = 0;
+    }
+    vga.dirty.all = true;
+
     if (vga.mode==M_ERROR) {
         PIC_RemoveEvents(VGA_VerticalTimer);
         PIC_RemoveEvents(VGA_PanningLatch);
@@ -4619,6 +4876,7 @@ void VGA_SetupDrawing(Bitu /*val*/) {
 void VGA_KillDrawing(void) {
     PIC_RemoveEvents(VGA_DrawSingleLine);
     PIC_RemoveEvents(VGA_DrawEGASingleLine);
+    vga_batch_frame = false;
 }
 
 void VGA_SetOverride(bool vga_override) {
@@ -0,0 +1,282 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* SIMD planar to chunky conversion for the EGA/VGA 16-color line handlers
+ * in vga_draw.cpp.
+ *
+ * The line handler gathers one latch (4 planes x 8 pixels) per character
+ * clock into a small array, VGA_Planar_Xlat8/32() then expand the planes
+ * into 4-bit pixel values and translate them through a 16 entry table
+ * (attribute palette for EGA, vga.dac.xlat32 for VGA).
+ *
+ * x86 builds expand with SSE2 or AVX2 and translate with AVX2 (pshufb) when
+ * available, AArch64 builds use NEON for both. The byte tables used for the
+ * 32bpp lookup assume a little endian host. */
+
+#ifndef DOSBOX_VGA_DRAW_SIMD_H
+#define DOSBOX_VGA_DRAW_SIMD_H
+
+#if defined(__SSE__) && !(defined(_M_AMD64) || defined(__e2k__))
+/* sse2_available/avx2_available are set up by CheckX86ExtensionsSupport() */
+# define VGA_USE_SIMD_PLANAR 1
+# define VGA_PLANAR_SIMD_X86 1
+# include <immintrin.h>
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+# define VGA_USE_SIMD_PLANAR 1
+# define VGA_PLANAR_SIMD_NEON 1
+# include <arm_neon.h>
+#endif
+
+#if defined(VGA_USE_SIMD_PLANAR)
+
+/* latches converted per call, the line handlers loop for longer lines */
+#define VGA_PLANAR_SIMD_LATCHES		64
+
+static inline bool VGA_Planar_SIMD_Available(void) {
+#if defined(VGA_PLANAR_SIMD_X86)
+	return sse2_available;
+#else
+	return true;
+#endif
+}
+
+/* one latch, plane n supplies bit n of each pixel, leftmost pixel in bit 7 */
+static inline void VGA_Planar_Expand1(uint8_t *idx, const uint32_t latch) {
+	const uint8_t *p = (const uint8_t*)(&latch);
+	for (unsigned int k=0;k < 8;k++) {
+		const unsigned int s = 7u - k;
+		idx[k] = (uint8_t)(((p[0u] >> s) & 1u) | (((p[1u] >> s) & 1u) << 1u) |
+			(((p[2u] >> s) & 1u) << 2u) | (((p[3u] >> s) & 1u) << 3u));
+	}
+}
+
+#if defined(VGA_PLANAR_SIMD_X86)
+#ifdef __GNUC__
+__attribute__((__target__("sse2")))
+#endif
+static inline void VGA_Planar_Expand_SSE2(uint8_t *idx, const uint32_t *latch, unsigned int count) {
+	/* bit tested for each pixel of a latch, pixel 0 is the MSB */
+	const __m128i bits = _mm_set_epi32(0x01020408, 0x10204080, 0x01020408, 0x10204080);
+	unsigned int i = 0;
+
+	for (;(i+2u) <= count;i += 2u) {
+		/* two latches, bytes p0 p1 p2 p3 q0 q1 q2 q3 */
+		const __m128i x = _mm_loadl_epi64((const __m128i*)(latch+i));
+		const __m128i a = _mm_unpacklo_epi8(x, x);
+		const __m128i p = _mm_unpacklo_epi16(a, a);		/* p0 x4 .. p3 x4 */
+		const __m128i q = _mm_unpackhi_epi16(a, a);		/* q0 x4 .. q3 x4 */
+		const __m128i p01 = _mm_unpacklo_epi32(p, p), p23 = _mm_unpackhi_epi32(p, p);
+		const __m128i q01 = _mm_unpacklo_epi32(q, q), q23 = _mm_unpackhi_epi32(q, q);
+		const __m128i pl0 = _mm_unpacklo_epi64(p01, q01);	/* p0 x8, q0 x8 */
+		const __m128i pl1 = _mm_unpackhi_epi64(p01, q01);
+		const __m128i pl2 = _mm_unpacklo_epi64(p23, q23);
+		const __m128i pl3 = _mm_unpackhi_epi64(p23, q23);
+		__m128i r;
+
+		r =                 _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(pl0, bits), bits), _mm_set1_epi8(1));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(pl1, bits), bits), _mm_set1_epi8(2)));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(pl2, bits), bits), _mm_set1_epi8(4)));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(pl3, bits), bits), _mm_set1_epi8(8)));
+		_mm_storeu_si128((__m128i*)(idx+(i*8u)), r);
+	}
+	for (;i < count;i++)
+		VGA_Planar_Expand1(idx+(i*8u), latch[i]);
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static inline void VGA_Planar_Expand_AVX2(uint8_t *idx, const uint32_t *latch, unsigned int count) {
+	const __m256i bits = _mm256_set_epi32(0x01020408, 0x10204080, 0x01020408, 0x10204080,
+		0x01020408, 0x10204080, 0x01020408, 0x10204080);
+	/* byte of plane 0 of latches 0-1 in the low lane, 2-3 in the high lane */
+	const __m256i sel = _mm256_set_epi32(0x0C0C0C0C, 0x0C0C0C0C, 0x08080808, 0x08080808,
+		0x04040404, 0x04040404, 0x00000000, 0x00000000);
+	unsigned int i = 0;
+
+	for (;(i+4u) <= count;i += 4u) {
+		const __m256i x = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(latch+i)));
+		__m256i r = _mm256_setzero_si256();
+
+		for (unsigned int p=0;p < 4u;p++) {
+			const __m256i pl = _mm256_shuffle_epi8(x, _mm256_add_epi8(sel, _mm256_set1_epi8((char)p)));
+			r = _mm256_or_si256(r, _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(pl, bits), bits),
+				_mm256_set1_epi8((char)(1u << p))));
+		}
+		_mm256_storeu_si256((__m256i*)(idx+(i*8u)), r);
+	}
+	for (;i < count;i++)
+		VGA_Planar_Expand1(idx+(i*8u), latch[i]);
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static inline void VGA_Planar_Lookup8_AVX2(uint8_t *dst, const uint8_t *idx, unsigned int n, const uint8_t *pal) {
+	const __m256i t = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pal));
+	unsigned int i = 0;
+
+	for (;(i+32u) <= n;i += 32u)
+		_mm256_storeu_si256((__m256i*)(dst+i), _mm256_shuffle_epi8(t, _mm256_loadu_si256((const __m256i*)(idx+i))));
+	for (;i < n;i++)
+		dst[i] = pal[idx[i]];
+}
+
+#ifdef __GNUC__
+__attribute__((__target__("avx2")))
+#endif
+static inline void VGA_Planar_Lookup32_AVX2(uint32_t *dst, const uint8_t *idx, unsigned int n, const uint32_t *pal) {
+	/* byte k of each palette entry, looked up separately and interleaved back */
+	uint8_t tb[4][16];
+	for (unsigned int c=0;c < 16u;c++) {
+		tb[0][c] = (uint8_t)(pal[c]);
+		tb[1][c] = (uint8_t)(pal[c] >> 8u);
+		tb[2][c] = (uint8_t)(pal[c] >> 16u);
+		tb[3][c] = (uint8_t)(pal[c] >> 24u);
+	}
+	const __m256i t0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tb[0]));
+	const __m256i t1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tb[1]));
+	const __m256i t2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tb[2]));
+	const __m256i t3 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tb[3]));
+	unsigned int i = 0;
+
+	for (;(i+32u) <= n;i += 32u) {
+		const __m256i x = _mm256_loadu_si256((const __m256i*)(idx+i));
+		const __m256i b0 = _mm256_shuffle_epi8(t0, x), b1 = _mm256_shuffle_epi8(t1, x);
+		const __m256i b2 = _mm256_shuffle_epi8(t2, x), b3 = _mm256_shuffle_epi8(t3, x);
+		const __m256i lo01 = _mm256_unpacklo_epi8(b0, b1), hi01 = _mm256_unpackhi_epi8(b0, b1);
+		const __m256i lo23 = _mm256_unpacklo_epi8(b2, b3), hi23 = _mm256_unpackhi_epi8(b2, b3);
+		/* pixels 0-3/16-19, 4-7/20-23, 8-11/24-27, 12-15/28-31 */
+		const __m256i o0 = _mm256_unpacklo_epi16(lo01, lo23), o1 = _mm256_unpackhi_epi16(lo01, lo23);
+		const __m256i o2 = _mm256_unpacklo_epi16(hi01, hi23), o3 = _mm256_unpackhi_epi16(hi01, hi23);
+		_mm256_storeu_si256((__m256i*)(dst+i+ 0u), _mm256_permute2x128_si256(o0, o1, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst+i+ 8u), _mm256_permute2x128_si256(o2, o3, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst+i+16u), _mm256_permute2x128_si256(o0, o1, 0x31));
+		_mm256_storeu_si256((__m256i*)(dst+i+24u), _mm256_permute2x128_si256(o2, o3, 0x31));
+	}
+	for (;i < n;i++)
+		dst[i] = pal[idx[i]];
+}
+#endif //VGA_PLANAR_SIMD_X86
+
+#if defined(VGA_PLANAR_SIMD_NEON)
+static inline void VGA_Planar_Expand_NEON(uint8_t *idx, const uint32_t *latch, unsigned int count) {
+	static const uint8_t bitv[16] = { 0x80,0x40,0x20,0x10,0x08,0x04,0x02,0x01, 0x80,0x40,0x20,0x10,0x08,0x04,0x02,0x01 };
+	const uint8x16_t bits = vld1q_u8(bitv);
+	unsigned int i = 0;
+
+	for (;(i+2u) <= count;i += 2u) {
+		const uint8_t *b = (const uint8_t*)(latch+i);
+		uint8x16_t r;
+
+		r =           vandq_u8(vtstq_u8(vcombine_u8(vdup_n_u8(b[0]), vdup_n_u8(b[4])), bits), vdupq_n_u8(1));
+		r = vorrq_u8(r, vandq_u8(vtstq_u8(vcombine_u8(vdup_n_u8(b[1]), vdup_n_u8(b[5])), bits), vdupq_n_u8(2)));
+		r = vorrq_u8(r, vandq_u8(vtstq_u8(vcombine_u8(vdup_n_u8(b[2]), vdup_n_u8(b[6])), bits), vdupq_n_u8(4)));
+		r = vorrq_u8(r, vandq_u8(vtstq_u8(vcombine_u8(vdup_n_u8(b[3]), vdup_n_u8(b[7])), bits), vdupq_n_u8(8)));
+		vst1q_u8(idx+(i*8u), r);
+	}
+	for (;i < count;i++)
+		VGA_Planar_Expand1(idx+(i*8u), latch[i]);
+}
+
+static inline void VGA_Planar_Lookup8_NEON(uint8_t *dst, const uint8_t *idx, unsigned int n, const uint8_t *pal) {
+	const uint8x16_t t = vld1q_u8(pal);
+	unsigned int i = 0;
+
+	for (;(i+16u) <= n;i += 16u)
+		vst1q_u8(dst+i, vqtbl1q_u8(t, vld1q_u8(idx+i)));
+	for (;i < n;i++)
+		dst[i] = pal[idx[i]];
+}
+
+static inline void VGA_Planar_Lookup32_NEON(uint32_t *dst, const uint8_t *idx, unsigned int n, const uint32_t *pal) {
+	/* byte k of each palette entry, vst4 interleaves them back into pixels */
+	uint8_t tb[4][16];
+	for (unsigned int c=0;c < 16u;c++) {
+		tb[0][c] = (uint8_t)(pal[c]);
+		tb[1][c] = (uint8_t)(pal[c] >> 8u);
+		tb[2][c] = (uint8_t)(pal[c] >> 16u);
+		tb[3][c] = (uint8_t)(pal[c] >> 24u);
+	}
+	const uint8x16_t t0 = vld1q_u8(tb[0]), t1 = vld1q_u8(tb[1]);
+	const uint8x16_t t2 = vld1q_u8(tb[2]), t3 = vld1q_u8(tb[3]);
+	unsigned int i = 0;
+
+	for (;(i+16u) <= n;i += 16u) {
+		const uint8x16_t x = vld1q_u8(idx+i);
+		uint8x16x4_t o;
+		o.val[0] = vqtbl1q_u8(t0, x);
+		o.val[1] = vqtbl1q_u8(t1, x);
+		o.val[2] = vqtbl1q_u8(t2, x);
+		o.val[3] = vqtbl1q_u8(t3, x);
+		vst4q_u8((uint8_t*)(dst+i), o);
+	}
+	for (;i < n;i++)
+		dst[i] = pal[idx[i]];
+}
+#endif //VGA_PLANAR_SIMD_NEON
+
+static inline void VGA_Planar_Expand(uint8_t *idx, const uint32_t *latch, unsigned int count) {
+#if defined(VGA_PLANAR_SIMD_X86)
+	if (avx2_available)
+		VGA_Planar_Expand_AVX2(idx, latch, count);
+	else
+		VGA_Planar_Expand_SSE2(idx, latch, count);
+#else
+	VGA_Planar_Expand_NEON(idx, latch, count);
+#endif
+}
+
+/* Convert count (at most VGA_PLANAR_SIMD_LATCHES) latches to count*8 pixels */
+static inline void VGA_Planar_Xlat(uint8_t *dst, const uint32_t *latch, unsigned int count, const uint8_t *pal) {
+	uint8_t idx[VGA_PLANAR_SIMD_LATCHES*8u];
+	const unsigned int n = count * 8u;
+
+	VGA_Planar_Expand(idx, latch, count);
+#if defined(VGA_PLANAR_SIMD_X86)
+	if (avx2_available) {
+		VGA_Planar_Lookup8_AVX2(dst, idx, n, pal);
+		return;
+	}
+	for (unsigned int i=0;i < n;i++)
+		dst[i] = pal[idx[i]];
+#else
+	VGA_Planar_Lookup8_NEON(dst, idx, n, pal);
+#endif
+}
+
+static inline void VGA_Planar_Xlat(uint32_t *dst, const uint32_t *latch, unsigned int count, const uint32_t *pal) {
+	uint8_t idx[VGA_PLANAR_SIMD_LATCHES*8u];
+	const unsigned int n = count * 8u;
+
+	VGA_Planar_Expand(idx, latch, count);
+#if defined(VGA_PLANAR_SIMD_X86)
+	if (avx2_available) {
+		VGA_Planar_Lookup32_AVX2(dst, idx, n, pal);
+		return;
+	}
+	for (unsigned int i=0;i < n;i++)
+		dst[i] = pal[idx[i]];
+#else
+	VGA_Planar_Lookup32_NEON(dst, idx, n, pal);
+#endif
+}
+
+#endif //VGA_USE_SIMD_PLANAR
+
+#endif //DOSBOX_VGA_DRAW_SIMD_H
@@ -1862,6 +1862,57 @@ public:
 	}
 };
 
+/* Dirty page tracking versions of the banked and LFB handlers. Reads still go
+ * straight to video memory, writes go through the handler to mark the page. */
+class VGA_Changes_Handler : public PageHandler {
+public:
+	VGA_Changes_Handler() : PageHandler(PFLAG_READABLE|PFLAG_NOCODE) {}
+	HostPt GetHostReadPt(Bitu phys_page) {
+ 		phys_page-=vgapages.base;
+		return &vga.mem.linear[CHECKED3(vga.svga.bank_read_full+phys_page*4096)];
+	}
+	static INLINE Bitu offset(PhysPt addr) {
+		const Bitu phys = PAGING_GetPhysicalAddress(addr);
+		const Bitu off = CHECKED3(vga.svga.bank_write_full+((phys >> 12u)-vgapages.base)*4096) + (phys & 0xfffu);
+		VGA_MarkDirty(off);
+		return off;
+	}
+	void writeb(PhysPt addr,uint8_t val) {
+		hostWrite<uint8_t>(&vga.mem.linear[offset(addr)],val);
+	}
+	void writew(PhysPt addr,uint16_t val) {
+		hostWrite<uint16_t>(&vga.mem.linear[offset(addr)],val);
+	}
+	void writed(PhysPt addr,uint32_t val) {
+		hostWrite<uint32_t>(&vga.mem.linear[offset(addr)],val);
+	}
+};
+
+class VGA_LFBChanges_Handler : public PageHandler {
+public:
+	VGA_LFBChanges_Handler() : PageHandler(PFLAG_READABLE|PFLAG_NOCODE) {}
+	HostPt GetHostReadPt( Bitu phys_page ) {
+		phys_page -= vga.lfb.page;
+		phys_page &= (vga.mem.memsize >> 12) - 1;
+		return &vga.mem.linear[CHECKED3(phys_page * 4096)];
+	}
+	static INLINE Bitu offset(PhysPt addr) {
+		const Bitu phys = PAGING_GetPhysicalAddress(addr);
+		const Bitu off = CHECKED3((((phys >> 12u) - vga.lfb.page) & ((vga.mem.memsize >> 12) - 1)) * 4096) + (phys & 0xfffu);
+		VGA_MarkDirty(off);
+		return off;
+	}
+	void writeb(PhysPt addr,uint8_t val) {
+		hostWrite<uint8_t>(&vga.mem.linear[offset(addr)],val);
+	}
+	void writew(PhysPt addr,uint16_t val) {
+		hostWrite<uint16_t>(&vga.mem.linear[offset(addr)],val);
+	}
+	void writed(PhysPt addr,uint32_t val) {
+		hostWrite<uint32_t>(&vga.mem.linear[offset(addr)],val);
+	}
+};
+
 extern void XGA_Write(Bitu port, Bitu val, Bitu len);
 extern Bitu XGA_Read(Bitu port, Bitu len);
 
@@ -2161,6 +2212,8 @@ static struct vg {
 	VGA_HERC_Handler			herc;
 //	VGA_LIN4_Handler			lin4;
 	VGA_LFB_Handler				lfb;
+	VGA_Changes_Handler			changes;
+	VGA_LFBChanges_Handler		lfbchanges;
 	VGA_MMIO_Handler			mmio;
 	VGA_AMS_Handler				ams;
     VGA_PC98_PageHandler        pc98;
@@ -2185,6 +2238,7 @@ void VGA_SetupHandlers(void) {
 	vga.svga.bank_write_full = vga.svga.bank_write*vga.svga.bank_size;
 
 	PageHandler *newHandler;
+	vga.dirty.complete = false;
 	switch (machine) {
 	case MCH_CGA:
 		if (enableCGASnow && (vga.mode == M_TEXT || vga.mode == M_TANDY_TEXT))
@@ -2313,6 +2367,8 @@ void VGA_SetupHandlers(void) {
 	case M_LIN16:
 	case M_LIN24:
 	case M_LIN32:
+		newHandler = vga.dirty.track ? (PageHandler*)(&vgaph.changes) : (PageHandler*)(&vgaph.map);
+		break;
     case M_PACKED4:
 		newHandler = &vgaph.map;
 		break;
@@ -2340,7 +2396,10 @@ void VGA_SetupHandlers(void) {
             else {
                 /* this is needed for SVGA modes (Paradise, Tseng, S3) because SVGA
                  * modes do NOT use the chain4 configuration */
-                newHandler = &vgaph.map;
+                if (vga.mode == M_LIN8 && vga.dirty.track)
+                    newHandler = &vgaph.changes;
+                else
+                    newHandler = &vgaph.map;
             }
         } else {
             newHandler = &vgaph.uvga;
@@ -2390,6 +2449,9 @@ void VGA_SetupHandlers(void) {
 	if(svgaCard == SVGA_S3Trio && (vga.s3.ext_mem_ctrl & 0x10))
 		MEM_SetPageHandler(VGA_PAGE_A0, 16, &vgaph.mmio);
 
+	/* every way the CPU can write video memory in this mode marks the page written */
+	vga.dirty.complete = (newHandler == &vgaph.changes);
+
     non_cga_ignore_oddeven_engage = (non_cga_ignore_oddeven && !(vga.mode == M_TEXT || vga.mode == M_CGA2 || vga.mode == M_CGA4));
 
 range_done:
@@ -2437,7 +2499,10 @@ void VGA_StartUpdateLFB(void) {
 	else {
 		vga.lfb.page = (unsigned int)vga.s3.la_window << 4u;
 		vga.lfb.addr = (unsigned int)vga.s3.la_window << 16u;
-		vga.lfb.handler = &vgaph.lfb;
+		if (vga.dirty.track)
+			vga.lfb.handler = &vgaph.lfbchanges;
+		else
+			vga.lfb.handler = &vgaph.lfb;
 		MEM_SetLFB((unsigned int)vga.s3.la_window << 4u,(unsigned int)vga.mem.memsize/4096u, vga.lfb.handler, &vgaph.mmio);
 	}
 }
@@ -2453,6 +2518,14 @@ static void VGA_Memory_ShutDown(Section * /*sec*/) {
 		vga.mem.linear_orgptr = NULL;
 		vga.mem.linear = NULL;
 	}
+	if (vga.dirty.map != NULL) {
+		delete[] vga.dirty.map;
+		vga.dirty.map = NULL;
+	}
+	if (vga.dirty.prev != NULL) {
+		delete[] vga.dirty.prev;
+		vga.dirty.prev = NULL;
+	}
 }
 
 void VGA_SetupMemory() {
@@ -2466,6 +2539,13 @@ void VGA_SetupMemory() {
         memset(vga.mem.linear_orgptr,0,vga.mem.memsize+32u);
         vga.mem.linear=(uint8_t*)(((uintptr_t)vga.mem.linear_orgptr + 16ull-1ull) & ~(16ull-1ull));
 
+        /* dirty page maps, one byte per 4KB page */
+        vga.dirty.map = new uint8_t[(vga.mem.memsize >> VGA_DIRTY_SHIFT) + 1u];
+        vga.dirty.prev = new uint8_t[(vga.mem.memsize >> VGA_DIRTY_SHIFT) + 1u];
+        memset(vga.dirty.map,0,(vga.mem.memsize >> VGA_DIRTY_SHIFT) + 1u);
+        memset(vga.dirty.prev,0,(vga.mem.memsize >> VGA_DIRTY_SHIFT) + 1u);
+        vga.dirty.all = true;
+
         /* HACK. try to avoid stale pointers */
 	    vga.draw.linear_base = vga.mem.linear;
         vga.tandy.draw_base = vga.mem.linear;
@@ -2522,6 +2602,8 @@ void *VGA_PageHandler_Func[16] =
 	//(void *) &vgaph.lfbchanges,
 	(void *) &vgaph.mmio,
 	(void *) &vgaph.empty,
+	(void *) &vgaph.changes,
+	(void *) &vgaph.lfbchanges,
 };
 
 void POD_Save_VGA_Memory( std::ostream& stream )
@@ -2556,6 +2638,7 @@ void POD_Load_VGA_Memory( std::istream& stream )
 
 	// - pure data
 	READ_POD_SIZE( vga.mem.linear, sizeof(uint8_t) * vga.mem.memsize);
+	vga.dirty.all = true;
 
 	//***************************************************
 	//***************************************************
@@ -23,6 +23,7 @@
 #include "vga.h"
 #include <math.h>
 #include <stdio.h>
+#include <algorithm>
 #include "callback.h"
 #include "cpu.h"		// for 0x3da delay
 
@@ -141,6 +142,10 @@ void XGA_DrawPoint(Bitu x, Bitu y, Bitu c) {
 	/* Need to zero out all unused bits in modes that have any (15-bit or "32"-bit -- the last
 	   one is actually 24-bit. Without this step there may be some graphics corruption (mainly,
 	   during windows dragging. */
+	if (vga.dirty.track) {
+		const Bitu bytes = (XGA_COLOR_MODE == M_LIN8) ? 1 : ((XGA_COLOR_MODE == M_LIN32) ? 4 : 2);
+		if (memaddr*bytes < vga.mem.memsize) VGA_MarkDirty(memaddr*bytes);
+	}
 	switch(XGA_COLOR_MODE) {
 		case M_LIN8:
 			if (GCC_UNLIKELY(memaddr >= vga.mem.memsize)) break;
@@ -243,6 +248,256 @@ Bitu XGA_GetMixResult(Bitu mixmode, Bitu srcval, Bitu dstdata) {
 	return destval;
 }
 
+/* Span based rectangle operations.
+ *
+ * XGA_DrawRectangle, XGA_BlitRect and XGA_DrawPattern go through
+ * XGA_GetPoint/XGA_DrawPoint per pixel, checking the command, scissors,
+ * color mode and memory size each time. When the whole operation can be
+ * checked up front (known color mode, no PIX_TRANS data, source within video
+ * memory) the rectangle is clipped once and every row is done as a span with
+ * the color mode and mix as template parameters. Pixels are still processed
+ * in the order the per-pixel loop would, so overlapping blits smear exactly
+ * the same way; straight copies use memmove when the direction allows it. */
+template <unsigned int mix> static inline uint32_t XGA_Mix(const uint32_t src, const uint32_t dst) {
+	switch (mix) {
+		case 0x00: return ~dst;
+		case 0x01: return 0;
+		case 0x02: return 0xffffffff;
+		case 0x03: return dst;
+		case 0x04: return ~src;
+		case 0x05: return src ^ dst;
+		case 0x06: return ~(src ^ dst);
+		case 0x07: return src;
+		case 0x08: return ~(src & dst);
+		case 0x09: return (~src) | dst;
+		case 0x0a: return src | (~dst);
+		case 0x0b: return src | dst;
+		case 0x0c: return src & dst;
+		case 0x0d: return src & (~dst);
+		case 0x0e: return (~src) & dst;
+		default:   return ~(src | dst);
+	}
+}
+
+#define XGA_SPAN_MIXES(X) \
+	X(0x00) X(0x01) X(0x02) X(0x03) X(0x04) X(0x05) X(0x06) X(0x07) \
+	X(0x08) X(0x09) X(0x0a) X(0x0b) X(0x0c) X(0x0d) X(0x0e) X(0x0f)
+
+/* dst[0..n-1] = mix(src, dst), no dependencies between pixels */
+template <typename T,uint32_t mask,unsigned int mix> static void XGA_FillSpan(T *dst, const Bitu n, const uint32_t src) {
+	for (Bitu i=0;i < n;i++)
+		dst[i] = (T)(XGA_Mix<mix>(src, dst[i]) & mask);
+}
+
+/* dst[i] = mix(src[i], dst[i]), ascending if dx > 0 else descending */
+template <typename T,uint32_t mask,unsigned int mix> static void XGA_BlitSpan(T *dst, const T *src, const Bitu n, const Bits dx) {
+	if (mix == 0x07 && mask == (T)~((T)0)) {
+		const Bits dist = (Bits)(src - dst);
+		if ((dist >= 0 && (dx > 0 || dist >= (Bits)n)) || (dist <= 0 && (dx < 0 || -dist >= (Bits)n))) {
+			memmove(dst, src, n * sizeof(T));
+			return;
+		}
+	}
+	if (dx > 0) {
+		for (Bitu i=0;i < n;i++)
+			dst[i] = (T)(XGA_Mix<mix>(src[i], dst[i]) & mask);
+	}
+	else {
+		for (Bitu i=n;i-- > 0;)
+			dst[i] = (T)(XGA_Mix<mix>(src[i], dst[i]) & mask);
+	}
+}
+
+/* dst[i] = mix(pat[(x0+i) & 7], dst[i]), ascending if dx > 0 else descending */
+template <typename T,uint32_t mask,unsigned int mix> static void XGA_PatternSpan(T *dst, const T *pat, const Bitu x0, const Bitu n, const Bits dx) {
+	if (dx > 0) {
+		for (Bitu i=0;i < n;i++)
+			dst[i] = (T)(XGA_Mix<mix>(pat[(x0+i) & 7], dst[i]) & mask);
+	}
+	else {
+		for (Bitu i=n;i-- > 0;)
+			dst[i] = (T)(XGA_Mix<mix>(pat[(x0+i) & 7], dst[i]) & mask);
+	}
+}
+
+/* the accelerator writes video memory directly, let the dirty page tracking know */
+template <typename T> static inline void XGA_SpanDirty(const T *dst, const Bitu n) {
+	if (vga.dirty.track && n != 0)
+		VGA_MarkDirtyRange((Bitu)((const uint8_t*)dst - vga.mem.linear), n * sizeof(T));
+}
+
+template <typename T,uint32_t mask> static void XGA_FillSpanMix(T *dst, const Bitu n, const unsigned int mix, const uint32_t src) {
+	XGA_SpanDirty(dst, n);
+	switch (mix & 0xf) {
+#define X(m) case m: XGA_FillSpan<T,mask,m>(dst, n, src); break;
+		XGA_SPAN_MIXES(X)
+#undef X
+	}
+}
+
+template <typename T,uint32_t mask> static void XGA_BlitSpanMix(T *dst, const T *src, const Bitu n, const Bits dx, const unsigned int mix) {
+	XGA_SpanDirty(dst, n);
+	switch (mix & 0xf) {
+#define X(m) case m: XGA_BlitSpan<T,mask,m>(dst, src, n, dx); break;
+		XGA_SPAN_MIXES(X)
+#undef X
+	}
+}
+
+template <typename T,uint32_t mask> static void XGA_PatternSpanMix(T *dst, const T *pat, const Bitu x0, const Bitu n, const Bits dx, const unsigned int mix) {
+	XGA_SpanDirty(dst, n);
+	switch (mix & 0xf) {
+#define X(m) case m: XGA_PatternSpan<T,mask,m>(dst, pat, x0, n, dx); break;
+		XGA_SPAN_MIXES(X)
+#undef X
+	}
+}
+
+/* source value for a mix, -1 if it comes from PIX_TRANS (not handled by the spans) */
+static inline int64_t XGA_SpanMixSource(const Bitu mixmode, const uint32_t srcdata) {
+	switch ((mixmode >> 5) & 0x03) {
+		case 0x00: return xga.backcolor;
+		case 0x01: return xga.forecolor;
+		case 0x03: return srcdata;
+		default:   return -1;
+	}
+}
+
+/* Clipped span of one row, in pixels from the start of video memory. False if
+ * nothing of the row [x0,x1] at y is drawn. */
+template <typename T> static inline bool XGA_SpanClip(const Bits y, Bits x0, Bits x1, Bits &addr, Bitu &n) {
+	if (y < (Bits)xga.scissors.y1 || y > (Bits)xga.scissors.y2) return false;
+	if (x0 < (Bits)xga.scissors.x1) x0 = (Bits)xga.scissors.x1;
+	if (x1 > (Bits)xga.scissors.x2) x1 = (Bits)xga.scissors.x2;
+	if (x0 > x1) return false;
+
+	const Bits limit = (Bits)(vga.mem.memsize / sizeof(T));
+	addr = (y * (Bits)XGA_SCREEN_WIDTH) + x0;
+	Bits end = (y * (Bits)XGA_SCREEN_WIDTH) + x1;
+	if (end >= limit) end = limit - 1;
+	if (addr > end) return false;
+	n = (Bitu)(end - addr + 1);
+	return true;
+}
+
+/* source addresses from lo to hi (inclusive) all read from video memory */
+template <typename T> static inline bool XGA_SpanSourceValid(const Bits lo, const Bits hi) {
+	return lo >= 0 && hi < (Bits)(vga.mem.memsize / sizeof(T));
+}
+
+static inline bool XGA_SpansUsable(void) {
+	return (xga.curcommand & 0x1) && (xga.curcommand & 0x10);
+}
+
+template <typename T,uint32_t mask> static bool XGA_DrawRectangle_Spans(const Bits dx, const Bits dy) {
+	if ((xga.pix_cntl >> 6) & 0x3) return false;
+	const Bitu mixmode = xga.foremix;
+	const int64_t srcval = XGA_SpanMixSource(mixmode, 0);
+	if (srcval < 0 || ((mixmode >> 5) & 0x03) == 0x03) return false;
+
+	T *mem = (T*)vga.mem.linear;
+	const Bits x0 = (dx > 0) ? (Bits)xga.curx : (Bits)xga.curx - (Bits)xga.MAPcount;
+	Bits y = (Bits)xga.cury;
+	for (Bitu yat=0;yat <= xga.MIPcount;yat++,y += dy) {
+		Bits addr; Bitu n;
+		if (XGA_SpanClip<T>(y, x0, x0 + (Bits)xga.MAPcount, addr, n))
+			XGA_FillSpanMix<T,mask>(mem + addr, n, mixmode, (uint32_t)srcval);
+	}
+	return true;
+}
+
+template <typename T,uint32_t mask> static bool XGA_BlitRect_Spans(const Bits dx, const Bits dy, const Bitu mixselect, const Bitu mixmode) {
+	int64_t srcval = 0;
+	if (mixselect == 0x3) {
+		if (XGA_SpanMixSource(xga.foremix, 0) < 0 || XGA_SpanMixSource(xga.backmix, 0) < 0) return false;
+	}
+	else {
+		srcval = XGA_SpanMixSource(mixmode, 0);
+		if (srcval < 0) return false;
+	}
+
+	/* source of the clipped rectangle, in video memory as a whole or not handled here */
+	const Bits ox = (Bits)xga.curx - (Bits)xga.destx, oy = (Bits)xga.cury - (Bits)xga.desty;
+	const Bits x0 = (dx > 0) ? (Bits)xga.destx : (Bits)xga.destx - (Bits)xga.MAPcount;
+	const Bits y0 = (dy > 0) ? (Bits)xga.desty : (Bits)xga.desty - (Bits)xga.MIPcount;
+	const Bits cx0 = std::max(x0, (Bits)xga.scissors.x1), cx1 = std::min(x0 + (Bits)xga.MAPcount, (Bits)xga.scissors.x2);
+	const Bits cy0 = std::max(y0, (Bits)xga.scissors.y1), cy1 = std::min(y0 + (Bits)xga.MIPcount, (Bits)xga.scissors.y2);
+	if (cx0 > cx1 || cy0 > cy1) return true; /* nothing drawn */
+	if (!XGA_SpanSourceValid<T>(((cy0 + oy) * (Bits)XGA_SCREEN_WIDTH) + cx0 + ox, ((cy1 + oy) * (Bits)XGA_SCREEN_WIDTH) + cx1 + ox))
+		return false;
+
+	T *mem = (T*)vga.mem.linear;
+	Bits y = (Bits)xga.desty;
+	for (Bitu yat=0;yat <= xga.MIPcount;yat++,y += dy) {
+		Bits addr; Bitu n;
+		if (!XGA_SpanClip<T>(y, x0, x0 + (Bits)xga.MAPcount, addr, n)) continue;
+		T *dst = mem + addr;
+		const T *src = mem + addr + (oy * (Bits)XGA_SCREEN_WIDTH) + ox;
+
+		if (mixselect == 0x3) {
+			/* mix chosen by the source pixel */
+			for (Bitu c=0;c < n;c++) {
+				const Bitu i = (dx > 0) ? c : (n - 1 - c);
+				const uint32_t srcdata = src[i];
+				const Bitu mix = (srcdata == xga.forecolor) ? xga.foremix : ((srcdata == xga.backcolor) ? xga.backmix : 0x67);
+				dst[i] = (T)(XGA_GetMixResult(mix, (Bitu)XGA_SpanMixSource(mix, srcdata), dst[i]) & mask);
+			}
+			XGA_SpanDirty(dst, n);
+		}
+		else if (((mixmode >> 5) & 0x03) == 0x03) {
+			XGA_BlitSpanMix<T,mask>(dst, src, n, dx, (unsigned int)mixmode);
+		}
+		else {
+			XGA_FillSpanMix<T,mask>(dst, n, (unsigned int)mixmode, (uint32_t)srcval);
+		}
+	}
+	return true;
+}
+
+template <typename T,uint32_t mask> static bool XGA_DrawPattern_Spans(const Bits dx, const Bits dy, const Bitu mixselect, const Bitu mixmode) {
+	int64_t srcval = 0;
+	if (mixselect == 0x3) {
+		if (XGA_SpanMixSource(xga.foremix, 0) < 0 || XGA_SpanMixSource(xga.backmix, 0) < 0) return false;
+	}
+	else {
+		srcval = XGA_SpanMixSource(mixmode, 0);
+		if (srcval < 0) return false;
+	}
+
+	/* the 8x8 pattern at curx,cury */
+	const Bits pat = ((Bits)xga.cury * (Bits)XGA_SCREEN_WIDTH) + (Bits)xga.curx;
+	if (!XGA_SpanSourceValid<T>(pat, pat + (7 * (Bits)XGA_SCREEN_WIDTH) + 7))
+		return false;
+
+	T *mem = (T*)vga.mem.linear;
+	const Bits x0 = (dx > 0) ? (Bits)xga.destx : (Bits)xga.destx - (Bits)xga.MAPcount;
+	Bits y = (Bits)xga.desty;
+	for (Bitu yat=0;yat <= xga.MIPcount;yat++,y += dy) {
+		Bits addr; Bitu n;
+		if (!XGA_SpanClip<T>(y, x0, x0 + (Bits)xga.MAPcount, addr, n)) continue;
+		T *dst = mem + addr;
+		const T *prow = mem + pat + ((y & 7) * (Bits)XGA_SCREEN_WIDTH);
+		const Bitu px = (Bitu)(addr - (y * (Bits)XGA_SCREEN_WIDTH)); /* x of dst[0] */
+
+		if (mixselect == 0x3) {
+			for (Bitu c=0;c < n;c++) {
+				const Bitu i = (dx > 0) ? c : (n - 1 - c);
+				const uint32_t srcdata = prow[(px + i) & 7];
+				const Bitu mix = (srcdata == xga.backcolor || srcdata == 0) ? xga.backmix : xga.foremix;
+				dst[i] = (T)(XGA_GetMixResult(mix, (Bitu)XGA_SpanMixSource(mix, srcdata), dst[i]) & mask);
+			}
+			XGA_SpanDirty(dst, n);
+		}
+		else if (((mixmode >> 5) & 0x03) == 0x03) {
+			XGA_PatternSpanMix<T,mask>(dst, prow, px, n, dx, (unsigned int)mixmode);
+		}
+		else {
+			XGA_FillSpanMix<T,mask>(dst, n, (unsigned int)mixmode, (uint32_t)srcval);
+		}
+	}
+	return true;
+}
+
 void XGA_DrawLineVector(Bitu val) {
 	Bits xat, yat;
 	Bitu srcval;
@@ -474,6 +729,22 @@ void XGA_DrawRectangle(Bitu val) {
 	if(((val >> 5) & 0x01) != 0) dx = 1;
 	if(((val >> 7) & 0x01) != 0) dy = 1;
 
+	if (XGA_SpansUsable()) {
+		bool done = false;
+		switch (XGA_COLOR_MODE) {
+			case M_LIN8:  done = XGA_DrawRectangle_Spans<uint8_t,0xffu>(dx, dy); break;
+			case M_LIN15: done = XGA_DrawRectangle_Spans<uint16_t,0x7fffu>(dx, dy); break;
+			case M_LIN16: done = XGA_DrawRectangle_Spans<uint16_t,0xffffu>(dx, dy); break;
+			case M_LIN32: done = XGA_DrawRectangle_Spans<uint32_t,0xffffffffu>(dx, dy); break;
+			default: break;
+		}
+		if (done) {
+			xga.curx = (uint16_t)((Bits)xga.curx + dx * ((Bits)xga.MAPcount + 1));
+			xga.cury = (uint16_t)((Bits)xga.cury + dy * ((Bits)xga.MIPcount + 1));
+			return;
+		}
+	}
+
 	srcy = xga.cury;
 
 	for(yat=0;yat<=xga.MIPcount;yat++) {
@@ -767,6 +1038,17 @@ void XGA_BlitRect(Bitu val) {
 			break;
 	}
 
+	if (XGA_SpansUsable()) {
+		bool done = false;
+		switch (XGA_COLOR_MODE) {
+			case M_LIN8:  done = XGA_BlitRect_Spans<uint8_t,0xffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN15: done = XGA_BlitRect_Spans<uint16_t,0x7fffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN16: done = XGA_BlitRect_Spans<uint16_t,0xffffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN32: done = XGA_BlitRect_Spans<uint32_t,0xffffffffu>(dx, dy, mixselect, mixmode); break;
+			default: break;
+		}
+		if (done) return;
+	}
 
 	/* Copy source to video ram */
 	for(yat=0;yat<=xga.MIPcount ;yat++) {
@@ -860,6 +1142,18 @@ void XGA_DrawPattern(Bitu val) {
 			break;
 	}
 
+	if (XGA_SpansUsable()) {
+		bool done = false;
+		switch (XGA_COLOR_MODE) {
+			case M_LIN8:  done = XGA_DrawPattern_Spans<uint8_t,0xffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN15: done = XGA_DrawPattern_Spans<uint16_t,0x7fffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN16: done = XGA_DrawPattern_Spans<uint16_t,0xffffu>(dx, dy, mixselect, mixmode); break;
+			case M_LIN32: done = XGA_DrawPattern_Spans<uint32_t,0xffffffffu>(dx, dy, mixselect, mixmode); break;
+			default: break;
+		}
+		if (done) return;
+	}
+
 	for(yat=0;yat<=xga.MIPcount;yat++) {
 		Bits tarx = xga.destx;
 		for(xat=0;xat<=xga.MAPcount;xat++) {
@@ -221,6 +221,7 @@ typedef struct _fluid_cached_sampledata_t {
   time_t modification_time;
   int num_references;
   int mlock;
+  void* view;                /* the mapped view when the data was mapped, NULL if read */
 
   const short* sampledata;
   unsigned int samplesize;
@@ -246,11 +247,55 @@ static int fluid_get_file_modification_time(char *filename, time_t *modification
 #endif
 }
 
+/* Map the sample data of the file read only instead of reading it into the
+ * heap. Loading is then near instant, pages are only read in when a voice
+ * plays them, and they are shared with every other process that maps the same
+ * soundfont. The data is used in place, so this needs a little endian host and
+ * sample data that starts at an even offset. */
+static short* fluid_sampledata_map(const char *filename, unsigned int samplepos,
+  unsigned int samplesize, void **view)
+{
+  SYSTEM_INFO info;
+  LARGE_INTEGER filesize;
+  HANDLE file, mapping;
+  unsigned int offset;
+
+  *view = NULL;
+  if (FLUID_IS_BIG_ENDIAN || (samplepos & 1) || samplesize == 0)
+    return NULL;
+
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+  if (!GetFileSizeEx(file, &filesize) ||
+      filesize.QuadPart < (LONGLONG)samplepos + (LONGLONG)samplesize) {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  /* the view keeps the mapping and the file open */
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL)
+    return NULL;
+
+  GetSystemInfo(&info);
+  offset = samplepos - (samplepos % info.dwAllocationGranularity);
+  *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, offset, (SIZE_T)(samplepos - offset) + samplesize);
+  CloseHandle(mapping);
+  if (*view == NULL)
+    return NULL;
+
+  return (short*) ((char*) *view + (samplepos - offset));
+}
+
 static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
-  unsigned int samplesize, short **sampledata, int try_mlock)
+  unsigned int samplesize, short **sampledata, int try_mlock, int try_mmap, int *mapped)
 {
   fluid_file fd = NULL;
   short *loaded_sampledata = NULL;
+  void *view = NULL;
   fluid_cached_sampledata_t* cached_sampledata = NULL;
   time_t modification_time;
 
@@ -272,7 +317,7 @@ static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
       continue;
     }
 
-    if (try_mlock && !cached_sampledata->mlock) {
+    if (try_mlock && !cached_sampledata->mlock && cached_sampledata->view == NULL) {
       if (fluid_mlock(cached_sampledata->sampledata, samplesize) != 0)
         FLUID_LOG(FLUID_WARN, "Failed to pin the sample data to RAM; swapping is possible.");
       else
@@ -281,9 +326,17 @@ static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
 
     cached_sampledata->num_references++;
     loaded_sampledata = (short*) cached_sampledata->sampledata;
+    view = cached_sampledata->view;
     goto success_exit;
   }
 
+  if (try_mmap) {
+    loaded_sampledata = fluid_sampledata_map(filename, samplepos, samplesize, &view);
+    if (loaded_sampledata != NULL)
+      goto cache_entry;
+    FLUID_LOG(FLUID_WARN, "Can't map the sample data of the soundfont file, reading it instead");
+  }
+
   fd = FLUID_FOPEN(filename, "rb");
   if (fd == NULL) {
     FLUID_LOG(FLUID_ERR, "Can't open soundfont file");
@@ -310,16 +363,19 @@ static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
   fd = NULL;
 
 
+ cache_entry:
   cached_sampledata = (fluid_cached_sampledata_t*) FLUID_MALLOC(sizeof(fluid_cached_sampledata_t));
   if (cached_sampledata == NULL) {
     FLUID_LOG(FLUID_ERR, "Out of memory.");
     goto error_exit;
   }
+  cached_sampledata->view = view;
 
   /* Lock the memory to disable paging. It's okay if this fails. It
-     probably means that the user doesn't have to required permission.  */
+     probably means that the user doesn't have to required permission.
+     Locking a mapped file would read all of it, see fluid_defsfont_pin_samples() */
   cached_sampledata->mlock = 0;
-  if (try_mlock) {
+  if (try_mlock && view == NULL) {
     if (fluid_mlock(loaded_sampledata, samplesize) != 0)
       FLUID_LOG(FLUID_WARN, "Failed to pin the sample data to RAM; swapping is possible.");
     else
@@ -327,7 +383,7 @@ static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
   }
 
   /* If this machine is big endian, the sample have to byte swapped  */
-  if (FLUID_IS_BIG_ENDIAN) {
+  if (FLUID_IS_BIG_ENDIAN && view == NULL) {
     unsigned char* cbuf;
     unsigned char hi, lo;
     unsigned int i, j;
@@ -360,13 +416,16 @@ static int fluid_cached_sampledata_load(char *filename, unsigned int samplepos,
  success_exit:
   fluid_mutex_unlock(cached_sampledata_mutex);
   *sampledata = loaded_sampledata;
+  *mapped = (view != NULL);
   return FLUID_OK;
 
  error_exit:
   if (fd != NULL) {
     FLUID_FCLOSE(fd);
   }
-  if (loaded_sampledata != NULL) {
+  if (view != NULL) {
+    UnmapViewOfFile(view);
+  } else if (loaded_sampledata != NULL) {
     FLUID_FREE(loaded_sampledata);
   }
 
@@ -396,9 +455,13 @@ static int fluid_cached_sampledata_unload(const short *sampledata)
       cached_sampledata->num_references--;
 
       if (cached_sampledata->num_references == 0) {
-        if (cached_sampledata->mlock)
-          fluid_munlock(cached_sampledata->sampledata, cached_sampledata->samplesize);
-        FLUID_FREE((short*) cached_sampledata->sampledata);
+        if (cached_sampledata->view != NULL) {
+          UnmapViewOfFile(cached_sampledata->view);
+        } else {
+          if (cached_sampledata->mlock)
+            fluid_munlock(cached_sampledata->sampledata, cached_sampledata->samplesize);
+          FLUID_FREE((short*) cached_sampledata->sampledata);
+        }
         FLUID_FREE(cached_sampledata->filename);
 
         if (prev != NULL) {
@@ -457,7 +520,10 @@ fluid_defsfont_t* new_fluid_defsfont(fluid_settings_t* settings)
   sfont->sample = NULL;
   sfont->sampledata = NULL;
   sfont->preset = NULL;
+  sfont->mapped = 0;
   fluid_settings_getint(settings, "synth.lock-memory", &sfont->mlock);
+  fluid_settings_getint(settings, "synth.sample-mmap", &sfont->mmap);
+  fluid_settings_getint(settings, "synth.sample-pin-ms", &sfont->pin_ms);
 
   /* Initialise preset cache, so we don't have to call malloc on program changes.
      Usually, we have at most one preset per channel plus one temporarily used,
@@ -542,6 +608,8 @@ char* fluid_defsfont_get_name(fluid_defsfont_t* sfont)
 }
 
 
+static void fluid_defsfont_pin_samples(fluid_defsfont_t* sfont);
+
 /*
  * fluid_defsfont_load
  */
@@ -592,10 +660,16 @@ int fluid_defsfont_load(fluid_defsfont_t* sfont, const char* file)
     sfsample->fluid_sample = sample;
 
     fluid_defsfont_add_sample(sfont, sample);
-    fluid_voice_optimize_sample(sample);
+    /* the loop of a mapped sample is scanned when a voice first plays it,
+       scanning them all here would read in the whole file */
+    if (!sfont->mapped)
+      fluid_voice_optimize_sample(sample);
     p = fluid_list_next(p);
   }
 
+  if (sfont->mapped && sfont->pin_ms > 0)
+    fluid_defsfont_pin_samples(sfont);
+
   /* Load all the presets */
   p = sfdata->preset;
   while (p != NULL) {
@@ -672,7 +746,61 @@ int
 fluid_defsfont_load_sampledata(fluid_defsfont_t* sfont)
 {
   return fluid_cached_sampledata_load(sfont->filename, sfont->samplepos,
-    sfont->samplesize, &sfont->sampledata, sfont->mlock);
+    sfont->samplesize, &sfont->sampledata, sfont->mlock, sfont->mmap, &sfont->mapped);
+}
+
+/*
+ * fluid_defsfont_pin_samples
+ *
+ * Keep the first pin_ms milliseconds of every sample of a mapped soundfont in
+ * RAM, so a note-on never waits for the disk. The rest of a sample is read in
+ * while the voice plays the pinned part. If the pages can't be locked they are
+ * read in once and may be paged out again later.
+ */
+static void
+fluid_defsfont_pin_samples(fluid_defsfont_t* sfont)
+{
+  fluid_list_t *p;
+  fluid_sample_t* sample;
+  SIZE_T total = 0, min_ws, max_ws;
+  unsigned int frames;
+  int lock;
+
+  for (p = sfont->sample; p != NULL; p = fluid_list_next(p)) {
+    sample = (fluid_sample_t*) fluid_list_get(p);
+    if (!sample->valid) continue;
+    frames = (unsigned int) (((double) sample->samplerate * sfont->pin_ms) / 1000.0);
+    if (frames > sample->end - sample->start) frames = sample->end - sample->start;
+    total += frames * sizeof(short) + 2 * 4096;
+  }
+
+  /* locked pages count against the minimum working set */
+  lock = GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws) &&
+    SetProcessWorkingSetSize(GetCurrentProcess(), min_ws + total, max_ws + total);
+
+  for (p = sfont->sample; p != NULL; p = fluid_list_next(p)) {
+    const char* start;
+    SIZE_T bytes, i;
+    volatile char touch;
+
+    sample = (fluid_sample_t*) fluid_list_get(p);
+    if (!sample->valid) continue;
+    frames = (unsigned int) (((double) sample->samplerate * sfont->pin_ms) / 1000.0);
+    if (frames > sample->end - sample->start) frames = sample->end - sample->start;
+    if (frames == 0) continue;
+
+    start = (const char*) (sample->data + sample->start);
+    bytes = frames * sizeof(short);
+    if (lock && !VirtualLock((LPVOID) start, bytes)) {
+      FLUID_LOG(FLUID_WARN, "Failed to pin the start of the samples to RAM; paging them in once instead.");
+      lock = 0;
+    }
+    if (!lock) {
+      for (i = 0; i < bytes; i += 4096) touch = start[i];
+      touch = start[bytes - 1];
+      (void) touch;
+    }
+  }
 }
 
 /*
@@ -406,6 +406,9 @@ struct _fluid_defsfont_t
   fluid_list_t* sample;      /* the samples in this soundfont */
   fluid_defpreset_t* preset; /* the presets of this soundfont */
   int mlock;                 /* Should we try memlock (avoid swapping)? */
+  int mmap;                  /* Should we map the sample data instead of reading it? */
+  int mapped;                /* Is sampledata a read only view of the file? */
+  int pin_ms;                /* Milliseconds at the start of each mapped sample to keep in RAM */
 
   fluid_preset_t iter_preset;        /* preset interface used in the iteration */
   fluid_defpreset_t* iter_cur;       /* the current preset in the iteration */
@@ -275,6 +275,10 @@ fluid_voice_init(fluid_voice_t* voice, fluid_sample_t* sample,
   voice->has_noteoff = 0;
   UPDATE_RVOICE0(fluid_rvoice_reset);
 
+  /* samples of a mapped soundfont are scanned on first use, not when loading */
+  if (!sample->amplitude_that_reaches_noise_floor_is_valid)
+    fluid_voice_optimize_sample(sample);
+
   /* Increment the reference count of the sample to prevent the
      unloading of the soundfont while this voice is playing,
      once for us and once for the rvoice. */
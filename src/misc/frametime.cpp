@@ -0,0 +1,183 @@
+/*
+ *  Copyright (C) 2002-2020  The DOSBox Team
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "dosbox.h"
+#include "logging.h"
+#include "setup.h"
+#include "frametime.h"
+
+bool frametime_enabled = false;
+
+/* histogram bucket 0 counts frames where a stage took less than 1us, bucket b
+ * [2^(b-1),2^b) microseconds and the last one everything above that */
+#define FRAMETIME_BUCKETS       22
+#define FRAMETIME_MAX_DEPTH     32
+
+static const char *frametime_names[FRAMETIME_STAGES] = { "other", "cpu", "vga", "scaler", "output", "mixer" };
+
+static struct {
+    bool                title = false;
+    std::string         csv;
+    FRAMETIME_STAGE     stack[FRAMETIME_MAX_DEPTH] = {};
+    unsigned int        depth = 0;
+    FRAMETIME_STAGE     current = FRAMETIME_OTHER;
+    uint64_t            mark = 0;                       // ns, when the current stage was (re)entered
+    uint64_t            frame[FRAMETIME_STAGES] = {};   // ns spent in this frame
+    uint64_t            window[FRAMETIME_STAGES] = {};  // ns spent since the title was last updated
+    uint64_t            window_frames = 0;
+    uint64_t            total[FRAMETIME_STAGES] = {};
+    uint64_t            worst[FRAMETIME_STAGES] = {};
+    uint64_t            frames = 0;
+    uint64_t            histogram[FRAMETIME_STAGES][FRAMETIME_BUCKETS] = {};
+} frametime;
+
+static inline uint64_t FRAMETIME_Now(void) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* charge the time since the last switch to the current stage */
+static inline void FRAMETIME_Charge(void) {
+    const uint64_t now = FRAMETIME_Now();
+    frametime.frame[frametime.current] += now - frametime.mark;
+    frametime.mark = now;
+}
+
+void FRAMETIME_Enter(FRAMETIME_STAGE stage) {
+    FRAMETIME_Charge();
+    if (frametime.depth < FRAMETIME_MAX_DEPTH)
+        frametime.stack[frametime.depth] = frametime.current;
+    frametime.depth++;
+    frametime.current = stage;
+}
+
+void FRAMETIME_Leave(void) {
+    if (frametime.depth == 0)
+        return;
+    FRAMETIME_Charge();
+    if (--frametime.depth < FRAMETIME_MAX_DEPTH)
+        frametime.current = frametime.stack[frametime.depth];
+}
+
+void FRAMETIME_EndFrame(void) {
+    if (!frametime_enabled)
+        return;
+
+    FRAMETIME_Charge();
+    for (unsigned int s=0;s < FRAMETIME_STAGES;s++) {
+        const uint64_t ns = frametime.frame[s];
+        const uint64_t us = ns / 1000u;
+        unsigned int b = 0;
+
+        while (b < (FRAMETIME_BUCKETS-1) && (us >> b) != 0) b++;
+        frametime.histogram[s][b]++;
+
+        frametime.total[s] += ns;
+        frametime.window[s] += ns;
+        if (frametime.worst[s] < ns) frametime.worst[s] = ns;
+        frametime.frame[s] = 0;
+    }
+    frametime.frames++;
+    frametime.window_frames++;
+}
+
+const char *FRAMETIME_TitleText(void) {
+    static const char *short_names[FRAMETIME_STAGES] = { "oth", "cpu", "vga", "scl", "out", "mix" };
+    static char text[128] = {0};
+
+    if (!frametime_enabled || !frametime.title)
+        return NULL;
+
+    if (frametime.window_frames != 0) {
+        char *p = text;
+
+        p += sprintf(p,"ms/frame");
+        for (unsigned int s=FRAMETIME_CPU;s <= FRAMETIME_STAGES;s++) {
+            const unsigned int i = s % FRAMETIME_STAGES; /* "other" last */
+            p += sprintf(p," %s %.2f",short_names[i],
+                ((double)frametime.window[i] / 1000000.0) / frametime.window_frames);
+            frametime.window[i] = 0;
+        }
+        frametime.window_frames = 0;
+    }
+
+    return text;
+}
+
+static void FRAMETIME_WriteCSV(void) {
+    if (frametime.csv.empty() || frametime.frames == 0)
+        return;
+
+    FILE *fp = fopen(frametime.csv.c_str(),"w");
+    if (fp == NULL) {
+        LOG_MSG("Frame timing: cannot write %s",frametime.csv.c_str());
+        return;
+    }
+
+    fprintf(fp,"stage,frames,avg_us,max_us,lt1us");
+    for (unsigned int b=1;b < (FRAMETIME_BUCKETS-1);b++)
+        fprintf(fp,",lt%uus",1u << b);
+    fprintf(fp,",ge%uus\n",1u << (FRAMETIME_BUCKETS-2));
+
+    for (unsigned int s=0;s < FRAMETIME_STAGES;s++) {
+        fprintf(fp,"%s,%llu,%.3f,%.3f",frametime_names[s],
+            (unsigned long long)frametime.frames,
+            ((double)frametime.total[s] / 1000.0) / frametime.frames,
+            (double)frametime.worst[s] / 1000.0);
+        for (unsigned int b=0;b < FRAMETIME_BUCKETS;b++)
+            fprintf(fp,",%llu",(unsigned long long)frametime.histogram[s][b]);
+        fprintf(fp,"\n");
+    }
+
+    fclose(fp);
+    LOG_MSG("Frame timing: %llu frames written to %s",(unsigned long long)frametime.frames,frametime.csv.c_str());
+}
+
+static void FRAMETIME_ShutDown(Section* /*sec*/) {
+    FRAMETIME_WriteCSV();
+    frametime_enabled = false;
+}
+
+void FRAMETIME_Configure(bool title,const char *csv) {
+    static bool exit_added = false;
+    const bool was_enabled = frametime_enabled;
+
+    frametime.title = title;
+    frametime.csv = (csv != NULL) ? csv : "";
+    frametime_enabled = frametime.title || !frametime.csv.empty();
+
+    if (frametime_enabled && !was_enabled) {
+        /* scopes entered before this point are not timed, start at the bottom */
+        frametime.depth = 0;
+        frametime.current = FRAMETIME_OTHER;
+        frametime.mark = FRAMETIME_Now();
+        for (unsigned int s=0;s < FRAMETIME_STAGES;s++)
+            frametime.frame[s] = frametime.window[s] = 0;
+        frametime.window_frames = 0;
+    }
+
+    if (frametime_enabled && !exit_added) {
+        AddExitFunction(AddExitFunctionFuncPair(FRAMETIME_ShutDown));
+        exit_added = true;
+    }
+}
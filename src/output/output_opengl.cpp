@@ -53,6 +53,11 @@ PFNGLUNIFORM2FPROC glUniform2f = NULL;
 PFNGLUNIFORM1IPROC glUniform1i = NULL;
 PFNGLUSEPROGRAMPROC glUseProgram = NULL;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = NULL;
+PFNGLBUFFERSTORAGEPROC_NP glBufferStorage = NULL;
+PFNGLMAPBUFFERRANGEPROC_NP glMapBufferRange = NULL;
+PFNGLFENCESYNCPROC_NP glFenceSync = NULL;
+PFNGLCLIENTWAITSYNCPROC_NP glClientWaitSync = NULL;
+PFNGLDELETESYNCPROC_NP glDeleteSync = NULL;
 }
 
 /* "using" is meant to hide identical names declared in outer scope
@@ -77,6 +82,11 @@ PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = NULL;
 #define glUniform1i               gl2::glUniform1i
 #define glUseProgram              gl2::glUseProgram
 #define glVertexAttribPointer     gl2::glVertexAttribPointer
+#define glBufferStorage           gl2::glBufferStorage
+#define glMapBufferRange          gl2::glMapBufferRange
+#define glFenceSync               gl2::glFenceSync
+#define glClientWaitSync          gl2::glClientWaitSync
+#define glDeleteSync              gl2::glDeleteSync
 
 #if C_OPENGL && DOSBOXMENU_TYPE == DOSBOXMENU_SDLDRAW
 extern unsigned int SDLDrawGenFontTextureUnitPerRow;
@@ -94,6 +104,162 @@ int Voodoo_OGL_GetWidth();
 int Voodoo_OGL_GetHeight();
 bool Voodoo_OGL_Active();
 
+/* PBO streaming ([sdl] opengl_pbo)
+ *
+ * The renderer draws straight into a pixel buffer object and EndUpdate
+ * uploads only the changed lines from there to the texture, so
+ * glTexSubImage2D neither copies from client memory nor has to wait for the
+ * GPU. With buffer storage and sync objects three PBOs stay mapped for good
+ * and are used in turn: the GPU may still be uploading from the last two
+ * while the renderer draws into the next, and a fence tells when a PBO is
+ * free again. Since the scalers only write what changed, lines that changed
+ * in the PBOs drawn in between are copied over from the most recent PBO
+ * before the renderer gets it. Without buffer storage a single PBO is
+ * mapped and unmapped around every frame. */
+static const GLbitfield OPENGL_PBO_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+static void OPENGL_PBO_Free(void) {
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+    for (unsigned int i=0;i < sdl_opengl.pbo_count;i++) {
+        if (sdl_opengl.pbo_fence[i]) glDeleteSync(sdl_opengl.pbo_fence[i]);
+        sdl_opengl.pbo_fence[i] = NULL;
+        sdl_opengl.pbo_map[i] = NULL;
+        free(sdl_opengl.pbo_stale[i]);
+        sdl_opengl.pbo_stale[i] = NULL;
+    }
+    /* deleting a mapped buffer unmaps it */
+    if (sdl_opengl.pbo_count) glDeleteBuffersARB((GLsizei)sdl_opengl.pbo_count, sdl_opengl.pbo);
+    sdl_opengl.pbo_count = 0;
+    sdl_opengl.pbo_mapped = false;
+}
+
+/* forget PBOs that belonged to a previous context */
+static void OPENGL_PBO_Drop(void) {
+    for (unsigned int i=0;i < 3;i++) {
+        free(sdl_opengl.pbo_stale[i]);
+        sdl_opengl.pbo_stale[i] = NULL;
+        sdl_opengl.pbo_map[i] = NULL;
+        sdl_opengl.pbo_fence[i] = NULL;
+    }
+    sdl_opengl.pbo_count = 0;
+    sdl_opengl.pbo_mapped = false;
+    sdl_opengl.pixel_buffer_object = false;
+}
+
+static bool OPENGL_PBO_Alloc(Bitu size, Bitu lines) {
+    sdl_opengl.pbo_count = sdl_opengl.pbo_persistent ? 3u : 1u;
+    sdl_opengl.pbo_slot = 0;
+    sdl_opengl.pbo_mapped = false;
+    glGenBuffersARB((GLsizei)sdl_opengl.pbo_count, sdl_opengl.pbo);
+    for (unsigned int i=0;i < sdl_opengl.pbo_count;i++) {
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.pbo[i]);
+        if (sdl_opengl.pbo_persistent) {
+            /* client storage: the CPU reads lines back when bringing a PBO up to date */
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER_EXT, (GLsizeiptr)size, NULL, OPENGL_PBO_MapFlags | GL_CLIENT_STORAGE_BIT);
+            sdl_opengl.pbo_map[i] = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER_EXT, 0, (GLsizeiptr)size, OPENGL_PBO_MapFlags);
+            sdl_opengl.pbo_stale[i] = (uint8_t*)calloc(lines, 1);
+            if (sdl_opengl.pbo_map[i] == NULL || sdl_opengl.pbo_stale[i] == NULL) {
+                LOG_MSG("SDL:OPENGL:Can't map pixel buffer object, falling back to system memory");
+                OPENGL_PBO_Free();
+                return false;
+            }
+            memset(sdl_opengl.pbo_map[i], 0, size);
+        }
+        else {
+            glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_EXT, (GLsizeiptr)size, NULL, GL_STREAM_DRAW_ARB);
+        }
+    }
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+    return true;
+}
+
+static uint8_t *OPENGL_PBO_StartFrame(void) {
+    if (!sdl_opengl.pbo_persistent) {
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.pbo[0]);
+        uint8_t *pixels = (uint8_t *)glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, GL_WRITE_ONLY);
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+        sdl_opengl.pbo_mapped = (pixels != NULL);
+        return pixels;
+    }
+
+    const unsigned int last = sdl_opengl.pbo_slot;
+    const unsigned int next = (last + 1u) % sdl_opengl.pbo_count;
+
+    if (sdl_opengl.pbo_fence[next]) {
+        /* signalled long ago unless the GPU is two frames behind */
+        glClientWaitSync(sdl_opengl.pbo_fence[next], GL_SYNC_FLUSH_COMMANDS_BIT, (uint64_t)1000000000u);
+        glDeleteSync(sdl_opengl.pbo_fence[next]);
+        sdl_opengl.pbo_fence[next] = NULL;
+    }
+
+    uint8_t *stale = sdl_opengl.pbo_stale[next];
+    for (Bitu y=0;y < sdl.draw.height;y++) {
+        if (!stale[y]) continue;
+        Bitu n = 1;
+        while ((y+n) < sdl.draw.height && stale[y+n]) n++;
+        memcpy(sdl_opengl.pbo_map[next] + y * sdl_opengl.pitch, sdl_opengl.pbo_map[last] + y * sdl_opengl.pitch, n * sdl_opengl.pitch);
+        memset(stale + y, 0, n);
+        y += n - 1;
+    }
+
+    sdl_opengl.pbo_slot = next;
+    return sdl_opengl.pbo_map[next];
+}
+
+/* Upload the changed lines of the frame just drawn. Must be called for every
+ * StartFrame, even when nothing is drawn, to unmap or fence the PBO. */
+static void OPENGL_PBO_EndFrame(const uint16_t *changedLines) {
+    const unsigned int slot = sdl_opengl.pbo_slot;
+
+    if (!sdl_opengl.pbo_persistent) {
+        if (!sdl_opengl.pbo_mapped) return;
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.pbo[0]);
+        glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT);
+        sdl_opengl.pbo_mapped = false;
+    }
+    else {
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.pbo[slot]);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, sdl_opengl.texture);
+    if (changedLines) {
+        Bitu y = 0, index = 0;
+        while (y < sdl.draw.height) {
+            if (!(index & 1)) {
+                y += changedLines[index];
+            }
+            else {
+                const Bitu height = changedLines[index];
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (int)y,
+                    (int)sdl.draw.width, (int)height, GL_BGRA_EXT,
+#if defined (MACOSX) && !defined(C_SDL2)
+                    // needed for proper looking graphics on macOS 10.12, 10.13
+                    GL_UNSIGNED_INT_8_8_8_8,
+#else
+                    // works on Linux
+                    GL_UNSIGNED_INT_8_8_8_8_REV,
+#endif
+                    (void*)(uintptr_t)(y * sdl_opengl.pitch));
+                if (sdl_opengl.pbo_persistent) {
+                    for (unsigned int i=0;i < sdl_opengl.pbo_count;i++)
+                        if (i != slot) memset(sdl_opengl.pbo_stale[i] + y, 1, height);
+                }
+                y += height;
+            }
+            index++;
+        }
+    }
+    else if (sdl_opengl.pbo_persistent) {
+        /* aborted frame: whatever got drawn is only in this PBO */
+        for (unsigned int i=0;i < sdl_opengl.pbo_count;i++)
+            if (i != slot) memset(sdl_opengl.pbo_stale[i], 1, sdl.draw.height);
+    }
+
+    if (sdl_opengl.pbo_persistent)
+        sdl_opengl.pbo_fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+}
+
 static SDL_Surface* SetupSurfaceScaledOpenGL(uint32_t sdl_flags, uint32_t bpp) 
 {
     uint16_t fixedWidth;
@@ -268,6 +434,7 @@ void OUTPUT_OPENGL_Select()
 
     sdl_opengl.use_shader = false;
     initgl=0;
+    OPENGL_PBO_Drop();
 #if defined(C_SDL2)
     void GFX_SetResizeable(bool enable);
     GFX_SetResizeable(true);
@@ -321,20 +488,33 @@ void OUTPUT_OPENGL_Select()
         glBufferDataARB = (PFNGLBUFFERDATAARBPROC)SDL_GL_GetProcAddress("glBufferDataARB");
         glMapBufferARB = (PFNGLMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glMapBufferARB");
         glUnmapBufferARB = (PFNGLUNMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glUnmapBufferARB");
+        glBufferStorage = (PFNGLBUFFERSTORAGEPROC_NP)SDL_GL_GetProcAddress("glBufferStorage");
+        glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC_NP)SDL_GL_GetProcAddress("glMapBufferRange");
+        glFenceSync = (PFNGLFENCESYNCPROC_NP)SDL_GL_GetProcAddress("glFenceSync");
+        glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC_NP)SDL_GL_GetProcAddress("glClientWaitSync");
+        glDeleteSync = (PFNGLDELETESYNCPROC_NP)SDL_GL_GetProcAddress("glDeleteSync");
+        Section_prop* sec = static_cast<Section_prop*>(control->GetSection("sdl"));
+        const bool want_pbo = sec != NULL && sec->Get_bool("opengl_pbo");
         const char * gl_ext = (const char *)glGetString (GL_EXTENSIONS);
         if(gl_ext && *gl_ext){
             sdl_opengl.packed_pixel=(strstr(gl_ext,"EXT_packed_pixels") != NULL);
             sdl_opengl.paletted_texture=(strstr(gl_ext,"EXT_paletted_texture") != NULL);
-            //sdl_opengl.pixel_buffer_object=(strstr(gl_ext,"GL_ARB_pixel_buffer_object") != NULL ) && glGenBuffersARB && glBindBufferARB && glDeleteBuffersARB && glBufferDataARB && glMapBufferARB && glUnmapBufferARB;
+            sdl_opengl.pbo_stream=want_pbo && (strstr(gl_ext,"GL_ARB_pixel_buffer_object") != NULL ) && glGenBuffersARB && glBindBufferARB && glDeleteBuffersARB && glBufferDataARB && glMapBufferARB && glUnmapBufferARB;
+            sdl_opengl.pbo_persistent=sdl_opengl.pbo_stream && (strstr(gl_ext,"GL_ARB_buffer_storage") != NULL) && (strstr(gl_ext,"GL_ARB_sync") != NULL) &&
+                glBufferStorage && glMapBufferRange && glFenceSync && glClientWaitSync && glDeleteSync;
         } else {
             sdl_opengl.packed_pixel = false;
             sdl_opengl.paletted_texture = false;
-            //sdl_opengl.pixel_buffer_object = false;
+            sdl_opengl.pbo_stream = false;
+            sdl_opengl.pbo_persistent = false;
         }
 #ifdef DB_DISABLE_DBO
-        sdl_opengl.pixel_buffer_object = false;
+        sdl_opengl.pbo_stream = false;
+        sdl_opengl.pbo_persistent = false;
 #endif
-        //LOG_MSG("OpenGL extension: pixel_buffer_object %d",sdl_opengl.pixel_buffer_object);
+        if (want_pbo)
+            LOG_MSG("SDL:OPENGL:Pixel buffer object streaming: %s",
+                sdl_opengl.pbo_persistent ? "persistent mapped, 3 buffers" : (sdl_opengl.pbo_stream ? "mapped per frame" : "not supported"));
 	} /* OPENGL is requested end */
 }
 
@@ -430,8 +610,7 @@ Bitu OUTPUT_OPENGL_SetSize()
 
     if (sdl_opengl.pixel_buffer_object)
     {
-        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
-        if (sdl_opengl.buffer) glDeleteBuffersARB(1, &sdl_opengl.buffer);
+        OPENGL_PBO_Free();
     }
     else if (sdl_opengl.framebuf)
     {
@@ -594,18 +773,19 @@ Bitu OUTPUT_OPENGL_SetSize()
     }
 
     /* Create the texture and display list */
-    if (sdl_opengl.pixel_buffer_object) 
-    {
-        glGenBuffersARB(1, &sdl_opengl.buffer);
-        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.buffer);
-        glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_EXT, (int)(adjTexWidth*adjTexHeight * 4), NULL, GL_STREAM_DRAW_ARB);
-        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
-    }
-    else
+    sdl_opengl.pixel_buffer_object = sdl_opengl.pbo_stream;
+#if C_XBRZ
+    // xBRZ draws into its own render buffer and scales into the frame buffer from there
+    if (sdl_xbrz.enable && sdl_xbrz.scale_on)
+        sdl_opengl.pixel_buffer_object = false;
+#endif
+    sdl_opengl.pitch = adjTexWidth * 4;
+    if (sdl_opengl.pixel_buffer_object && !OPENGL_PBO_Alloc(adjTexWidth*adjTexHeight * 4, adjTexHeight))
+        sdl_opengl.pixel_buffer_object = false;
+    if (!sdl_opengl.pixel_buffer_object)
     {
         sdl_opengl.framebuf = calloc(adjTexWidth*adjTexHeight, 4); //32 bit color
     }
-    sdl_opengl.pitch = adjTexWidth * 4;
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -793,8 +973,9 @@ bool OUTPUT_OPENGL_StartUpdate(uint8_t* &pixels, Bitu &pitch)
     {
         if (sdl_opengl.pixel_buffer_object)
         {
-            glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, sdl_opengl.buffer);
-            pixels = (uint8_t *)glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, GL_WRITE_ONLY);
+            pixels = OPENGL_PBO_StartFrame();
+            if (pixels == NULL)
+                return false;
         }
         else
         {
@@ -809,6 +990,9 @@ bool OUTPUT_OPENGL_StartUpdate(uint8_t* &pixels, Bitu &pitch)
 
 void OUTPUT_OPENGL_EndUpdate(const uint16_t *changedLines)
 {
+    if (sdl_opengl.pixel_buffer_object)
+        OPENGL_PBO_EndFrame(changedLines);
+
     if (!(sdl.must_redraw_all && changedLines == NULL)) 
     {
         if (sdl_opengl.clear_countdown > 0)
@@ -890,24 +1074,11 @@ void OUTPUT_OPENGL_EndUpdate(const uint16_t *changedLines)
 #endif /*C_XBRZ*/
         if (sdl_opengl.pixel_buffer_object) 
         {
-            if (changedLines && (changedLines[0] == sdl.draw.height))
+            // changed lines were uploaded by OPENGL_PBO_EndFrame() above
+            if (changedLines == NULL || changedLines[0] == sdl.draw.height)
                 return;
 
-            glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT);
             glBindTexture(GL_TEXTURE_2D, sdl_opengl.texture);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
-                (int)sdl.draw.width, (int)sdl.draw.height, GL_BGRA_EXT,
-#if defined (MACOSX)
-                // needed for proper looking graphics on macOS 10.12, 10.13
-                GL_UNSIGNED_INT_8_8_8_8,
-#else
-                // works on Linux
-                GL_UNSIGNED_INT_8_8_8_8_REV,
-#endif
-                (void*)0);
-            glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
-            //glCallList(sdl_opengl.displaylist);
-            //SDL_GL_SwapBuffers();
         }
         else if (changedLines) 
         {
@@ -31,6 +31,32 @@ typedef GLvoid* (APIENTRYP PFNGLMAPBUFFERARBPROC) (GLenum target, GLenum access)
 typedef GLboolean(APIENTRYP PFNGLUNMAPBUFFERARBPROC) (GLenum target);
 #endif
 
+/* buffer storage, map range, sync objects and copy buffer (GL 3.0-4.4) for
+ * the persistently mapped PBO ring. _NP names for the same reason as below. */
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                   0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT              0x0040
+#define GL_MAP_COHERENT_BIT                0x0080
+#define GL_CLIENT_STORAGE_BIT              0x0200
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT                    0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE      0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT         0x00000001
+#define GL_TIMEOUT_EXPIRED                 0x911B
+#define GL_WAIT_FAILED                     0x911D
+#endif
+typedef struct __GLsync *GLsync_NP;
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC_NP) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void* (APIENTRYP PFNGLMAPBUFFERRANGEPROC_NP) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLsync_NP (APIENTRYP PFNGLFENCESYNCPROC_NP) (GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRYP PFNGLCLIENTWAITSYNCPROC_NP) (GLsync_NP sync, GLbitfield flags, uint64_t timeout);
+typedef void (APIENTRYP PFNGLDELETESYNCPROC_NP) (GLsync_NP sync);
+
 extern PFNGLGENBUFFERSARBPROC glGenBuffersARB;
 extern PFNGLBINDBUFFERARBPROC glBindBufferARB;
 extern PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB;
@@ -80,6 +106,15 @@ struct SDL_OpenGL {
     bool packed_pixel;
     bool paletted_texture;
     bool pixel_buffer_object;
+    bool pbo_stream;                /* [sdl] opengl_pbo and the driver supports PBOs */
+    bool pbo_persistent;            /* ...and buffer storage/sync, use a mapped ring */
+    unsigned int pbo_count;         /* PBOs in use: 3 when persistent, else 1 */
+    unsigned int pbo_slot;          /* PBO the renderer is (or was last) drawing into */
+    GLuint pbo[3];
+    uint8_t *pbo_map[3];            /* persistent mappings */
+    GLsync_NP pbo_fence[3];         /* signalled once the GPU is done reading a PBO */
+    uint8_t *pbo_stale[3];          /* per PBO, one byte per line that is older than in the last PBO */
+    bool pbo_mapped;                /* non-persistent PBO mapped between Start/EndUpdate */
     int menudraw_countdown;
     int clear_countdown;
     bool use_shader;